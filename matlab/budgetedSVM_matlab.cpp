@@ -632,23 +632,19 @@ void budgetedModelMatlabBSGD::saveToMatlabStruct(mxArray *plhs[], vector <int>*
 	int irIndex, nonZeroElement;
 	mwIndex *ir, *jc;
 	
+	vector <unsigned int> nonZeroIndices;
+	vector <float> nonZeroValues;
+	
 	// find how many non-zero elements there are
 	nonZeroElement = 0;
 	for (i = 0; i < (*modelBSGD).size(); i++) 
 	{
 		// count non-zero features
-		for (j = 0; j < (*param).DIMENSION; j++)
-		{
-			if ((*((*modelBSGD)[i]))[j] != 0.0)
-				nonZeroElement++;
-		}
+		(*modelBSGD)[i]->getNonZeroElements(&nonZeroIndices, &nonZeroValues);
+		nonZeroElement += (int) nonZeroIndices.size();
 		
 		// count non-zero alphas also
-		for (j = 0; j < (*yLabels).size(); j++)
-		{
-			if ((*((*modelBSGD)[i])).alphas[j] != 0.0)
-				nonZeroElement++;
-		}
+		nonZeroElement += (int) (*modelBSGD)[i]->getNumNonZeroAlphas();
 	}
 
 	//  +(*yLabels).size() is for the alpha parameters of each BSGD weight
@@ -662,25 +658,20 @@ void budgetedModelMatlabBSGD::saveToMatlabStruct(mxArray *plhs[], vector <int>*
 		int xIndex = 0;
 		
 		// this adds alpha weights to the beginning of a vector, more compact
-		for (j = 0; j < (*yLabels).size(); j++)
+		for (j = 0; j < (*modelBSGD)[i]->getNumNonZeroAlphas(); j++)
 		{
-			if ((*((*modelBSGD)[i])).alphas[j] != 0.0)
-			{
-				ir[irIndex] = j; 
-				ptr[irIndex] = (*((*modelBSGD)[i])).alphas[j];
-				irIndex++, xIndex++;
-			}
+			ir[irIndex] = (*modelBSGD)[i]->getAlphaClass(j); 
+			ptr[irIndex] = (*modelBSGD)[i]->getAlphaValue(j);
+			irIndex++, xIndex++;
 		}
 		
 		// add the actual features
-		for (j = 0; j < (*param).DIMENSION; j++)              // for every feature
+		(*modelBSGD)[i]->getNonZeroElements(&nonZeroIndices, &nonZeroValues);
+		for (j = 0; j < nonZeroIndices.size(); j++)              // for every non-zero feature
 		{
-			if ((*((*modelBSGD)[i]))[j] != 0.0)
-			{
-				ir[irIndex] = j + (*yLabels).size();		// shift it to accomodate alpha weights
-				ptr[irIndex] = (*((*modelBSGD)[i]))[j];
-				irIndex++, xIndex++;
-			}
+			ir[irIndex] = nonZeroIndices[j] + (*yLabels).size();		// shift it to accomodate alpha weights
+			ptr[irIndex] = nonZeroValues[j];
+			irIndex++, xIndex++;
 		}
 		jc[cnt + 1] = jc[cnt] + xIndex;
 		cnt++;
@@ -792,8 +783,16 @@ bool budgetedModelMatlabBSGD::loadFromMatlabStruct(const mxArray *matlabStruct,
 	currClass = classCounter = 0;
 	for (i = 0; i < sr; i++)
 	{
-		int low = (int)jc[i], high = (int)jc[i + 1];			
-		budgetedVectorBSGD *eNew = new budgetedVectorBSGD((*param).DIMENSION, (*param).CHUNK_WEIGHT, numClasses);
+		int low = (int)jc[i], high = (int)jc[i + 1];
+		
+		// count non-zero features to decide how to store the support vector
+		unsigned int numNonZeroFeatures = 0;
+		for (j = low; j < high; j++)
+		{
+			if ((unsigned int)ir[j] >= (*yLabels).size())
+				numNonZeroFeatures++;
+		}
+		budgetedVectorBSGD *eNew = new budgetedVectorBSGD((*param).DIMENSION, (*param).CHUNK_WEIGHT, numClasses, budgetedVectorBSGD::useSparseStorage(numNonZeroFeatures, (*param).DIMENSION));
 		sqrNorm = 0.0;
 		
 		for (j = low; j < high; j++)
@@ -801,12 +800,12 @@ bool budgetedModelMatlabBSGD::loadFromMatlabStruct(const mxArray *matlabStruct,
 			if ((unsigned int)ir[j] < (*yLabels).size())
 			{
 				// get alpha values
-				eNew->alphas[(int)ir[j]] = ptr[j];
+				eNew->setAlpha((unsigned int) ir[j], ptr[j]);
 			}
 			else
 			{
 				// get features
-				((*eNew)[(int)ir[j] - (int) (*yLabels).size()]) = (float)ptr[j];
+				eNew->setElement((unsigned int) ir[j] - (unsigned int) (*yLabels).size(), (float)ptr[j]);
 				sqrNorm += (ptr[j] * ptr[j]);
 			}
 		}
@@ -828,7 +827,8 @@ bool budgetedModelMatlabBSGD::loadFromMatlabStruct(const mxArray *matlabStruct,
 */
 void budgetedModelMatlabLLSVM::saveToMatlabStruct(mxArray *plhs[], vector <int>* yLabels, parameters *param)
 {
-	unsigned int i, j, numWeights = 0, cnt;
+	unsigned int i, j, k, numWeights = 0, cnt, offset, numClassifiers = (unsigned int) modelLLSVMcoefficients.cols();
+	bool storeMatrixW;
 	double *ptr;
 	mxArray *returnModel, **rhs;
 	int outID = 0;
@@ -901,6 +901,11 @@ void budgetedModelMatlabLLSVM::saveToMatlabStruct(mxArray *plhs[], vector <int>*
 	int irIndex, nonZeroElement;
 	mwIndex *ir, *jc;
 	
+	// the coefficients of each landmark point are always stored, and the linear SVM weights and the row of modelLLSVMmatrixW only if requested; there is one coefficient
+	//	and one linear SVM weight for each linear classifier
+	storeMatrixW = ((*param).STORE_MATRIX_W) && ((unsigned int) modelLLSVMmatrixW.rows() == numWeights);
+	offset = storeMatrixW ? (numWeights + 2 * numClassifiers) : numClassifiers;
+	
 	// find how many non-zero elements there are
 	nonZeroElement = 0;
 	for (i = 0; i < (*modelLLSVMlandmarks).size(); i++) 
@@ -912,15 +917,11 @@ void budgetedModelMatlabLLSVM::saveToMatlabStruct(mxArray *plhs[], vector <int>*
 				nonZeroElement++;
 		}
 		
-		// count all elements of modelLLSVMmatrixW also
-		nonZeroElement += (numWeights * numWeights);
-		
-		// count linear SVM length also
-		nonZeroElement += numWeights;
+		// count the coefficients, the linear SVM weights and the row of modelLLSVMmatrixW also
+		nonZeroElement += offset;
 	}
-
-	//  +(*yLabels).size() is for the alpha parameters of each BSGD weight
-	rhs[outID] = mxCreateSparse(param->DIMENSION + numWeights + 1, numWeights, nonZeroElement, mxREAL);
+	
+	rhs[outID] = mxCreateSparse(param->DIMENSION + offset, numWeights, nonZeroElement, mxREAL);
 	ir = mxGetIr(rhs[outID]);
 	jc = mxGetJc(rhs[outID]);
 	ptr = mxGetPr(rhs[outID]);
@@ -929,25 +930,38 @@ void budgetedModelMatlabLLSVM::saveToMatlabStruct(mxArray *plhs[], vector <int>*
 	{
 		int xIndex = 0;
 		
-		// this adds alpha weights to the beginning of a vector, more compact
-		ir[irIndex] = 0; 
-		ptr[irIndex] = modelLLSVMweightVector(i, 0);
-		irIndex++, xIndex++;
-		
-		// this adds row of modelLLSVMmatrixW next, more compact
-		for (j = 0; j < numWeights; j++)
+		// this adds the coefficients of the landmark point to the beginning of a vector
+		for (k = 0; k < numClassifiers; k++)
 		{
-			ir[irIndex] = j + 1;		// shift it to accomodate linear weight
-			ptr[irIndex] = modelLLSVMmatrixW(i, j);
+			ir[irIndex] = k; 
+			ptr[irIndex] = modelLLSVMcoefficients(i, k);
 			irIndex++, xIndex++;
 		}
 		
+		if (storeMatrixW)
+		{
+			// this adds the linear weights and row of modelLLSVMmatrixW next, more compact; if the data was mapped to a lower-dimensional space, both are
+			//	padded with zeros to BUDGET_SIZE dimensions
+			for (k = 0; k < numClassifiers; k++)
+			{
+				ir[irIndex] = numClassifiers + k; 
+				ptr[irIndex] = (i < (unsigned int) modelLLSVMweights.rows()) ? modelLLSVMweights(i, k) : 0.0;
+				irIndex++, xIndex++;
+			}
+			for (j = 0; j < numWeights; j++)
+			{
+				ir[irIndex] = j + 2 * numClassifiers;		// shift it to accomodate the coefficients and linear weights
+				ptr[irIndex] = (j < (unsigned int) modelLLSVMmatrixW.cols()) ? modelLLSVMmatrixW(i, j) : 0.0;
+				irIndex++, xIndex++;
+			}
+		}
+		
 		// add the actual features
 		for (j = 0; j < (*param).DIMENSION; j++)
 		{
 			if ((*((*modelLLSVMlandmarks)[i]))[j] != 0.0)
 			{
-				ir[irIndex] = j + numWeights + 1;		// shift it to accomodate linear weight and modelLLSVMmatrixW
+				ir[irIndex] = j + offset;		// shift it to accomodate the coefficient, linear weight and modelLLSVMmatrixW
 				ptr[irIndex] = (*((*modelLLSVMlandmarks)[i]))[j];
 				irIndex++, xIndex++;
 			}
@@ -977,7 +991,7 @@ void budgetedModelMatlabLLSVM::saveToMatlabStruct(mxArray *plhs[], vector <int>*
 */
 bool budgetedModelMatlabLLSVM::loadFromMatlabStruct(const mxArray *matlabStruct, vector <int>* yLabels, parameters *param, const char **msg)
 {
-	unsigned int i, j, numOfFields, numClasses;
+	unsigned int i, j, k, numOfFields, numClasses, numClassifiers;
 	double *ptr, sqrNorm;
 	int id = 0;
 	mxArray **rhs;
@@ -1006,6 +1020,7 @@ bool budgetedModelMatlabLLSVM::loadFromMatlabStruct(const mxArray *matlabStruct,
 	// numClasses
 	ptr = mxGetPr(rhs[id]);
 	numClasses = (unsigned int)ptr[0];
+	numClassifiers = getNumClassifiers(numClasses);
 	id++;
 	
 	// labels
@@ -1058,9 +1073,22 @@ bool budgetedModelMatlabLLSVM::loadFromMatlabStruct(const mxArray *matlabStruct,
 	ir = mxGetIr(rhs[id]);
 	jc = mxGetJc(rhs[id]);
 	
+	// the layout of the model is found from the number of its rows: the earlier versions of the toolbox stored the linear weight and the row of modelLLSVMmatrixW
+	//	of each landmark point of a binary model, and the current version stores the coefficients of the landmark point, one per linear classifier, followed by the 
+	//	linear weights and the row of modelLLSVMmatrixW if requested
+	unsigned int offset, matrixStart;
+	bool isOldVersion = (numClassifiers == 1) && (sc == (*param).DIMENSION + (*param).BUDGET_SIZE + 1);
+	param->STORE_MATRIX_W = isOldVersion || (sc == (*param).DIMENSION + (*param).BUDGET_SIZE + 2 * numClassifiers);
+	offset = isOldVersion ? ((*param).BUDGET_SIZE + 1) : ((*param).STORE_MATRIX_W ? ((*param).BUDGET_SIZE + 2 * numClassifiers) : numClassifiers);
+	matrixStart = isOldVersion ? 0 : numClassifiers;
+	
 	// allocate memory for model
-	modelLLSVMmatrixW.resize((*param).BUDGET_SIZE, (*param).BUDGET_SIZE);
-	modelLLSVMweightVector.resize((*param).BUDGET_SIZE, 1);
+	if ((*param).STORE_MATRIX_W)
+	{
+		modelLLSVMmatrixW.resize((*param).BUDGET_SIZE, (*param).BUDGET_SIZE);
+		modelLLSVMweights.resize((*param).BUDGET_SIZE, numClassifiers);
+	}
+	modelLLSVMcoefficients.resize((*param).BUDGET_SIZE, numClassifiers);
 	
 	// weight-vectors are in columns
 	for (i = 0; i < sr; i++)
@@ -1069,17 +1097,28 @@ bool budgetedModelMatlabLLSVM::loadFromMatlabStruct(const mxArray *matlabStruct,
 		budgetedVectorLLSVM *eNew = new budgetedVectorLLSVM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
 		sqrNorm = 0.0;
 		
-		// get the linear weight
-		modelLLSVMweightVector(i, 0) = ptr[low];
+		// get the coefficients
+		if (!isOldVersion)
+		{
+			for (k = 0; k < numClassifiers; k++)
+				modelLLSVMcoefficients(i, k) = ptr[low + k];
+		}
 		
-		// get the modelLLSVMmatrixW
-		for (j = low + 1; j < low + (*param).BUDGET_SIZE + 1; j++)
-			modelLLSVMmatrixW(i, j - low - 1) = ptr[j];
+		if ((*param).STORE_MATRIX_W)
+		{
+			// get the linear weights
+			for (k = 0; k < numClassifiers; k++)
+				modelLLSVMweights(i, k) = ptr[low + matrixStart + k];
+			
+			// get the modelLLSVMmatrixW
+			for (j = low + matrixStart + numClassifiers; j < low + matrixStart + numClassifiers + (*param).BUDGET_SIZE; j++)
+				modelLLSVMmatrixW(i, j - low - matrixStart - numClassifiers) = ptr[j];
+		}
 		
 		// get the features
-		for (j = low + (*param).BUDGET_SIZE + 1; j < high; j++)
+		for (j = low + offset; j < high; j++)
 		{
-			((*eNew)[(int)ir[j] - (*param).BUDGET_SIZE - 1]) = (float)ptr[j];
+			((*eNew)[(int)ir[j] - offset]) = (float)ptr[j];
 			sqrNorm += (ptr[j] * ptr[j]);
 		}
 		eNew->setSqrL2norm(sqrNorm);
@@ -1088,6 +1127,9 @@ bool budgetedModelMatlabLLSVM::loadFromMatlabStruct(const mxArray *matlabStruct,
 	}
 	id++;
 	
+	if (isOldVersion)
+		computeCoefficients();
+	
 	mxFree(rhs);
 	return true;
 }
@@ -1173,8 +1215,35 @@ void printUsageMatlab(bool trainingPhase, parameters *param)
 		mexPrintf("\t i - polynomial or sigmoid kernel intercept (LLSVM, BSGD; %.2f)\n", (*param).KERNEL_COEF_PARAM);		
 		mexPrintf("\t m - budget maintenance in BSGD (0 - removal; 1 - merging, uses Gaussian kernel), OR\n");
 		mexPrintf("\t\t     landmark sampling strategy in LLSVM (0 - random; 1 - k-means; 2 - k-medoids) (%d)\n", (*param).MAINTENANCE_SAMPLING_STRATEGY);
+		mexPrintf("\t Q - maximum number of members of a cluster among which k-medoids searches for the new medoid,\n");
+		mexPrintf("\t\t     where 0 means all members (LLSVM; %d)\n", (*param).MEDOID_SAMPLE_SIZE);
+		mexPrintf("\t R - number of points sampled from the entire training file to select landmark points from,\n");
+		mexPrintf("\t\t     where 0 means the first data chunk is used (LLSVM; %d)\n", (*param).LANDMARK_RESERVOIR_SIZE);
+		mexPrintf("\t W - if set to 1, the model also stores the BxB transformation matrix, otherwise only the\n");
+		mexPrintf("\t\t     coefficients of the landmark points are stored (LLSVM; %d)\n", (*param).STORE_MATRIX_W);
+		mexPrintf("\t l - rank of the approximation of the landmark kernel matrix found by randomized eigensolver,\n");
+		mexPrintf("\t\t     where 0 means exact eigendecomposition (LLSVM; %d)\n", (*param).NYSTROM_RANK);
+		mexPrintf("\t O - oversampling of the randomized eigensolver (LLSVM; %d)\n", (*param).NYSTROM_OVERSAMPLING);
+		mexPrintf("\t f - if set to 1, the mapped training data is kept in single precision, which halves the memory\n");
+		mexPrintf("\t\t     needed for a data chunk (LLSVM; %d)\n", (*param).FLOAT_MAPPED_DATA);
+		mexPrintf("\t X - if set to 1, the mapped data chunks are stored to a temporary file and linear SVM is trained\n");
+		mexPrintf("\t\t     over all of them, otherwise chunk by chunk (LLSVM; %d)\n", (*param).OUT_OF_CORE_TRAINING);
+		mexPrintf("\t E - budget slack in BSGD with removal strategy, number of SVs allowed over the budget\n");
+		mexPrintf("\t\t     before one removal pass brings their number back to the budget size (%d)\n", (*param).BUDGET_SLACK);
 		mexPrintf("\t C - clone probability when misclassification occurs in AMM (%d)\n", (*param).CLONE_PROBABILITY);
-		mexPrintf("\t y - clone probability decay when weight cloning occurs in AMM (%.2f)\n\n", (*param).CLONE_PROBABILITY_DECAY);
+		mexPrintf("\t y - clone probability decay when weight cloning occurs in AMM (%.2f)\n", (*param).CLONE_PROBABILITY_DECAY);
+		mexPrintf("\t p - minimum number of weights for which AMM scores the weights in parallel (%d)\n", (*param).PARALLEL_SCORING_MIN);
+		mexPrintf("\t N - number of updates of the norm of an AMM weight after which the norm is recomputed before\n");
+		mexPrintf("\t\t     pruning, where 0 means never (%d)\n", (*param).NORM_RESYNC_INTERVAL);
+		mexPrintf("\t M - mini-batch size, number of examples processed together in a single update,\n");
+		mexPrintf("\t\t     where 1 means one example at a time (Pegasos, AMM online; %d)\n", (*param).MINI_BATCH_SIZE);
+		mexPrintf("\t P - if set to 1, the examples of a mini-batch are scored using a packed weight matrix built\n");
+		mexPrintf("\t\t     once per mini-batch, which takes DIMENSION x NUMBER_OF_WEIGHTS floats of memory (Pegasos, AMM online; %d)\n", (*param).PACKED_WEIGHTS);
+		mexPrintf("\t H - if set to 1, T threads concurrently process the training examples, where Pegasos threads update\n");
+		mexPrintf("\t\t     the shared weights without locking, and AMM online threads train their own models that are\n");
+		mexPrintf("\t\t     averaged (Pegasos, AMM online; %d)\n", (*param).PARALLEL_TRAINING);
+		mexPrintf("\t F - number of examples after which the models of the threads of parallel AMM online are averaged,\n");
+		mexPrintf("\t\t     where 0 means once per data chunk (%d)\n\n", (*param).SYNC_INTERVAL);
 		
 		mexPrintf("\t z - training and test file are loaded in chunks so that the algorithm can \n");
 		mexPrintf("\t\t     handle budget files on weaker computers; z specifies number of examples loaded in\n");
@@ -1186,6 +1255,8 @@ void printUsageMatlab(bool trainingPhase, parameters *param)
 		mexPrintf("\t\t     speed up kernel computations (default is 1 when percentage of non-zero\n");
 		mexPrintf("\t\t     features is less than 5%%, and 0 when percentage is larger than 5%%)\n");
 		mexPrintf("\t r - randomize the algorithms; 1 to randomize, 0 not to randomize (%d)\n", (*param).RANDOMIZE);
+		mexPrintf("\t T - number of threads used by the parallelized parts of the algorithms, 0 to use all\n");
+		mexPrintf("\t\t     available cores; requires compilation with OpenMP (%d)\n", (*param).NUM_THREADS);
 		mexPrintf("\t v - verbose output: 1 to show the algorithm steps (epoch ended, training started, ...), 0 for quiet mode (%d)\n", (*param).VERBOSE);
 		mexPrintf("\t--------------------------------------------\n");
 		mexPrintf("\tInstructions on how to convert data to and from the LIBSVM format can be found on <a href=\"http://www.csie.ntu.edu.tw/~cjlin/libsvm/\">LIBSVM website</a>.\n");
@@ -1232,6 +1303,8 @@ void printUsageMatlab(bool trainingPhase, parameters *param)
 		mexPrintf("\tS - if set to 1 data is assumed sparse, if 0 data is assumed non-sparse, used to\n");
 		mexPrintf("\t\t    speed up kernel computations (default is 1 when percentage of non-zero\n");
 		mexPrintf("\t\t    features is less than 5%%, and 0 when percentage is larger than 5%%)\n");
+		mexPrintf("\tP - if set to 1, AMM and Pegasos scores are computed using a packed weight matrix,\n");
+		mexPrintf("\t\t    which is faster but takes DIMENSION x NUMBER_OF_WEIGHTS floats of memory (%d)\n", (*param).PACKED_WEIGHTS);
 		mexPrintf("\tv - verbose output: 1 to show algorithm steps, 0 for quiet mode (%d)\n", (*param).VERBOSE);
 		mexPrintf("\t--------------------------------------------\n");
 		mexPrintf("\tInstructions on how to convert data to and from the LIBSVM format can be found on <a href=\"http://www.csie.ntu.edu.tw/~cjlin/libsvm/\">LIBSVM website</a>.\n");		
@@ -1373,6 +1446,63 @@ void parseInputMatlab(parameters *param, const char *paramString, bool trainingP
 					(*param).MAINTENANCE_SAMPLING_STRATEGY = (unsigned int) value[i];
 					break;  
 				
+				case 'Q':
+					if (value[i] < 0.0)
+					{
+						sprintf(str, "Input parameter '-Q' should be a non-negative integer!\nRun 'budgetedsvm_train()' for help.");
+						mexErrMsgTxt(str);
+					}
+					(*param).MEDOID_SAMPLE_SIZE = (unsigned int) value[i];
+					break;
+				
+				case 'R':
+					if (value[i] < 0.0)
+					{
+						sprintf(str, "Input parameter '-R' should be a non-negative integer!\nRun 'budgetedsvm_train()' for help.");
+						mexErrMsgTxt(str);
+					}
+					(*param).LANDMARK_RESERVOIR_SIZE = (unsigned int) value[i];
+					break;
+				
+				case 'W':
+					(*param).STORE_MATRIX_W = (value[i] != 0);
+					break;
+				
+				case 'l':
+					if (value[i] < 0.0)
+					{
+						sprintf(str, "Input parameter '-l' should be a non-negative integer!\nRun 'budgetedsvm_train()' for help.");
+						mexErrMsgTxt(str);
+					}
+					(*param).NYSTROM_RANK = (unsigned int) value[i];
+					break;
+				
+				case 'O':
+					if (value[i] < 0.0)
+					{
+						sprintf(str, "Input parameter '-O' should be a non-negative integer!\nRun 'budgetedsvm_train()' for help.");
+						mexErrMsgTxt(str);
+					}
+					(*param).NYSTROM_OVERSAMPLING = (unsigned int) value[i];
+					break;
+				
+				case 'f':
+					(*param).FLOAT_MAPPED_DATA = (value[i] != 0);
+					break;
+				
+				case 'X':
+					(*param).OUT_OF_CORE_TRAINING = (value[i] != 0);
+					break;
+				
+				case 'E':
+					if (value[i] < 0.0)
+					{
+						sprintf(str, "Input parameter '-E' should be a non-negative integer!\nRun 'budgetedsvm_train()' for help.");
+						mexErrMsgTxt(str);
+					}
+					(*param).BUDGET_SLACK = (unsigned int) value[i];
+					break;
+				
 				case 'b':
 					(*param).BIAS_TERM = (double) value[i];
 					break;
@@ -1436,6 +1566,53 @@ void parseInputMatlab(parameters *param, const char *paramString, bool trainingP
 					else if ((*param).CLONE_PROBABILITY_DECAY > 1)
 						(*param).CLONE_PROBABILITY_DECAY = 1;
 					break;
+				
+				case 'M':
+					if (value[i] < 1.0)
+					{
+						sprintf(str, "Input parameter '-M' should be a positive integer!\nRun 'budgetedsvm_train()' for help.");
+						mexErrMsgTxt(str);
+					}
+					(*param).MINI_BATCH_SIZE = (unsigned int) value[i];
+					break;
+				case 'P':
+					(*param).PACKED_WEIGHTS = (value[i] != 0);
+					break;
+				case 'H':
+					(*param).PARALLEL_TRAINING = (value[i] != 0);
+					break;
+				case 'F':
+					if (value[i] < 0.0)
+					{
+						sprintf(str, "Input parameter '-F' should be a non-negative integer!\nRun 'budgetedsvm_train()' for help.");
+						mexErrMsgTxt(str);
+					}
+					(*param).SYNC_INTERVAL = (unsigned int) value[i];
+					break;
+				case 'T':
+					if (value[i] < 0.0)
+					{
+						sprintf(str, "Input parameter '-T' should be a non-negative integer!\nRun 'budgetedsvm_train()' for help.");
+						mexErrMsgTxt(str);
+					}
+					(*param).NUM_THREADS = (unsigned int) value[i];
+					break;
+				case 'p':
+					if (value[i] < 0.0)
+					{
+						sprintf(str, "Input parameter '-p' should be a non-negative integer!\nRun 'budgetedsvm_train()' for help.");
+						mexErrMsgTxt(str);
+					}
+					(*param).PARALLEL_SCORING_MIN = (unsigned int) value[i];
+					break;
+				case 'N':
+					if (value[i] < 0.0)
+					{
+						sprintf(str, "Input parameter '-N' should be a non-negative integer!\nRun 'budgetedsvm_train()' for help.");
+						mexErrMsgTxt(str);
+					}
+					(*param).NORM_RESYNC_INTERVAL = (unsigned int) value[i];
+					break;
 
 				default:
 					sprintf(str, "Error, unknown input parameter '-%c'!\nRun 'budgetedsvm_train()' for help.", option[i]);
@@ -1444,6 +1621,13 @@ void parseInputMatlab(parameters *param, const char *paramString, bool trainingP
 			}
 		}
 		
+		// the threads of parallel training update the weights one example at a time, which cannot be combined with mini-batches
+		if (((*param).PARALLEL_TRAINING) && ((*param).MINI_BATCH_SIZE > 1))
+		{
+			sprintf(str, "Error, parallel training cannot be combined with mini-batches, set either '-H' to 0 or '-M' to 1!\nRun 'budgetedsvm_train()' for help.");
+			mexErrMsgTxt(str);
+		}
+		
 		// for BSGD, when we use merging budget maintenance strategy then only Gaussian kernel can be used,
 		//	due to the nature of merging; here check if user specified some other kernel while merging
 		if (((*param).ALGORITHM == BSGD) && ((*param).KERNEL != KERNEL_FUNC_GAUSSIAN) && ((*param).MAINTENANCE_SAMPLING_STRATEGY == BUDGET_MAINTAIN_MERGE))
@@ -1452,6 +1636,14 @@ void parseInputMatlab(parameters *param, const char *paramString, bool trainingP
 			(*param).KERNEL = KERNEL_FUNC_GAUSSIAN;
 		}
 		
+		// the budget slack only pays off with removal, where the removal scores are shared by the whole pass; each merge searches the whole SV set
+		//	anyway, so with merging the slack would only make the maintenance slower
+		if (((*param).ALGORITHM == BSGD) && ((*param).BUDGET_SLACK > 0) && ((*param).MAINTENANCE_SAMPLING_STRATEGY == BUDGET_MAINTAIN_MERGE))
+		{
+			sprintf(str, "Error, budget slack can only be used with removal strategy, set either '-E' to 0 or '-m' to 0!\nRun 'budgetedsvm_train()' for help.");
+			mexErrMsgTxt(str);
+		}
+		
 		// check the MAINTENANCE_SAMPLING_STRATEGY validity
 		if ((*param).ALGORITHM == LLSVM)
 		{
@@ -1541,6 +1733,8 @@ void parseInputMatlab(parameters *param, const char *paramString, bool trainingP
 							
 						case LANDMARK_SAMPLE_KMEDOIDS:
 							mexPrintf("Landmark sampling \t\t\t: k-medoids initialization\n");
+							if ((*param).MEDOID_SAMPLE_SIZE > 0)
+								mexPrintf("Medoid sample size \t\t\t: %d\n", (*param).MEDOID_SAMPLE_SIZE);
 							break;
 							
 						default:
@@ -1548,6 +1742,10 @@ void parseInputMatlab(parameters *param, const char *paramString, bool trainingP
 							break;
 					}
 					mexPrintf("Number of landmark points \t: %d\n", (*param).BUDGET_SIZE);
+					if ((*param).LANDMARK_RESERVOIR_SIZE > 0)
+						mexPrintf("Landmark reservoir size \t: %d\n", (*param).LANDMARK_RESERVOIR_SIZE);
+					if (((*param).NYSTROM_RANK > 0) && ((*param).NYSTROM_RANK < (*param).BUDGET_SIZE))
+						mexPrintf("Nystrom rank \t\t\t\t: %d (oversampling %d)\n", (*param).NYSTROM_RANK, (*param).NYSTROM_OVERSAMPLING);
 					mexPrintf("Lambda regularization param.: %f\n", (*param).LAMBDA_PARAM);
 				}
 				
@@ -1673,6 +1871,9 @@ void parseInputMatlab(parameters *param, const char *paramString, bool trainingP
 				case 'S':
 					(*param).VERY_SPARSE_DATA = (unsigned int) (value[i] != 0);
 					break;
+				case 'P':
+					(*param).PACKED_WEIGHTS = (value[i] != 0);
+					break;
 
 				default:
 					sprintf(str, "Error, unknown input parameter '-%c'!\nRun 'budgetedsvm_predict()' for help.", option[i]);
@@ -101,8 +101,9 @@ class budgetedModelMatlab
 			- BSGD: The model is stored as ((\a numClasses + \a dimension) x \a numWeights) matrix. The first \a numClasses elements of each weight correspond to alpha parameters for each class, 
 			given in order of \a labels member of the Matlab structure. This is followed by elements of the weights (or support vectors) for each feature of the data set.
 			
-			- LLSVM: The model is stored as ((1 + \a dimension) x \a numWeights) matrix. Each row corresponds to one landmark point. The first element of each row corresponds to 
-			element of linear SVM hyperplane for that particular landmark point. This is followed by features of the landmark point in the original feature space.
+			- LLSVM: The model is stored as ((\a numClassifiers + \a dimension) x \a numWeights) matrix, where \a numClassifiers is 1 for binary problems and \a numClasses otherwise. 
+			Each column corresponds to one landmark point. The first \a numClassifiers elements of each column are the coefficients of that particular landmark point, one for each 
+			(one-vs-rest) linear classifier. This is followed by features of the landmark point in the original feature space.
 		*/
 		virtual void saveToMatlabStruct(mxArray *plhs[], vector <int>* yLabels, parameters *param) = 0;
 		
@@ -125,8 +126,9 @@ class budgetedModelMatlab
 			- BSGD: The model is stored as ((\a numClasses + \a dimension) x \a numWeights) matrix. The first \a numClasses elements of each weight correspond to alpha parameters for each class, 
 			given in order of "labels" member of the Matlab structure. This is followed by elements of the weights (or support vectors) for each feature of the data set.
 			
-			- LLSVM: The model is stored as ((1 + \a dimension) x \a numWeights) matrix. Each row corresponds to one landmark point. The first element of each row corresponds to 
-			element of linear SVM hyperplane for that particular landmark point. This is followed by features of the landmark point in the original feature space.
+			- LLSVM: The model is stored as ((\a numClassifiers + \a dimension) x \a numWeights) matrix, where \a numClassifiers is 1 for binary problems and \a numClasses otherwise. 
+			Each column corresponds to one landmark point. The first \a numClassifiers elements of each column are the coefficients of that particular landmark point, one for each 
+			(one-vs-rest) linear classifier. This is followed by features of the landmark point in the original feature space.
 		*/
 		virtual bool loadFromMatlabStruct(const mxArray *matlabStruct, vector <int>* yLabels, parameters *param, const char **msg) = 0;
 };
@@ -224,8 +226,9 @@ class budgetedModelMatlabLLSVM : public budgetedModelMatlab, public budgetedMode
 			The Matlab structure is organized as ["algorithm", "dimension", "numClasses", "labels", "numWeights", "paramBias", "kernelWidth", "model"]. In order to compress memory and to use the 
 			memory efficiently, we coded the model in the following way:
 			
-			The model is stored as ((1 + "dimension") by "numWeights") matrix. Each row corresponds to one landmark point. The first element of each row corresponds to 
-			element of linear SVM hyperplane for that particular landmark point. This is followed by features of the landmark point in the original feature space.
+			The model is stored as (("numClassifiers" + "dimension") by "numWeights") matrix, where "numClassifiers" is 1 for binary problems and "numClasses" otherwise. Each column 
+			corresponds to one landmark point. The first "numClassifiers" elements of each column are the coefficients of that particular landmark point, one for each (one-vs-rest) 
+			linear classifier. This is followed by features of the landmark point in the original feature space.
 		*/
 		void saveToMatlabStruct(mxArray *plhs[], vector <int>* yLabels, parameters *param);
 		
@@ -240,8 +243,9 @@ class budgetedModelMatlabLLSVM : public budgetedModelMatlab, public budgetedMode
 			The Matlab structure is organized as ["algorithm", "dimension", "numClasses", "labels", "numWeights", "paramBias", "kernelWidth", "model"]. In order to compress memory and to use the 
 			memory efficiently, we coded the model in the following way:
 			
-			The model is stored as ((1 + "dimension") by "numWeights") matrix. Each row corresponds to one landmark point. The first element of each row corresponds to 
-			element of linear SVM hyperplane for that particular landmark point. This is followed by features of the landmark point in the original feature space.
+			The model is stored as (("numClassifiers" + "dimension") by "numWeights") matrix, where "numClassifiers" is 1 for binary problems and "numClasses" otherwise. Each column 
+			corresponds to one landmark point. The first "numClassifiers" elements of each column are the coefficients of that particular landmark point, one for each (one-vs-rest) 
+			linear classifier. This is followed by features of the landmark point in the original feature space.
 		*/
 		bool loadFromMatlabStruct(const mxArray *matlabStruct, vector <int>* yLabels, parameters *param, const char **msg);
 };
@@ -12,12 +12,16 @@ try
 		mex libsvmread.c
 		disp('Compiling libsvmwrite.c ...');
 		mex libsvmwrite.c
+		% compile with OpenMP, so that the -T option can use more than one thread
+		setenv('CXXFLAGS', [strtrim(mkoctfile('-p', 'CXXFLAGS')) ' -fopenmp']);
+		setenv('LDFLAGS', [strtrim(mkoctfile('-p', 'LDFLAGS')) ' -fopenmp']);
 		disp('Compiling budgetedsvm_train.cpp ...');
 		mex budgetedsvm_train.cpp ../src/budgetedSVM.cpp ../src/mm_algs.cpp ../src/bsgd.cpp ../src/llsvm.cpp budgetedSVM_matlab.cpp
 		disp('Compiling budgetedsvm_predict.cpp ...');
 		mex budgetedsvm_predict.cpp ../src/budgetedSVM.cpp ../src/mm_algs.cpp ../src/bsgd.cpp ../src/llsvm.cpp budgetedSVM_matlab.cpp
 	else
-		% This part is for MATLAB
+		% This part is for MATLAB; budgetedsvm_train and budgetedsvm_predict are compiled with OpenMP, so that the -T option can use more
+		%	than one thread, where CXXFLAGS and LDFLAGS are used by gcc and clang, and COMPFLAGS by Microsoft Visual C/C++ on Windows
 		disp('make process started, please be patient as it might take about a minute.');
         if (is_64_bit_version())
             % Add -largeArrayDims on 64-bit machines of MATLAB
@@ -26,18 +30,18 @@ try
 			disp('Compiling libsvmwrite.c ...');
             mex CFLAGS='\$CFLAGS -std=c99' -largeArrayDims libsvmwrite.c
 			disp('Compiling budgetedsvm_train.cpp ...');
-            mex CFLAGS='\$CFLAGS -std=c99' -largeArrayDims budgetedsvm_train.cpp ../src/budgetedSVM.cpp ../src/mm_algs.cpp ../src/bsgd.cpp ../src/llsvm.cpp budgetedSVM_matlab.cpp
+            mex CFLAGS='\$CFLAGS -std=c99' CXXFLAGS='\$CXXFLAGS -fopenmp' LDFLAGS='\$LDFLAGS -fopenmp' COMPFLAGS='\$COMPFLAGS /openmp' -largeArrayDims budgetedsvm_train.cpp ../src/budgetedSVM.cpp ../src/mm_algs.cpp ../src/bsgd.cpp ../src/llsvm.cpp budgetedSVM_matlab.cpp
 			disp('Compiling budgetedsvm_predict.cpp ...');
-            mex CFLAGS='\$CFLAGS -std=c99' -largeArrayDims budgetedsvm_predict.cpp ../src/budgetedSVM.cpp ../src/mm_algs.cpp ../src/bsgd.cpp ../src/llsvm.cpp budgetedSVM_matlab.cpp
+            mex CFLAGS='\$CFLAGS -std=c99' CXXFLAGS='\$CXXFLAGS -fopenmp' LDFLAGS='\$LDFLAGS -fopenmp' COMPFLAGS='\$COMPFLAGS /openmp' -largeArrayDims budgetedsvm_predict.cpp ../src/budgetedSVM.cpp ../src/mm_algs.cpp ../src/bsgd.cpp ../src/llsvm.cpp budgetedSVM_matlab.cpp
         else		
 			disp('Compiling libsvmread.c ...');
             mex CFLAGS='\$CFLAGS -std=c99' libsvmread.c
 			disp('Compiling libsvmwrite.c ...');
             mex CFLAGS='\$CFLAGS -std=c99' libsvmwrite.c
 			disp('Compiling budgetedsvm_train.cpp ...');
-            mex CFLAGS='\$CFLAGS -std=c99' budgetedsvm_train.cpp ../src/budgetedSVM.cpp ../src/mm_algs.cpp ../src/bsgd.cpp ../src/llsvm.cpp budgetedSVM_matlab.cpp
+            mex CFLAGS='\$CFLAGS -std=c99' CXXFLAGS='\$CXXFLAGS -fopenmp' LDFLAGS='\$LDFLAGS -fopenmp' COMPFLAGS='\$COMPFLAGS /openmp' budgetedsvm_train.cpp ../src/budgetedSVM.cpp ../src/mm_algs.cpp ../src/bsgd.cpp ../src/llsvm.cpp budgetedSVM_matlab.cpp
 			disp('Compiling budgetedsvm_predict.cpp ...');
-            mex CFLAGS='\$CFLAGS -std=c99' budgetedsvm_predict.cpp ../src/budgetedSVM.cpp ../src/mm_algs.cpp ../src/bsgd.cpp ../src/llsvm.cpp budgetedSVM_matlab.cpp
+            mex CFLAGS='\$CFLAGS -std=c99' CXXFLAGS='\$CXXFLAGS -fopenmp' LDFLAGS='\$LDFLAGS -fopenmp' COMPFLAGS='\$COMPFLAGS /openmp' budgetedsvm_predict.cpp ../src/budgetedSVM.cpp ../src/mm_algs.cpp ../src/bsgd.cpp ../src/llsvm.cpp budgetedSVM_matlab.cpp
         end;
 	end
 catch e
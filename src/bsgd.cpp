@@ -29,6 +29,66 @@ using namespace std;
 
 unsigned int budgetedVectorBSGD::numClasses = 0;
 
+// Define local helper functions in anon namespace.
+namespace
+{
+
+/* \fn unsigned int hashElement(unsigned int idx, float value)
+	\brief Hashes a single non-zero element of a vector.
+	\param [in] idx Index of the element.
+	\param [in] value Value of the element.
+	\return Hash of the element.
+	
+	Content hash of a vector is a sum of hashes of its non-zero elements, which makes it independent of the order in which the elements are visited. This allows
+	us to compute the same hash both from a data point stored in budgetedData and from a support vector stored in chunks.
+*/
+unsigned int hashElement(unsigned int idx, float value)
+{
+	unsigned int bits, h;
+	memcpy(&bits, &value, sizeof(float));
+	
+	h = ((idx + 1) * 2654435761U) ^ (bits * 2246822519U);
+	h ^= (h >> 15);
+	h *= 3266489917U;
+	h ^= (h >> 16);
+	return h;
+}
+
+/* \fn void alignAlphas(budgetedVectorBSGD *v1, budgetedVectorBSGD *v2, vector <long double> *alphas1, vector <long double> *alphas2)
+	\brief Lists the alphas of two vectors for all classes where at least one of them has a non-zero alpha, in increasing order of classes.
+	\param [in] v1 The first vector.
+	\param [in] v2 The second vector.
+	\param [out] alphas1 Alphas of the first vector.
+	\param [out] alphas2 Alphas of the second vector, where alphas2[i] and alphas1[i] belong to the same class.
+*/
+void alignAlphas(budgetedVectorBSGD *v1, budgetedVectorBSGD *v2, vector <long double> *alphas1, vector <long double> *alphas2)
+{
+	unsigned int i = 0, j = 0, numAlphas1 = v1->getNumNonZeroAlphas(), numAlphas2 = v2->getNumNonZeroAlphas();
+	
+	(*alphas1).clear();
+	(*alphas2).clear();
+	while ((i < numAlphas1) || (j < numAlphas2))
+	{
+		if ((j == numAlphas2) || ((i < numAlphas1) && (v1->getAlphaClass(i) < v2->getAlphaClass(j))))
+		{
+			(*alphas1).push_back(v1->getAlphaValue(i++));
+			(*alphas2).push_back(0.0);
+		}
+		else if ((i == numAlphas1) || (v1->getAlphaClass(i) > v2->getAlphaClass(j)))
+		{
+			(*alphas1).push_back(0.0);
+			(*alphas2).push_back(v2->getAlphaValue(j++));
+		}
+		else
+		{
+			(*alphas1).push_back(v1->getAlphaValue(i++));
+			(*alphas2).push_back(v2->getAlphaValue(j++));
+		}
+	}
+}
+
+} // end namespace
+
 /* prototypes of functions used to find kMax in the case of merging budget maintenance strategy
 long double evaluateMergingObjectiveFunc(long double a1, long double a2, long double k12, long double x);
 long double goldenSectionSearch(long double k12, long double a1, long double a2, long double a, long double b, long double tolerance);
@@ -63,6 +123,8 @@ bool budgetedModelBSGD::saveToTextFile(const char *filename, vector <int>* yLabe
 	FILE *fModel = NULL;
 	fModel = fopen(filename, "wt");
 	bool tempBool;
+	vector <unsigned int> nonZeroIndices;
+	vector <float> nonZeroValues;
 
 	if (!fModel)
 		return false;
@@ -106,29 +168,26 @@ bool budgetedModelBSGD::saveToTextFile(const char *filename, vector <int>* yLabe
 	for (i = 0; i < (*modelBSGD).size(); i++)
 	//for (i = 0; i < 50; i++)
 	{
-		for (j = 0; j < (*yLabels).size(); j++)
+		for (j = 0; j < (*modelBSGD)[i]->getNumNonZeroAlphas(); j++)
 		{
-			// alphas have negative index to differentiate them from features
-			if ((*((*modelBSGD)[i])).alphas[j] != 0.0)
-				fprintf(fModel, "-%d:%2.10f ", j + 1, (double)(*((*modelBSGD)[i])).alphas[j]);
+			// alphas have negative index to differentiate them from features, and only non-zero alphas are saved
+			fprintf(fModel, "-%d:%2.10f ", (*modelBSGD)[i]->getAlphaClass(j) + 1, (double)(*modelBSGD)[i]->getAlphaValue(j));
 		}
 
 		// this tempBool is used so that the line doesn't end with a white-space, it makes our life
 		// easier when reading word-by-word from the model file using fgetWord(); we can, of course,
 		// do without it, but to avoid unnecessary checks during loading of the model we do it here
 		tempBool = true;
-		for (j = 0; j < (*param).DIMENSION; j++)					// for every feature
+		(*modelBSGD)[i]->getNonZeroElements(&nonZeroIndices, &nonZeroValues);
+		for (j = 0; j < nonZeroIndices.size(); j++)					// for every non-zero feature
 		{
-			if ((*((*modelBSGD)[i]))[j] != 0.0)
+			if (tempBool)
 			{
-				if (tempBool)
-				{
-					fprintf(fModel, "%d:%2.10f", j + 1, (*((*modelBSGD)[i]))[j]);
-					tempBool = false;
-				}
-				else
-					fprintf(fModel, " %d:%2.10f", j + 1, (*((*modelBSGD)[i]))[j]);
+				fprintf(fModel, "%d:%2.10f", nonZeroIndices[j] + 1, nonZeroValues[j]);
+				tempBool = false;
 			}
+			else
+				fprintf(fModel, " %d:%2.10f", nonZeroIndices[j] + 1, nonZeroValues[j]);
 		}
 		fprintf(fModel, "\n");
 	}
@@ -156,6 +215,8 @@ bool budgetedModelBSGD::loadFromTextFile(const char *filename, vector <int>* yLa
 	fModel = fopen(filename, "rt");
 	bool doneReadingBool;
 	long double sqrNorm;
+	vector <unsigned int> featureIndices, alphaIndices;
+	vector <float> featureValues, alphaValues;
 
 	if (!fModel)
 		return false;
@@ -245,8 +306,11 @@ bool budgetedModelBSGD::loadFromTextFile(const char *filename, vector <int>* yLa
 
 	for (i = 0; i < numWeights[0]; i++)							// for every weight
 	{
-		budgetedVectorBSGD *eNew = new budgetedVectorBSGD((*param).DIMENSION, (*param).CHUNK_WEIGHT, numClasses);
 		sqrNorm = 0.0L;
+		featureIndices.clear();
+		featureValues.clear();
+		alphaIndices.clear();
+		alphaValues.clear();
 
 		// get alphas and features
 		doneReadingBool = false;
@@ -265,13 +329,25 @@ bool budgetedModelBSGD::loadFromTextFile(const char *filename, vector <int>* yLa
 				// alphas have negative index, features have positive
 				if (tempInt > 0)
 				{
-					(*eNew)[tempInt - 1] = tempFloat;
+					featureIndices.push_back(tempInt - 1);
+					featureValues.push_back(tempFloat);
 					sqrNorm += (long double)(tempFloat * tempFloat);
 				}
 				else
-					(*eNew).alphas[- tempInt - 1] = tempFloat;
+				{
+					alphaIndices.push_back(- tempInt - 1);
+					alphaValues.push_back(tempFloat);
+				}
 			}
 		}
+		
+		// now that the number of non-zero features is known, decide how to store the support vector
+		budgetedVectorBSGD *eNew = new budgetedVectorBSGD((*param).DIMENSION, (*param).CHUNK_WEIGHT, numClasses, 
+			budgetedVectorBSGD::useSparseStorage((unsigned int) featureIndices.size(), (*param).DIMENSION));
+		for (unsigned int j = 0; j < featureIndices.size(); j++)
+			eNew->setElement(featureIndices[j], featureValues[j]);
+		for (unsigned int j = 0; j < alphaIndices.size(); j++)
+			eNew->setAlpha(alphaIndices[j], alphaValues[j]);
 		eNew->setSqrL2norm(sqrNorm);
 
 		(*modelBSGD).push_back(eNew);
@@ -293,6 +369,54 @@ void budgetedVectorBSGD::updateSV(budgetedVectorBSGD* v, long double kMax)
 	unsigned long i, j;
 	long double linKern = this->linearKernel(v);
 
+	if (this->sparseStorage != v->sparseStorage)
+	{
+		svmPrintErrorString("Error in updateSV(), merged vectors must be stored in the same way!\n");
+	}
+	
+	if (sparseStorage)
+	{
+		// the merged vector is a sorted union of non-zero elements of the two vectors
+		unsigned int numElements = (unsigned int) sparseIndices.size(), numOtherElements = (unsigned int) v->sparseIndices.size();
+		vector <unsigned int> mergedIndices;
+		vector <float> mergedValues;
+		float mergedValue;
+		
+		mergedIndices.reserve(numElements + numOtherElements);
+		mergedValues.reserve(numElements + numOtherElements);
+		i = j = 0;
+		while ((i < numElements) || (j < numOtherElements))
+		{
+			if ((j == numOtherElements) || ((i < numElements) && (sparseIndices[i] < v->sparseIndices[j])))
+			{
+				mergedIndices.push_back(sparseIndices[i]);
+				mergedValue = (float)(kMax * (long double) sparseValues[i++]);
+			}
+			else if ((i == numElements) || (sparseIndices[i] > v->sparseIndices[j]))
+			{
+				mergedIndices.push_back(v->sparseIndices[j]);
+				mergedValue = (float)((1.0 - kMax) * v->sparseValues[j++]);
+			}
+			else
+			{
+				mergedIndices.push_back(sparseIndices[i]);
+				mergedValue = (float)(kMax * sparseValues[i++] + (1.0 - kMax) * v->sparseValues[j++]);
+			}
+			
+			if (mergedValue != 0.0)
+				mergedValues.push_back(mergedValue);
+			else
+				mergedIndices.pop_back();
+		}
+		sparseIndices.swap(mergedIndices);
+		sparseValues.swap(mergedValues);
+		
+		// the squared norm of the merged vector is computed from the maintained norms of the two vectors, with no need for another pass over the elements
+		this->sqrL2norm = kMax * kMax * (long double) (this->sqrL2norm) + (1.0L - kMax) * (1.0L - kMax) * v->getSqrL2norm() + 2.0L * kMax * (1.0L - kMax) * linKern;
+		this->updateContentHash();
+		return;
+	}
+
 	for (i = 0; i < arrayLength; i++)
 	{
 		if (this->array[i] != NULL)
@@ -337,6 +461,401 @@ void budgetedVectorBSGD::updateSV(budgetedVectorBSGD* v, long double kMax)
 
 	// we also update the squared norm of the merged vector
 	this->sqrL2norm = kMax * kMax * (long double) (this->sqrL2norm) + (1.0L - kMax) * (1.0L - kMax) * v->sqrNorm() + 2.0L * kMax * (1.0L - kMax) * linKern;
+	
+	// the elements of the vector changed, so its content hash needs to be recomputed as well
+	this->updateContentHash();
+}
+
+/* \fn void budgetedVectorBSGD::createVectorUsingDataPoint(budgetedData* inputData, unsigned int t, parameters* param)
+	\brief Create new vector from training data point, and compute its content hash.
+	\param [in] inputData Input data from which t-th vector is considered.
+	\param [in] t Index of the input vector in the input data.
+	\param [in] param The parameters of the algorithm.
+*/
+void budgetedVectorBSGD::createVectorUsingDataPoint(budgetedData* inputData, unsigned int t, parameters* param)
+{
+	if (!sparseStorage)
+	{
+		budgetedVector::createVectorUsingDataPoint(inputData, t, param);
+		contentHash = hashDataPoint(inputData, t, param, &numNonZeros);
+		return;
+	}
+	
+	unsigned int ibegin = inputData->ai[t];
+	unsigned int iend = (t == (unsigned int) (inputData->ai.size() - 1)) ? (unsigned int) (inputData->aj.size()) : inputData->ai[t + 1];
+	bool sorted = true;
+	
+	this->clear();
+	sparseIndices.reserve(iend - ibegin + 1);
+	sparseValues.reserve(iend - ibegin + 1);
+	for (unsigned int i = ibegin; i < iend; i++)
+	{
+		if (inputData->an[i] == 0.0)
+			continue;
+		
+		if ((!sparseIndices.empty()) && (sparseIndices.back() >= inputData->aj[i] - 1))
+			sorted = false;
+		sparseIndices.push_back(inputData->aj[i] - 1);
+		sparseValues.push_back(inputData->an[i]);
+		sqrL2norm += (inputData->an[i] * inputData->an[i]);
+	}
+	
+	// features in LIBSVM format are given in increasing order, but if this is not the case we still need the elements sorted
+	if (!sorted)
+	{
+		vector < pair <unsigned int, float> > elements(sparseIndices.size());
+		for (unsigned int i = 0; i < sparseIndices.size(); i++)
+			elements[i] = make_pair(sparseIndices[i], sparseValues[i]);
+		sort(elements.begin(), elements.end());
+		for (unsigned int i = 0; i < elements.size(); i++)
+		{
+			sparseIndices[i] = elements[i].first;
+			sparseValues[i] = elements[i].second;
+		}
+	}
+	
+	if ((*param).BIAS_TERM != 0)
+	{
+		setElement((*param).DIMENSION - 1, (float)((long double)(*param).BIAS_TERM));
+		sqrL2norm += ((*param).BIAS_TERM * (*param).BIAS_TERM);
+	}
+	contentHash = hashDataPoint(inputData, t, param, &numNonZeros);
+}
+
+/* \fn float budgetedVectorBSGD::getElement(unsigned int idx)
+	\brief Returns an element of the vector, regardless of the way the vector is stored.
+	\param [in] idx Index of vector element that is retrieved.
+	\return Value of the element of the vector.
+*/
+float budgetedVectorBSGD::getElement(unsigned int idx)
+{
+	if (sparseStorage)
+	{
+		vector <unsigned int>::iterator it = lower_bound(sparseIndices.begin(), sparseIndices.end(), idx);
+		if ((it == sparseIndices.end()) || (*it != idx))
+			return 0.0;
+		return sparseValues[it - sparseIndices.begin()];
+	}
+	
+	if (idx >= dimension)
+		return 0.0;
+	const budgetedVector &thisVector = *this;
+	return thisVector[idx];
+}
+
+/* \fn void budgetedVectorBSGD::setElement(unsigned int idx, float value)
+	\brief Sets an element of the vector, regardless of the way the vector is stored.
+	\param [in] idx Index of vector element that is modified.
+	\param [in] value New value of the element.
+*/
+void budgetedVectorBSGD::setElement(unsigned int idx, float value)
+{
+	if (!sparseStorage)
+	{
+		(*this)[idx] = value;
+		return;
+	}
+	
+	// the most common case, elements are set in order of increasing indices
+	if ((sparseIndices.empty()) || (sparseIndices.back() < idx))
+	{
+		if (value != 0.0)
+		{
+			sparseIndices.push_back(idx);
+			sparseValues.push_back(value);
+		}
+		return;
+	}
+	
+	vector <unsigned int>::iterator it = lower_bound(sparseIndices.begin(), sparseIndices.end(), idx);
+	unsigned int pos = (unsigned int) (it - sparseIndices.begin());
+	if (*it == idx)
+	{
+		if (value != 0.0)
+			sparseValues[pos] = value;
+		else
+		{
+			sparseIndices.erase(it);
+			sparseValues.erase(sparseValues.begin() + pos);
+		}
+	}
+	else if (value != 0.0)
+	{
+		sparseIndices.insert(it, idx);
+		sparseValues.insert(sparseValues.begin() + pos, value);
+	}
+}
+
+/* \fn void budgetedVectorBSGD::getNonZeroElements(vector <unsigned int> *indices, vector <float> *values)
+	\brief Returns all non-zero elements of the vector in order of increasing indices.
+	\param [out] indices Indices of the non-zero elements.
+	\param [out] values Values of the non-zero elements.
+*/
+void budgetedVectorBSGD::getNonZeroElements(vector <unsigned int> *indices, vector <float> *values)
+{
+	if (!sparseStorage)
+	{
+		budgetedVector::getNonZeroElements(indices, values);
+		return;
+	}
+	
+	(*indices).clear();
+	(*values).clear();
+	for (unsigned int i = 0; i < sparseIndices.size(); i++)
+	{
+		if (sparseValues[i] != 0.0)
+		{
+			(*indices).push_back(sparseIndices[i]);
+			(*values).push_back(sparseValues[i]);
+		}
+	}
+}
+
+/* \fn void budgetedVectorBSGD::clear(void)
+	\brief Clears the vector of all non-zero elements, resulting in a zero-vector.
+*/
+void budgetedVectorBSGD::clear(void)
+{
+	if (sparseStorage)
+	{
+		sparseIndices.clear();
+		sparseValues.clear();
+	}
+	else
+		budgetedVector::clear();
+}
+
+/* \fn void budgetedVectorBSGD::extendDimensionality(unsigned int newDim, parameters* param)
+	\brief Extend the dimensionality of the vector.
+	\param [in] newDim New dimensionality of the vector.
+	\param [in] param The parameters of the algorithm.
+*/
+void budgetedVectorBSGD::extendDimensionality(unsigned int newDim, parameters* param)
+{
+	if (!sparseStorage)
+	{
+		budgetedVector::extendDimensionality(newDim, param);
+		return;
+	}
+	
+	if (dimension > newDim)
+	{
+		svmPrintErrorString("In extendDimensionality(), extended vector dimensionality smaller than the old one!\n");
+	}
+	
+	// the bias term is the last element, move it to the end of the new, extended vector
+	if ((param->BIAS_TERM != 0.0) && (!sparseIndices.empty()) && (sparseIndices.back() == dimension - 1))
+		sparseIndices.back() = newDim - 1;
+	dimension = newDim;
+}
+
+/* \fn long double budgetedVectorBSGD::sqrNorm(void)
+	\brief Calculates a squared norm of the vector.
+	\return Squared norm of the vector.
+*/
+long double budgetedVectorBSGD::sqrNorm(void)
+{
+	if (!sparseStorage)
+		return budgetedVector::sqrNorm();
+	
+	long double tempSum = 0.0;
+	for (unsigned int i = 0; i < sparseValues.size(); i++)
+		tempSum += ((long double) sparseValues[i] * (long double) sparseValues[i]);
+	return tempSum;
+}
+
+/* \fn long double budgetedVectorBSGD::linearKernel(unsigned int t, budgetedData* inputData, parameters *param)
+	\brief Computes linear kernel between vector and given input data point.
+	\param [in] t Index of the input vector in the input data.
+	\param [in] inputData Input data from which t-th vector is considered.
+	\param [in] param The parameters of the algorithm.
+	\return Value of linear kernel between two input vectors.
+*/
+long double budgetedVectorBSGD::linearKernel(unsigned int t, budgetedData* inputData, parameters *param)
+{
+	if (!sparseStorage)
+		return budgetedVector::linearKernel(t, inputData, param);
+	
+	long double result = 0.0;
+	unsigned int ibegin = inputData->ai[t];
+	unsigned int iend = ((unsigned int)(t + 1) == inputData->N) ? (unsigned int) inputData->aj.size() : inputData->ai[t + 1];
+	unsigned int idx, k = 0, numElements = (unsigned int) sparseIndices.size();
+	
+	// both the vector and the data point are sorted by feature index, so we walk through them in parallel
+	for (unsigned int i = ibegin; i < iend; i++)
+	{
+		idx = inputData->aj[i] - 1;
+		
+		// if the features of the data point are not in increasing order, search for the current one from the beginning
+		if ((k > 0) && (sparseIndices[k - 1] >= idx))
+			k = (unsigned int) (lower_bound(sparseIndices.begin(), sparseIndices.begin() + k, idx) - sparseIndices.begin());
+		
+		while ((k < numElements) && (sparseIndices[k] < idx))
+			k++;
+		if (k == numElements)
+			break;
+		if (sparseIndices[k] == idx)
+			result += sparseValues[k++] * inputData->an[i];
+	}
+	if ((*param).BIAS_TERM != 0)
+	    result += (getElement((*param).DIMENSION - 1) * (*param).BIAS_TERM);
+	return result;
+}
+
+/* \fn long double budgetedVectorBSGD::linearKernel(budgetedVector* otherVector)
+	\brief Computes linear kernel between this vector and another vector, where either of the two can use sparse storage.
+	\param [in] otherVector The second input vector to linear kernel.
+	\return Value of linear kernel between two input vectors.
+*/
+long double budgetedVectorBSGD::linearKernel(budgetedVector* otherVector)
+{
+	budgetedVectorBSGD *otherVectorBSGD = dynamic_cast <budgetedVectorBSGD*> (otherVector);
+	bool otherSparse = ((otherVectorBSGD != NULL) && (otherVectorBSGD->sparseStorage));
+	long double result = 0.0L;
+	
+	if (!sparseStorage)
+	{
+		if (!otherSparse)
+			return budgetedVector::linearKernel(otherVector);
+		else
+			return otherVectorBSGD->linearKernel(this);
+	}
+	
+	if (otherSparse)
+	{
+		// sorted merge of non-zero elements of the two vectors
+		unsigned int i = 0, j = 0;
+		unsigned int numElements = (unsigned int) sparseIndices.size(), numOtherElements = (unsigned int) otherVectorBSGD->sparseIndices.size();
+		while ((i < numElements) && (j < numOtherElements))
+		{
+			if (sparseIndices[i] < otherVectorBSGD->sparseIndices[j])
+				i++;
+			else if (sparseIndices[i] > otherVectorBSGD->sparseIndices[j])
+				j++;
+			else
+				result += sparseValues[i++] * otherVectorBSGD->sparseValues[j++];
+		}
+	}
+	else
+	{
+		// the other vector is stored in chunks, which allow for random access to its elements
+		const budgetedVector &other = *otherVector;
+		for (unsigned int i = 0; i < sparseIndices.size(); i++)
+		{
+			if (sparseIndices[i] < otherVector->getDimensionality())
+				result += sparseValues[i] * other[sparseIndices[i]];
+		}
+	}
+	return result;
+}
+
+/* \fn unsigned int budgetedVectorBSGD::hashDataPoint(budgetedData* inputData, unsigned int t, parameters* param, unsigned int *numNonZero)
+	\brief Computes the content hash of a data point from budgetedData, equal to the content hash of a vector created from that data point.
+	\param [in] inputData Input data from which t-th vector is considered.
+	\param [in] t Index of the input vector in the input data.
+	\param [in] param The parameters of the algorithm.
+	\param [out] numNonZero If provided, set to the number of non-zero elements of the data point.
+	\return Content hash of the data point.
+*/
+unsigned int budgetedVectorBSGD::hashDataPoint(budgetedData* inputData, unsigned int t, parameters* param, unsigned int *numNonZero)
+{
+	unsigned int ibegin = inputData->ai[t];
+	unsigned int iend = (t == (unsigned int) (inputData->ai.size() - 1)) ? (unsigned int) (inputData->aj.size()) : inputData->ai[t + 1];
+	unsigned int hash = 0, count = 0;
+	
+	for (unsigned int i = ibegin; i < iend; i++)
+	{
+		if (inputData->an[i] != 0.0)
+		{
+			hash += hashElement(inputData->aj[i] - 1, inputData->an[i]);
+			count++;
+		}
+	}
+	
+	if ((*param).BIAS_TERM != 0)
+	{
+		hash += hashElement((*param).DIMENSION - 1, (float)((long double)(*param).BIAS_TERM));
+		count++;
+	}
+	
+	if (numNonZero)
+		*numNonZero = count;
+	return hash;
+}
+
+/* \fn void budgetedVectorBSGD::updateContentHash(void)
+	\brief Recomputes the content hash and the number of non-zero elements by traversing all allocated vector chunks.
+*/
+void budgetedVectorBSGD::updateContentHash(void)
+{
+	unsigned long chunkSize = chunkWeight;
+	
+	contentHash = 0;
+	numNonZeros = 0;
+	if (sparseStorage)
+	{
+		for (unsigned int i = 0; i < sparseIndices.size(); i++)
+		{
+			if (sparseValues[i] != 0.0)
+			{
+				contentHash += hashElement(sparseIndices[i], sparseValues[i]);
+				numNonZeros++;
+			}
+		}
+		return;
+	}
+	
+	for (unsigned int i = 0; i < arrayLength; i++)
+	{
+		if (array[i] != NULL)
+		{
+			if ((i == (arrayLength - 1)) && (dimension % chunkWeight != 0))
+				chunkSize = dimension % chunkWeight;
+			
+			for (unsigned int j = 0; j < chunkSize; j++)
+			{
+				if (array[i][j] != 0.0)
+				{
+					contentHash += hashElement(i * chunkWeight + j, array[i][j]);
+					numNonZeros++;
+				}
+			}
+		}
+	}
+}
+
+/* \fn bool budgetedVectorBSGD::isEqualToDataPoint(budgetedData* inputData, unsigned int t, parameters* param)
+	\brief Checks if the vector is identical to a data point.
+	\param [in] inputData Input data from which t-th vector is considered.
+	\param [in] t Index of the input vector in the input data.
+	\param [in] param The parameters of the algorithm.
+	\return True if the vector has exactly the same elements as the data point, otherwise false.
+*/
+bool budgetedVectorBSGD::isEqualToDataPoint(budgetedData* inputData, unsigned int t, parameters* param)
+{
+	unsigned int ibegin = inputData->ai[t];
+	unsigned int iend = (t == (unsigned int) (inputData->ai.size() - 1)) ? (unsigned int) (inputData->aj.size()) : inputData->ai[t + 1];
+	unsigned int count = 0;
+	
+	for (unsigned int i = ibegin; i < iend; i++)
+	{
+		if (inputData->an[i] != 0.0)
+		{
+			if (getElement(inputData->aj[i] - 1) != inputData->an[i])
+				return false;
+			count++;
+		}
+	}
+	
+	if ((*param).BIAS_TERM != 0)
+	{
+		if (getElement((*param).DIMENSION - 1) != (float)((long double)(*param).BIAS_TERM))
+			return false;
+		count++;
+	}
+	
+	// all non-zero features of the data point are found in the vector, the two are identical if the vector has no other non-zero elements
+	return (count == numNonZeros);
 }
 
 /* \fn long double alphaNorm(void)
@@ -346,11 +865,314 @@ void budgetedVectorBSGD::updateSV(budgetedVectorBSGD* v, long double kMax)
 long double budgetedVectorBSGD::alphaNorm(void)
 {
 	long double tempSum = 0.0;
-	for (unsigned long i = 0; i < alphas.size(); i++)
-		tempSum += (alphas[i] * alphas[i]);
+	for (unsigned long i = 0; i < alphaValues.size(); i++)
+		tempSum += (alphaValues[i] * alphaValues[i]);
 	return tempSum;
 }
 
+/* \fn long double budgetedVectorBSGD::getAlpha(unsigned int k)
+	\brief Returns the alpha parameter of a given class.
+	\param [in] k Class index.
+	\return Alpha of k-th class, or 0 if not among the non-zero alphas.
+*/
+long double budgetedVectorBSGD::getAlpha(unsigned int k)
+{
+	vector <unsigned int>::iterator it = lower_bound(alphaClasses.begin(), alphaClasses.end(), k);
+	if ((it == alphaClasses.end()) || (*it != k))
+		return 0.0;
+	return alphaValues[it - alphaClasses.begin()];
+}
+
+/* \fn void budgetedVectorBSGD::setAlpha(unsigned int k, long double value)
+	\brief Sets the alpha parameter of a given class, setting it to 0 removes it from the non-zero alphas.
+	\param [in] k Class index.
+	\param [in] value New value of the alpha.
+*/
+void budgetedVectorBSGD::setAlpha(unsigned int k, long double value)
+{
+	vector <unsigned int>::iterator it = lower_bound(alphaClasses.begin(), alphaClasses.end(), k);
+	unsigned int pos = (unsigned int) (it - alphaClasses.begin());
+	if ((it != alphaClasses.end()) && (*it == k))
+	{
+		if (value != 0.0)
+			alphaValues[pos] = value;
+		else
+		{
+			alphaClasses.erase(it);
+			alphaValues.erase(alphaValues.begin() + pos);
+		}
+	}
+	else if (value != 0.0)
+	{
+		alphaClasses.insert(it, k);
+		alphaValues.insert(alphaValues.begin() + pos, value);
+	}
+}
+
+/* \fn void budgetedVectorBSGD::combineAlphas(budgetedVectorBSGD* v, long double thisCoef, long double otherCoef)
+	\brief Sets alphas to a linear combination of alphas of this and another vector.
+	\param [in] v The other vector.
+	\param [in] thisCoef Coefficient of the alphas of this vector.
+	\param [in] otherCoef Coefficient of the alphas of the other vector.
+*/
+void budgetedVectorBSGD::combineAlphas(budgetedVectorBSGD* v, long double thisCoef, long double otherCoef)
+{
+	vector <unsigned int> newClasses;
+	vector <long double> newValues;
+	unsigned int i = 0, j = 0, numAlphas = (unsigned int) alphaClasses.size(), numOtherAlphas = (unsigned int) v->alphaClasses.size();
+	long double value;
+	
+	// sorted union of the non-zero alphas of the two vectors
+	newClasses.reserve(numAlphas + numOtherAlphas);
+	newValues.reserve(numAlphas + numOtherAlphas);
+	while ((i < numAlphas) || (j < numOtherAlphas))
+	{
+		if ((j == numOtherAlphas) || ((i < numAlphas) && (alphaClasses[i] < v->alphaClasses[j])))
+		{
+			newClasses.push_back(alphaClasses[i]);
+			value = alphaValues[i++] * thisCoef;
+		}
+		else if ((i == numAlphas) || (alphaClasses[i] > v->alphaClasses[j]))
+		{
+			newClasses.push_back(v->alphaClasses[j]);
+			value = v->alphaValues[j++] * otherCoef;
+		}
+		else
+		{
+			newClasses.push_back(alphaClasses[i]);
+			value = alphaValues[i++] * thisCoef + v->alphaValues[j++] * otherCoef;
+		}
+		
+		if (value != 0.0)
+			newValues.push_back(value);
+		else
+			newClasses.pop_back();
+	}
+	alphaClasses.swap(newClasses);
+	alphaValues.swap(newValues);
+}
+
+/* \fn void budgetedInvertedIndexBSGD::addVector(budgetedVectorBSGD* v)
+	\brief Adds a vector to the index, and assigns it a slot.
+	\param [in] v Vector being added.
+*/
+void budgetedInvertedIndexBSGD::addVector(budgetedVectorBSGD* v)
+{
+	vector <unsigned int> indices;
+	vector <float> values;
+	
+	if (freeSlots.empty())
+	{
+		v->invertedIndexSlot = (unsigned int) dotProducts.size();
+		dotProducts.push_back(0.0);
+	}
+	else
+	{
+		v->invertedIndexSlot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	
+	v->getNonZeroElements(&indices, &values);
+	if ((!indices.empty()) && (postings.size() <= indices.back()))
+		postings.resize(indices.back() + 1);
+	for (unsigned int i = 0; i < indices.size(); i++)
+		postings[indices[i]].push_back(make_pair(v->invertedIndexSlot, values[i]));
+}
+
+/* \fn void budgetedInvertedIndexBSGD::removeVector(budgetedVectorBSGD* v)
+	\brief Removes a vector from the index, must be called before the vector is deleted or modified.
+	\param [in] v Vector being removed.
+*/
+void budgetedInvertedIndexBSGD::removeVector(budgetedVectorBSGD* v)
+{
+	vector <unsigned int> indices;
+	vector <float> values;
+	
+	v->getNonZeroElements(&indices, &values);
+	for (unsigned int i = 0; i < indices.size(); i++)
+	{
+		// order of the postings is not important, so the removed posting is simply overwritten by the last one
+		vector < pair <unsigned int, float> > &postingList = postings[indices[i]];
+		for (unsigned int j = 0; j < postingList.size(); j++)
+		{
+			if (postingList[j].first == v->invertedIndexSlot)
+			{
+				postingList[j] = postingList.back();
+				postingList.pop_back();
+				break;
+			}
+		}
+	}
+	freeSlots.push_back(v->invertedIndexSlot);
+}
+
+/* \fn void budgetedInvertedIndexBSGD::rebuild(vector <budgetedVectorBSGD*>* v)
+	\brief Clears the index and adds all given vectors.
+	\param [in] v Vectors being indexed.
+*/
+void budgetedInvertedIndexBSGD::rebuild(vector <budgetedVectorBSGD*>* v)
+{
+	postings.clear();
+	freeSlots.clear();
+	dotProducts.clear();
+	for (unsigned int i = 0; i < (*v).size(); i++)
+		addVector((*v)[i]);
+}
+
+/* \fn void budgetedInvertedIndexBSGD::computeDotProducts(unsigned int t, budgetedData* inputData, parameters *param)
+	\brief Computes dot products between a data point and all indexed vectors.
+	\param [in] t Index of the input vector in the input data.
+	\param [in] inputData Input data from which t-th vector is considered.
+	\param [in] param The parameters of the algorithm.
+*/
+void budgetedInvertedIndexBSGD::computeDotProducts(unsigned int t, budgetedData* inputData, parameters *param)
+{
+	unsigned int ibegin = inputData->ai[t];
+	unsigned int iend = ((unsigned int)(t + 1) == inputData->N) ? (unsigned int) inputData->aj.size() : inputData->ai[t + 1];
+	unsigned int idx;
+	
+	for (unsigned int i = 0; i < dotProducts.size(); i++)
+		dotProducts[i] = 0.0;
+	
+	// products are accumulated in the same order as in budgetedVector::linearKernel(unsigned int, budgetedData*, parameters*), so that the results are identical
+	for (unsigned int i = ibegin; i < iend; i++)
+	{
+		idx = inputData->aj[i] - 1;
+		if (idx >= postings.size())
+			continue;
+		
+		vector < pair <unsigned int, float> > &postingList = postings[idx];
+		for (unsigned int j = 0; j < postingList.size(); j++)
+			dotProducts[postingList[j].first] += postingList[j].second * inputData->an[i];
+	}
+	
+	// the bias term is not stored in budgetedData, it is the last element of each vector
+	if (((*param).BIAS_TERM != 0) && ((*param).DIMENSION - 1 < postings.size()))
+	{
+		vector < pair <unsigned int, float> > &postingList = postings[(*param).DIMENSION - 1];
+		for (unsigned int j = 0; j < postingList.size(); j++)
+			dotProducts[postingList[j].first] += postingList[j].second * (*param).BIAS_TERM;
+	}
+}
+
+/* \fn void budgetedHashIndexBSGD::addVector(budgetedVectorBSGD* v)
+	\brief Adds a vector to the index, its content hash must be up to date.
+	\param [in] v Vector being added.
+*/
+void budgetedHashIndexBSGD::addVector(budgetedVectorBSGD* v)
+{
+	// keep at most one vector per bucket on average, doubling the number of buckets redistributes all vectors
+	if (numVectors >= buckets.size())
+	{
+		vector < vector <budgetedVectorBSGD*> > oldBuckets(2 * buckets.size());
+		oldBuckets.swap(buckets);
+		for (unsigned int i = 0; i < oldBuckets.size(); i++)
+		{
+			for (unsigned int j = 0; j < oldBuckets[i].size(); j++)
+				(*getBucket(oldBuckets[i][j]->getContentHash())).push_back(oldBuckets[i][j]);
+		}
+	}
+	
+	(*getBucket(v->getContentHash())).push_back(v);
+	numVectors++;
+}
+
+/* \fn void budgetedHashIndexBSGD::removeVector(budgetedVectorBSGD* v)
+	\brief Removes a vector from the index, must be called before the vector is deleted or modified.
+	\param [in] v Vector being removed.
+*/
+void budgetedHashIndexBSGD::removeVector(budgetedVectorBSGD* v)
+{
+	vector <budgetedVectorBSGD*> *bucket = getBucket(v->getContentHash());
+	for (unsigned int i = 0; i < (*bucket).size(); i++)
+	{
+		// order of the vectors in a bucket is not important, so the removed vector is simply overwritten by the last one
+		if ((*bucket)[i] == v)
+		{
+			(*bucket)[i] = (*bucket).back();
+			(*bucket).pop_back();
+			numVectors--;
+			return;
+		}
+	}
+}
+
+/* \fn void budgetedHashIndexBSGD::rebuild(vector <budgetedVectorBSGD*>* v)
+	\brief Clears the index and adds all given vectors.
+	\param [in] v Vectors being indexed.
+*/
+void budgetedHashIndexBSGD::rebuild(vector <budgetedVectorBSGD*>* v)
+{
+	for (unsigned int i = 0; i < buckets.size(); i++)
+		buckets[i].clear();
+	numVectors = 0;
+	for (unsigned int i = 0; i < (*v).size(); i++)
+		addVector((*v)[i]);
+}
+
+/* \fn budgetedVectorBSGD* budgetedHashIndexBSGD::findDataPoint(unsigned int hash, budgetedData* inputData, unsigned int t, parameters* param)
+	\brief Finds an indexed vector identical to a data point.
+	\param [in] hash Content hash of the data point.
+	\param [in] inputData Input data from which t-th vector is considered.
+	\param [in] t Index of the input vector in the input data.
+	\param [in] param The parameters of the algorithm.
+	\return Indexed vector identical to the data point, NULL if there is no such vector.
+*/
+budgetedVectorBSGD* budgetedHashIndexBSGD::findDataPoint(unsigned int hash, budgetedData* inputData, unsigned int t, parameters* param)
+{
+	vector <budgetedVectorBSGD*> *bucket = getBucket(hash);
+	for (unsigned int i = 0; i < (*bucket).size(); i++)
+	{
+		// vectors with other hashes can share the bucket, and the hashes can collide, so a match is confirmed element by element
+		if (((*bucket)[i]->getContentHash() == hash) && (*bucket)[i]->isEqualToDataPoint(inputData, t, param))
+			return (*bucket)[i];
+	}
+	return NULL;
+}
+
+/* \fn long double budgetedInvertedIndexBSGD::computeKernel(budgetedVectorBSGD* v, long double inputVectorSqrNorm, parameters *param)
+	\brief Computes kernel between an indexed vector and the data point last given to computeDotProducts().
+	\param [in] v Indexed vector.
+	\param [in] inputVectorSqrNorm Squared norm of the data point, used by Gaussian and exponential kernels.
+	\param [in] param The parameters of the algorithm.
+	\return Value of kernel between the vector and the data point.
+*/
+long double budgetedInvertedIndexBSGD::computeKernel(budgetedVectorBSGD* v, long double inputVectorSqrNorm, parameters *param)
+{
+	long double dotProduct = dotProducts[v->invertedIndexSlot], temp;
+	
+	switch ((*param).KERNEL)
+	{
+		case KERNEL_FUNC_GAUSSIAN:
+			return exp(-0.5L * (long double)((*param).KERNEL_GAMMA_PARAM) * (v->getSqrL2norm() + inputVectorSqrNorm - 2.0L * dotProduct));
+			break;
+		
+		case KERNEL_FUNC_EXPONENTIAL:
+			temp = sqrt((long double) (v->getSqrL2norm() + inputVectorSqrNorm - 2.0L * dotProduct));
+			if (temp >= 0)
+				return exp(-0.5L * (long double)((*param).KERNEL_GAMMA_PARAM) * temp);
+			else
+				return 0.0L;
+			break;
+		
+		case KERNEL_FUNC_SIGMOID:
+			return (long double) tanh((long double) ((*param).KERNEL_COEF_PARAM + (*param).KERNEL_DEGREE_PARAM * dotProduct));
+			break;
+		
+		case KERNEL_FUNC_POLYNOMIAL:
+			return (long double) pow((long double) ((*param).KERNEL_COEF_PARAM + dotProduct), (long double) (*param).KERNEL_DEGREE_PARAM);
+			break;
+		
+		case KERNEL_FUNC_LINEAR:
+			return dotProduct;
+			break;
+		
+		default:
+			svmPrintErrorString("Error, kernel function that can not be computed from the inverted index found!\n");
+			return -1.0;
+	}
+}
+
 /*! \fn long double evaluateMergingObjectiveFunc(long double a1, long double a2, long double k12, long double x)
 	\brief Find the current value of merging objective function.
 	\param [in] a1 Alpha (class-specific) value of the first point.
@@ -435,6 +1257,7 @@ long double* computeKmax(vector <budgetedVectorBSGD*>* v, unsigned int merge1, p
 	long double kMaxRet = 0.0, kZret1 = 0.0, kZret2 = 0.0;	// return vars
 	unsigned int merge2 = 0;	// return vars
 	long double* returnValues = new long double[4];
+	vector <long double> alphas1, alphas2;
 
 	lossMin = INF;
 	for (unsigned int i = 0; i < (*v).size(); i++)
@@ -445,15 +1268,18 @@ long double* computeKmax(vector <budgetedVectorBSGD*>* v, unsigned int merge1, p
 		k12 = (*v)[merge1]->gaussianKernel((*v)[i], param);
 		a1 = 0;
 		a2 = 0;
-		for (unsigned int k = 0; k < (*v)[i]->alphas.size(); k++)
+		
+		// classes where both alphas are zero do not contribute to any of the sums below
+		alignAlphas((*v)[merge1], (*v)[i], &alphas1, &alphas2);
+		for (unsigned int k = 0; k < alphas1.size(); k++)
 		{
-			d = (*v)[merge1]->alphas[k] + (*v)[i]->alphas[k];
+			d = alphas1[k] + alphas2[k];
 			if (d == 0)
 			{
 				d = 0.0001;
 			}
-			a1 += (*v)[merge1]->alphas[k] / d;
-			a2 += (*v)[i]->alphas[k] / d;
+			a1 += alphas1[k] / d;
+			a2 += alphas2[k] / d;
 		}
 
 		if (a1 * a2 > 0)
@@ -473,10 +1299,10 @@ long double* computeKmax(vector <budgetedVectorBSGD*>* v, unsigned int merge1, p
 		kZ2 = (long double) pow(k12, kMax * kMax);
 
 		loss = 0.0;
-		for (unsigned int k = 0; k < (*v)[i]->alphas.size(); k++)
+		for (unsigned int k = 0; k < alphas1.size(); k++)
 		{
-			zAlpha = (*v)[merge1]->alphas[k] * kZ1 + (*v)[i]->alphas[k] * kZ2;
-			loss += pow((*v)[merge1]->alphas[k], 2) + pow((*v)[i]->alphas[k], 2) + 2.0L * k12 * (*v)[merge1]->alphas[k] * (*v)[i]->alphas[k] - zAlpha * zAlpha;
+			zAlpha = alphas1[k] * kZ1 + alphas2[k] * kZ2;
+			loss += pow(alphas1[k], 2) + pow(alphas2[k], 2) + 2.0L * k12 * alphas1[k] * alphas2[k] - zAlpha * zAlpha;
 		}
 
 		if (loss < lossMin)
@@ -499,6 +1325,130 @@ long double* computeKmax(vector <budgetedVectorBSGD*>* v, unsigned int merge1, p
 	return returnValues;
 }
 
+/*! \fn unsigned int maintainBudget(vector <budgetedVectorBSGD*>* v, budgetedHashIndexBSGD *svIndex, budgetedInvertedIndexBSGD *svInvertedIndex, budgetedVectorBSGD *sameVector, parameters *param)
+	\brief Performs budget maintenance, bringing the number of support vectors back to the budget size.
+	\param [in,out] v Support vector set, where the last element is the most recently added support vector.
+	\param [in,out] svIndex Hash index of the support vector set, kept in sync with the removed and merged support vectors.
+	\param [in,out] svInvertedIndex Inverted index of the support vector set, kept in sync in the same way as svIndex; NULL if the inverted index is not used.
+	\param [in] sameVector Support vector identical to the most recently added one, NULL if there is no such support vector.
+	\param [in] param The parameters of the algorithm.
+	\return Number of performed budget maintenance steps.
+
+	If there is a support vector identical to the most recently added one, the two are combined (or the newer one is simply removed in the case of removal strategy) and
+	nothing else is done. Otherwise, removal or merging steps are repeated until there are exactly \link parameters::BUDGET_SIZE \endlink support vectors left. In the case of removal
+	this is the single maintenance pass used when \link parameters::BUDGET_SLACK \endlink is positive, where the removal scores are computed only once per pass and all the removed
+	support vectors are found with a single partial sort. The slack is not allowed with merging, since each merge searches the whole support vector set for the second vector, and
+	a single merge step is performed every time the budget is exceeded.
+*/
+unsigned int maintainBudget(vector <budgetedVectorBSGD*>* v, budgetedHashIndexBSGD *svIndex, budgetedInvertedIndexBSGD *svInvertedIndex, budgetedVectorBSGD *sameVector, parameters *param)
+{
+	unsigned int i, k, numSVs = (unsigned int) (*v).size(), numSteps = 0, merge1, merge2;
+	long double kMax, kZ1, kZ2;
+
+	if (sameVector != NULL)
+	{
+		// there is already an identical vector in the SV set; in the case of merging we simply add up their alphas and there is no need for moving
+		//	the vector, while in the case of removal we just remove the newly added vector
+		merge2 = numSVs - 1;
+		if ((*param).MAINTENANCE_SAMPLING_STRATEGY == BUDGET_MAINTAIN_MERGE)
+			sameVector->combineAlphas((*v)[merge2], 1.0, 1.0);
+
+		svIndex->removeVector((*v)[merge2]);
+		if (svInvertedIndex)
+			svInvertedIndex->removeVector((*v)[merge2]);
+		delete (*v)[merge2];
+		(*v).pop_back();
+		return 1;
+	}
+
+	switch ((*param).MAINTENANCE_SAMPLING_STRATEGY)
+	{
+		case BUDGET_MAINTAIN_REMOVE:
+		{
+			// compute product between norm of alpha vector and a self-kernel for each SV, and remove all SVs with the smallest
+			//	products at once; ties are broken in favor of the SV with the smaller index
+			vector < pair <long double, unsigned int> > removalScores(numSVs);
+			vector <bool> removeSV(numSVs, false);
+			unsigned int numRemoved = numSVs - (*param).BUDGET_SIZE;
+
+			for (i = 0; i < numSVs; i++)
+				removalScores[i] = make_pair((*v)[i]->alphaNorm() * (*v)[i]->computeKernel((*v)[i], param), i);
+			partial_sort(removalScores.begin(), removalScores.begin() + numRemoved, removalScores.end());
+
+			for (i = 0; i < numRemoved; i++)
+			{
+				removeSV[removalScores[i].second] = true;
+				svIndex->removeVector((*v)[removalScores[i].second]);
+				if (svInvertedIndex)
+					svInvertedIndex->removeVector((*v)[removalScores[i].second]);
+				delete (*v)[removalScores[i].second];
+			}
+
+			// compact the SV set in a single pass
+			k = 0;
+			for (i = 0; i < numSVs; i++)
+			{
+				if (!removeSV[i])
+					(*v)[k++] = (*v)[i];
+			}
+			(*v).resize(k);
+			numSteps = numRemoved;
+			break;
+		}
+
+		case BUDGET_MAINTAIN_MERGE:
+		{
+			// alpha norms are computed once, and after each merge only the norm of the merged SV is recomputed; each merge is a full
+			//	computeKmax() sweep over the SV set, which is why the budget slack is allowed only with removal
+			vector <long double> alphaNorms(numSVs);
+			for (i = 0; i < numSVs; i++)
+				alphaNorms[i] = (*v)[i]->alphaNorm();
+
+			while (numSVs > (*param).BUDGET_SIZE)
+			{
+				// find the one with smallest alpha, this is the one we merge
+				merge1 = 0;
+				for (i = 1; i < numSVs; i++)
+				{
+					if (alphaNorms[merge1] > alphaNorms[i])
+						merge1 = i;
+				}
+
+				// find with who to merge, as well as other useful information detailed in the definition of computeKmax() found in this file
+				long double* returnValues = computeKmax(v, merge1, param);
+				kMax = (*returnValues);
+				kZ1 = (*(returnValues + 1));
+				kZ2 = (*(returnValues + 2));
+				merge2 = (unsigned int) (*(returnValues + 3));
+				delete [] returnValues;
+
+				// find z, the new support vector; it is re-indexed since its content hash and non-zero elements change with merging
+				svIndex->removeVector((*v)[merge1]);
+				if (svInvertedIndex)
+					svInvertedIndex->removeVector((*v)[merge1]);
+				(*v)[merge1]->updateSV((*v)[merge2], kMax);
+				svIndex->addVector((*v)[merge1]);
+				if (svInvertedIndex)
+					svInvertedIndex->addVector((*v)[merge1]);
+				(*v)[merge1]->combineAlphas((*v)[merge2], kZ1, kZ2);
+				alphaNorms[merge1] = (*v)[merge1]->alphaNorm();
+
+				// delete 'merge2', not needed anymore
+				svIndex->removeVector((*v)[merge2]);
+				if (svInvertedIndex)
+					svInvertedIndex->removeVector((*v)[merge2]);
+				delete (*v)[merge2];
+				(*v).erase((*v).begin() + merge2);
+				alphaNorms.erase(alphaNorms.begin() + merge2);
+				numSVs--;
+				numSteps++;
+			}
+			break;
+		}
+	}
+	return numSteps;
+}
+
 /* \fn float predictBSGD(budgetedData *testData, parameters *param, budgetedModel *model, vector <int> *labels, vector <float> *scores)
 	\brief Given a BSGD model, predict the labels of testing data.
 	\param [in] testData Input test data.
@@ -513,23 +1463,30 @@ long double* computeKmax(vector <budgetedVectorBSGD*>* v, unsigned int merge1, p
 float predictBSGD(budgetedData *testData, parameters *param, budgetedModelBSGD *model, vector <int> *labels, vector <float> *scores)
 {
     unsigned long timeCalc = 0, start;
-    unsigned int i, N, err = 0, total = 0;
-	long double fx, maxFx, tempSqrNorm = 0.0, *tempArray;
+    unsigned int N, err = 0, total = 0;
+	long double fx, maxFx, tempSqrNorm = 0.0, kernelValue;
 	bool stillChunksLeft = true;
 	char text[1024];
 	unsigned int y;
 	budgetedVectorBSGD *currentDataPoint = NULL;
+	budgetedVectorBSGD *currentSV = NULL;
+	budgetedInvertedIndexBSGD *svInvertedIndex = NULL;
 	long double *classMaxScores = new long double[(testData->yLabels).size()];
-
-	// this tempArray is used when calculating all class scores, to avoid repeated computations of the same kernel
-	tempArray = new long double[(*(model->modelBSGD)).size()];
-	for (i = 0; i < (*(model->modelBSGD)).size(); i++)
-		tempArray[i] = 0.0;
+	
+	// scores of all classes for the current data point
+	vector <long double> classScores((testData->yLabels).size(), 0.0);
 
 	while (stillChunksLeft)
 	{
         stillChunksLeft = testData->readChunk((*param).CHUNK_SIZE);
 		(*param).updateVerySparseDataParameter(testData->getSparsity());
+		
+		// on very sparse data compute the kernels from the dot products accumulated over the inverted index of the SVs
+		if ((svInvertedIndex == NULL) && ((*param).VERY_SPARSE_DATA == 1) && ((*param).KERNEL != KERNEL_FUNC_USER_DEFINED))
+		{
+			svInvertedIndex = new budgetedInvertedIndexBSGD();
+			svInvertedIndex->rebuild(model->modelBSGD);
+		}
 
         N = testData->N;
         total += N;
@@ -543,6 +1500,8 @@ float predictBSGD(budgetedData *testData, parameters *param, budgetedModelBSGD *
 				// 	computations, here we compute it just once; no need to do it in non-sparse case, since this norm can be retrieved directly
 				// 	from budgetedVector
 				tempSqrNorm = testData->getVectorSqrL2Norm(r, param);
+				if (svInvertedIndex)
+					svInvertedIndex->computeDotProducts(r, testData, param);
 			}
 			else
 			{
@@ -553,33 +1512,40 @@ float predictBSGD(budgetedData *testData, parameters *param, budgetedModelBSGD *
 
     		y = 0;
     		maxFx = -INF;
-			for (i = 0; i < (*(model->modelBSGD)).size(); i++)
-				tempArray[i] = 0.0;
+			for (unsigned int k = 0; k < (testData->yLabels).size(); k++)
+				classScores[k] = 0.0;
+			
+			// each SV contributes only to the classes where it has non-zero alphas, and the kernel is computed only for SVs with any non-zero alpha
+			for (unsigned int i = 0; i < (*(model->modelBSGD)).size(); i++)
+			{
+				currentSV = (*(model->modelBSGD))[i];
+				if (currentSV->getNumNonZeroAlphas() == 0)
+					continue;
+				
+				if (svInvertedIndex)
+				{
+					// compute kernel from the dot product found using the inverted index
+					kernelValue = svInvertedIndex->computeKernel(currentSV, tempSqrNorm, param);
+				}
+				else if ((*param).VERY_SPARSE_DATA)
+				{
+					// directly compute kernel from the trainData
+					kernelValue = currentSV->computeKernel(r, testData, param, tempSqrNorm);
+				}
+				else
+				{
+					// compute kernel from currentDataPoint object
+					kernelValue = currentSV->computeKernel(currentDataPoint, param);
+				}
+				
+				for (unsigned int j = 0; j < currentSV->getNumNonZeroAlphas(); j++)
+					classScores[currentSV->getAlphaClass(j)] += (currentSV->getAlphaValue(j) * kernelValue);
+			}
 
     		for (unsigned int k = 0; k < (testData->yLabels).size(); k++)
     		{
 				classMaxScores[k] = -INF;
-				fx = 0;
-				for (unsigned int i = 0; i < (*(model->modelBSGD)).size(); i++)
-				{
-					if ((*(model->modelBSGD))[i]->alphas[k] != 0)
-					{
-						if (tempArray[i] == 0.0)
-						{
-							if ((*param).VERY_SPARSE_DATA)
-							{
-								// directly compute kernel from the trainData
-								tempArray[i] = (*((*model).modelBSGD))[i]->computeKernel(r, testData, param, tempSqrNorm);
-							}
-							else
-							{
-								// compute kernel from currentDataPoint object
-								tempArray[i] = (*(model->modelBSGD))[i]->computeKernel(currentDataPoint, param);
-							}
-						}
-						fx += ((*(model->modelBSGD))[i]->alphas[k] * tempArray[i]);
-					}
-				}
+				fx = classScores[k];
 
 				if (fx > maxFx)
 				{
@@ -630,8 +1596,9 @@ float predictBSGD(budgetedData *testData, parameters *param, budgetedModelBSGD *
         }
     }
 	testData->flushData();
-	delete [] tempArray;
 	delete[] classMaxScores;
+	if (svInvertedIndex)
+		delete svInvertedIndex;
 
 	if ((*param).VERBOSE)
     {
@@ -653,19 +1620,18 @@ float predictBSGD(budgetedData *testData, parameters *param, budgetedModelBSGD *
 void trainBSGD(budgetedData *trainData, parameters *param, budgetedModelBSGD *model)
 {
 	unsigned long timeCalc = 0, start;
-	long double fxValue, fxValue1, fxValue2, maxFx, *tempArray, alphaSmallest = 0.0, tempLongDouble = 0.0;
-	unsigned int i1, i2 = 0, t, temp, countDel = 0, numClasses = 0, numSVs = 0, numIter = 0, N, deleteWeight = 0;
+	long double fxValue, fxValue1, fxValue2, maxFx, kernelValue, tempLongDouble = 0.0;
+	unsigned int i1, i2 = 0, t, temp, countDel = 0, numClasses = 0, numSVs = 0, numIter = 0, N;
 	bool stillChunksLeft = true;
 	char text[1024];
 	unsigned int i, k, ot; 	//iterators
 	budgetedVectorBSGD *currentDataPoint = NULL;
-	int indexOfSameVector = -1;	// this variable keeps the index of the *exact same* vector in the SV set, when compared to input point.
-								//	so when we observe budget overflow we merge these two if merging strategy is set
-
-	// this tempArray is used when calculating all class scores and runner-up, to avoid repeated computations of the same kernel
-	tempArray = new long double[(*param).BUDGET_SIZE];
-	for (i = 0; i < (*param).BUDGET_SIZE; i++)
-		tempArray[i] = 0.0;
+	budgetedVectorBSGD *currentSV = NULL;
+	budgetedVectorBSGD *sameVector = NULL;	// this variable keeps the *exact same* vector in the SV set, when compared to input point.
+											//	so when we observe budget overflow we merge these two if merging strategy is set
+	budgetedHashIndexBSGD svIndex;	// hash index of the SV set, used to find the exact same vector in the SV set without computing any kernels
+	budgetedInvertedIndexBSGD *svInvertedIndex = NULL;	// inverted index of the SV set, used to compute kernels with all SVs at once on very sparse data
+	vector <long double> classScores;	// scores of all classes for the current data point, used to find the runner-up class
 
 	for (unsigned int epoch = 0; epoch < (*param).NUM_EPOCHS; epoch++)
 	{
@@ -678,6 +1644,14 @@ void trainBSGD(budgetedData *trainData, parameters *param, budgetedModelBSGD *mo
 			// update the VERY_SPARSE parameter, it is used to speed up the computations of kernels
 			//	(of course, in the case of AMM, speeds up linear kernel computation)
 			(*param).updateVerySparseDataParameter(trainData->getSparsity());
+			
+			// on very sparse data most of the SVs do not share any features with the incoming data point, so the kernels are computed
+			//	from the dot products accumulated over the inverted index, which never visits such SVs
+			if ((svInvertedIndex == NULL) && ((*param).VERY_SPARSE_DATA == 1) && ((*param).KERNEL != KERNEL_FUNC_USER_DEFINED))
+			{
+				svInvertedIndex = new budgetedInvertedIndexBSGD();
+				svInvertedIndex->rebuild((*model).modelBSGD);
+			}
 
 			// compute observed data dimensionality, where we also account for possible bias term, and check if
 			//	we need to expand the current model weights if some new data dimensions were found during loading
@@ -690,20 +1664,21 @@ void trainBSGD(budgetedData *trainData, parameters *param, budgetedModelBSGD *mo
 
 				// update the dimensionality
 				(*param).DIMENSION = temp;
+				
+				// the bias term has been moved to the new last element of each SV, which changes their content hashes as well
+				for (i = 0; i < (*((*model).modelBSGD)).size(); i++)
+					(*((*model).modelBSGD))[i]->updateContentHash();
+				svIndex.rebuild((*model).modelBSGD);
+				if (svInvertedIndex)
+					svInvertedIndex->rebuild((*model).modelBSGD);
 			}
 
 			N = trainData->N;
-			if (numIter == 0)
-				numClasses = (unsigned int) trainData->yLabels.size();
-			else if (numClasses != (unsigned int) trainData->yLabels.size())
-			{
-				// if in the earlier chunks some class wasn't observed, it could happen with small chunks or unbalanced classes;
-				// just add new zero alphas for the new classes to each support vector
-				for (unsigned int i = 0; i < numSVs; i++)
-					for (unsigned int k = 0; k < (trainData->yLabels.size() - numClasses); k++)
-						(*((*model).modelBSGD))[i]->alphas.push_back(0.0);
-				numClasses = (unsigned int) trainData->yLabels.size();
-			}
+			
+			// if in the earlier chunks some class wasn't observed, it could happen with small chunks or unbalanced classes; as only
+			//	non-zero alphas are stored, nothing needs to be done with the existing support vectors
+			numClasses = (unsigned int) trainData->yLabels.size();
+			classScores.resize(numClasses, 0.0);
 			
 			// randomize
 			vector <unsigned int> tv(N, 0);
@@ -720,18 +1695,22 @@ void trainBSGD(budgetedData *trainData, parameters *param, budgetedModelBSGD *mo
 				t = tv[ot];
 				numIter++;
 				
-				// initialize the first weight
+				// initialize the first weight; on very sparse data the support vectors are stored as sorted arrays of their non-zero
+				//	elements instead of vector chunks, see budgetedVectorBSGD::sparseStorage
 				if (numIter == 1)
 				{
-					currentDataPoint = new budgetedVectorBSGD((*param).DIMENSION, (*param).CHUNK_WEIGHT, numClasses);
+					currentDataPoint = new budgetedVectorBSGD((*param).DIMENSION, (*param).CHUNK_WEIGHT, numClasses, (*param).VERY_SPARSE_DATA == 1);
 					currentDataPoint->createVectorUsingDataPoint(trainData, t, param);
 
 					i1 = trainData->al[t];
 					i2 = (i1 + 1) % numClasses;
-					currentDataPoint->alphas[i1] = 1.0;
-					currentDataPoint->alphas[i2] = -1.0;
+					currentDataPoint->setAlpha(i1, 1.0);
+					currentDataPoint->setAlpha(i2, -1.0);
 
 					(*((*model).modelBSGD)).push_back(currentDataPoint);
+					svIndex.addVector(currentDataPoint);
+					if (svInvertedIndex)
+						svInvertedIndex->addVector(currentDataPoint);
 					currentDataPoint = NULL;
 					numSVs++;
 					continue;
@@ -742,8 +1721,8 @@ void trainBSGD(budgetedData *trainData, parameters *param, budgetedModelBSGD *mo
 				fxValue1 = 0.0;
 				fxValue2 = 0.0;
 				maxFx = -INF;
-				for (i = 0; i < numSVs; i++)
-					tempArray[i] = 0.0;
+				for (k = 0; k < numClasses; k++)
+					classScores[k] = 0.0;
 				
 				if ((*param).VERY_SPARSE_DATA)
 				{
@@ -751,54 +1730,46 @@ void trainBSGD(budgetedData *trainData, parameters *param, budgetedModelBSGD *mo
 					// 	computations, here we compute it just once; no need to do it in non-sparse case, since this norm can be retrieved directly
 					// 	from budgetedVector
 					tempLongDouble = trainData->getVectorSqrL2Norm(t, param);
+					if (svInvertedIndex)
+						svInvertedIndex->computeDotProducts(t, trainData, param);
 				}
 				else
 				{
 					// create the budgetedVector using the vector from budgetedData, to be used in gaussianKernel() method below
-					currentDataPoint = new budgetedVectorBSGD((*param).DIMENSION, (*param).CHUNK_WEIGHT, numClasses);
+					currentDataPoint = new budgetedVectorBSGD((*param).DIMENSION, (*param).CHUNK_WEIGHT, numClasses, (*param).VERY_SPARSE_DATA == 1);
 					currentDataPoint->createVectorUsingDataPoint(trainData, t, param);
 				}
 
-				indexOfSameVector = -1;
-				for (k = 0; k < numClasses; k++)
+				// each SV contributes only to the classes where it has non-zero alphas, and the kernel is computed only for SVs with any non-zero alpha
+				for (i = 0; i < numSVs; i++)
 				{
-					fxValue = 0.0;
-					for (i = 0; i < numSVs; i++)
+					currentSV = (*((*model).modelBSGD))[i];
+					if (currentSV->getNumNonZeroAlphas() == 0)
+						continue;
+					
+					if (svInvertedIndex)
+					{
+						// compute kernel from the dot product found using the inverted index
+						kernelValue = svInvertedIndex->computeKernel(currentSV, tempLongDouble, param);
+					}
+					else if ((*param).VERY_SPARSE_DATA)
 					{
-						if ((*((*model).modelBSGD))[i]->alphas[k] != 0)
-						{
-							// calculate the kernel only if not computed earlier
-							if (tempArray[i] == 0.0)
-							{
-								if ((*param).VERY_SPARSE_DATA)
-								{
-									// directly compute kernel from the trainData
-									tempArray[i] = (*((*model).modelBSGD))[i]->computeKernel(t, trainData, param, tempLongDouble);
-									
-									// check if the two vectors are identical, if they are then we consider these two vectors when budget overflow
-									//	happens (we round to 8th digit due to round-off errors in floating-point representation, observed in practice)
-									if ((int) ((*((*model).modelBSGD))[i]->gaussianKernel(t, trainData, param, tempLongDouble) * 100000000.0 + 0.5) == 100000000)
-									{
-										indexOfSameVector = i;
-									}
-								}
-								else
-								{
-									// compute kernel from currentDataPoint object
-									tempArray[i] = (*((*model).modelBSGD))[i]->computeKernel(currentDataPoint, param);
-									
-									// check if the two vectors are identical, if they are then we consider these two vectors when budget overflow
-									//	happens (we round to 8th digit due to round-off errors in floating-point representation, observed in practice)
-									if ((int) ((*((*model).modelBSGD))[i]->gaussianKernel(currentDataPoint, param) * 100000000.0 + 0.5) == 100000000)
-									{
-										indexOfSameVector = i;
-									}
-								}
-							}
-							fxValue += ((*((*model).modelBSGD))[i]->alphas[k] * tempArray[i]);
-						}
+						// directly compute kernel from the trainData
+						kernelValue = currentSV->computeKernel(t, trainData, param, tempLongDouble);
 					}
+					else
+					{
+						// compute kernel from currentDataPoint object
+						kernelValue = currentSV->computeKernel(currentDataPoint, param);
+					}
+					
+					for (k = 0; k < currentSV->getNumNonZeroAlphas(); k++)
+						classScores[currentSV->getAlphaClass(k)] += (currentSV->getAlphaValue(k) * kernelValue);
+				}
 
+				for (k = 0; k < numClasses; k++)
+				{
+					fxValue = classScores[k];
 					if (k == i1)
 						fxValue1 = fxValue;
 					else if (fxValue > maxFx)
@@ -819,98 +1790,32 @@ void trainBSGD(budgetedData *trainData, parameters *param, budgetedModelBSGD *mo
 					{
 						// only do this if data is sparse, since if non-sparse than we already have currentDataPoint initialized
 						// 	from the code before the loop in which we computed kernels
-						currentDataPoint = new budgetedVectorBSGD((*param).DIMENSION, (*param).CHUNK_WEIGHT, numClasses);
+						currentDataPoint = new budgetedVectorBSGD((*param).DIMENSION, (*param).CHUNK_WEIGHT, numClasses, (*param).VERY_SPARSE_DATA == 1);
 						currentDataPoint->createVectorUsingDataPoint(trainData, t, param);
 					}
 
 					// add an SV
-					currentDataPoint->alphas[i1] =  1.0 / ((long double)numIter * (*param).LAMBDA_PARAM);
-					currentDataPoint->alphas[i2] = -1.0 / ((long double)numIter * (*param).LAMBDA_PARAM);
+					currentDataPoint->setAlpha(i1,  1.0 / ((long double)numIter * (*param).LAMBDA_PARAM));
+					currentDataPoint->setAlpha(i2, -1.0 / ((long double)numIter * (*param).LAMBDA_PARAM));
+					// check if there is an identical vector in the SV set, if there is then we consider these two vectors when budget overflow
+					//	happens; only SVs with the same content hash need to be compared with the input point
+					sameVector = NULL;
+					if (numSVs >= (*param).BUDGET_SIZE)
+						sameVector = svIndex.findDataPoint(currentDataPoint->getContentHash(), trainData, t, param);
+
 					(*((*model).modelBSGD)).push_back(currentDataPoint);
+					svIndex.addVector(currentDataPoint);
+					if (svInvertedIndex)
+						svInvertedIndex->addVector(currentDataPoint);
 					currentDataPoint = NULL;
 					numSVs++;
 
-					// if over the budget, maintain the budget
-					if (numSVs > (*param).BUDGET_SIZE)
+					// if over the budget and the budget slack, maintain the budget; an SV identical to an existing one is combined with it
+					//	as soon as the budget is exceeded, since this is a cheap step that does not require a pass over the SV set
+					if ((numSVs > (*param).BUDGET_SIZE + (*param).BUDGET_SLACK) || ((sameVector != NULL) && (numSVs > (*param).BUDGET_SIZE)))
 					{
-						switch ((*param).MAINTENANCE_SAMPLING_STRATEGY)
-						{
-							case BUDGET_MAINTAIN_REMOVE:
-								// removal of random support vector
-								if (indexOfSameVector == -1)
-								{
-									// so there are no two identical vectors, remove the smallest one
-									alphaSmallest = INF;
-									for (i = 0; i < numSVs; i++)
-									{
-										// compute product between norm of alpha vector and a self-kernel
-										tempLongDouble = (*((*model).modelBSGD))[i]->alphaNorm() * (*((*model).modelBSGD))[i]->computeKernel((*((*model).modelBSGD))[i], param);
-										if (alphaSmallest > tempLongDouble)
-										{
-											alphaSmallest = tempLongDouble;
-											deleteWeight = i;
-										}
-									}
-								}
-								else
-								{
-									// since there is already an identical vector in the SV set, remove the newly added vector
-									deleteWeight = (*param).BUDGET_SIZE;
-								}
-
-								delete (*((*model).modelBSGD))[deleteWeight];
-								(*((*model).modelBSGD)).erase((*((*model).modelBSGD)).begin() + deleteWeight);
-								break;
-
-							case BUDGET_MAINTAIN_MERGE:
-								// merging of two SVs
-								long double kMax, kZ1, kZ2;
-								unsigned int merge1, merge2;
-
-								if (indexOfSameVector == -1)
-								{
-									// so there are no two identical vectors. find the one with smallest alpha
-									// here we look for who to merge
-									merge1 = 0;
-									for (i = 0; i < numSVs; i++)
-									{
-										tempLongDouble = (*((*model).modelBSGD))[i]->alphaNorm();
-										if ((alphaSmallest > tempLongDouble) || (i == 0))
-										{
-											alphaSmallest = tempLongDouble;
-											merge1 = i;
-										}
-									}
-
-									// find with who to merge, as well as other useful information detailed in the definition of computeKmax() found in this file
-									long double* returnValues = computeKmax((*model).modelBSGD, merge1, param);
-									kMax = (*returnValues);
-									kZ1 = (*(returnValues + 1));
-									kZ2 = (*(returnValues + 2));
-									merge2 = (unsigned int) (*(returnValues + 3));
-									delete [] returnValues;
-
-									// find z, the new support vector
-									(*((*model).modelBSGD))[merge1]->updateSV((*((*model).modelBSGD))[merge2], kMax);
-									for (unsigned int k = 0; k < numClasses; k++)
-										(*((*model).modelBSGD))[merge1]->alphas[k] = (*((*model).modelBSGD))[merge1]->alphas[k] * kZ1 + (*((*model).modelBSGD))[merge2]->alphas[k] * kZ2;
-								}
-								else
-								{
-									// in this case the two merging vectors are identical, so we simply add up their alphas and there is no need for moving the vector
-									merge1 = indexOfSameVector;
-									merge2 = (*param).BUDGET_SIZE;
-									for (unsigned int k = 0; k < numClasses; k++)
-										(*((*model).modelBSGD))[merge1]->alphas[k] = (*((*model).modelBSGD))[merge1]->alphas[k] + (*((*model).modelBSGD))[merge2]->alphas[k];
-								}
-
-								// delete 'merge2', not needed anymore
-								delete (*((*model).modelBSGD))[merge2];
-								(*((*model).modelBSGD)).erase((*((*model).modelBSGD)).begin() + merge2);
-								break;
-						}
-						numSVs--;
-						countDel++;
+						countDel += maintainBudget((*model).modelBSGD, &svIndex, svInvertedIndex, sameVector, param);
+						numSVs = (unsigned int) (*((*model).modelBSGD)).size();
 					}
 				}
 				else
@@ -938,7 +1843,18 @@ void trainBSGD(budgetedData *trainData, parameters *param, budgetedModelBSGD *mo
 			svmPrintString(text);
 		}
 	}
-	delete [] tempArray;
+	
+	// the budget slack allows only a temporary excess of SVs during training, so the returned model is brought back to the budget size
+	if (numSVs > (*param).BUDGET_SIZE)
+	{
+		start = clock();
+		countDel += maintainBudget((*model).modelBSGD, &svIndex, svInvertedIndex, NULL, param);
+		numSVs = (unsigned int) (*((*model).modelBSGD)).size();
+		timeCalc += clock() - start;
+	}
+	
+	if (svInvertedIndex)
+		delete svInvertedIndex;
 	trainData->flushData();
 
 	if ((*param).VERBOSE && ((*param).NUM_EPOCHS > 1))
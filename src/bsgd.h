@@ -22,30 +22,72 @@ extern "C" {
 
 /*! \class budgetedVectorBSGD
     \brief Class which holds sparse vector, which is split into a number of arrays to trade-off between speed of access and memory usage of sparse data, with added methods for BSGD algorithm.
+	
+	On very sparse, high-dimensional data even a single non-zero feature requires allocation of the entire vector chunk of \link parameters::CHUNK_WEIGHT \endlink elements. For this reason
+	the vector can alternatively be stored in a truly sparse form, as sorted arrays of indices and values of its non-zero elements (see \link sparseStorage \endlink). In this case no vector
+	chunks are allocated at all, merging of two vectors becomes a sorted union of their non-zero elements, and kernels are computed by walking the sorted arrays in parallel.
 */
 class budgetedVectorBSGD : public budgetedVector
 {
 	// friends so that they can set sqrL2norm property during model loading
 	friend class budgetedModelBSGD;
 	friend class budgetedModelMatlabBSGD;
+	// friend so that it can assign invertedIndexSlot property
+	friend class budgetedInvertedIndexBSGD;
 	
 	/*! \var static unsigned int numClasses
-		\brief Number of classes of the classification problem, specifies the size of \link alphas \endlink vector.
+		\brief Number of classes of the classification problem, specifies the largest number of non-zero alpha parameters.
+	*/
+	/*! \var vector <unsigned int> alphaClasses
+		\brief Sorted indices of classes with non-zero class-specific alpha parameters, used in BSGD algorithm.
+		
+		Each alpha parameter specifies the influence a \link budgetedVector \endlink has on a specific class. A new support vector has only two non-zero alphas (for the true
+		class and for the runner-up class), and merging two support vectors results in a union of their non-zero alphas. As most of the alphas remain zero when there are many
+		classes, only the non-zero alphas are kept, in \link alphaClasses \endlink and \link alphaValues \endlink. \sa getAlpha, setAlpha
+	*/
+	/*! \var vector <long double> alphaValues
+		\brief Non-zero class-specific alpha parameters, given in order of \link alphaClasses \endlink.
 	*/
-	/*! \var vector <double> alphas
-		\brief Array of class-specific alpha parameters, used in BSGD algorithm.
+	/*! \var unsigned int contentHash
+		\brief Order-independent hash of the non-zero elements of the vector, used to quickly find support vectors that are identical to an incoming data point.
 		
-		This vector is of the size that equals number of classes in the data set. Each element specifies the influence a \link budgetedVector \endlink has on a specific class.
+		Kept up to date when the vector is created from a data point and when it is modified by merging, so that during budget maintenance a duplicate of the incoming data point
+		can be found with a single lookup into a hash index of support vectors, instead of computing one more kernel against every support vector. \sa hashDataPoint, updateContentHash
+	*/
+	/*! \var unsigned int numNonZeros
+		\brief Number of non-zero elements of the vector, computed together with \link contentHash \endlink and used to confirm that a hash match is an exact duplicate.
+	*/
+	/*! \var bool sparseStorage
+		\brief If true, the vector is stored in \link sparseIndices \endlink and \link sparseValues \endlink arrays instead of vector chunks.
+		
+		Set when the vector is created and never changed afterwards. During training the sparse storage is used when the data is found to be very sparse (see \link parameters::VERY_SPARSE_DATA \endlink),
+		while during model loading it is chosen for each support vector separately, see \link useSparseStorage \endlink.
+	*/
+	/*! \var vector <unsigned int> sparseIndices
+		\brief Sorted indices of non-zero elements of the vector, used only when \link sparseStorage \endlink is set.
+	*/
+	/*! \var vector <float> sparseValues
+		\brief Values of non-zero elements of the vector, given in order of \link sparseIndices \endlink, used only when \link sparseStorage \endlink is set.
+	*/
+	/*! \var unsigned int invertedIndexSlot
+		\brief Slot of the vector in \link budgetedInvertedIndexBSGD \endlink, assigned when the vector is added to the inverted index.
 	*/
 	protected:
 		static unsigned int numClasses;
+		unsigned int contentHash;
+		unsigned int numNonZeros;
+		bool sparseStorage;
+		vector <unsigned int> sparseIndices;
+		vector <float> sparseValues;
+		unsigned int invertedIndexSlot;
+		vector <unsigned int> alphaClasses;
+		vector <long double> alphaValues;
 		
 	public:
-    	vector <long double> alphas; 
 		
 		/*! \fn unsigned int getNumClasses(void)
 			\brief Get the number of classes in the classification problem.
-			\return Number of classes that are covered by this vector, also the length of \link alphas \endlink.
+			\return Number of classes that are covered by this vector.
 		*/	
 		static unsigned int getNumClasses(void)
 		{
@@ -62,26 +104,213 @@ class budgetedVectorBSGD : public budgetedVector
 		*/	
 		void updateSV(budgetedVectorBSGD* v, long double kMax);
  
-    	/*! \fn budgetedVectorBSGD(unsigned long dim = 0, unsigned long chnkWght = 0, unsigned int numCls = 0) : budgetedVector(dim, chnkWght)
+    	/*! \fn budgetedVectorBSGD(unsigned long dim = 0, unsigned long chnkWght = 0, unsigned int numCls = 0, bool sparse = false) : budgetedVector(dim, chnkWght)
 			\brief Constructor, initializes the vector to all zeros, and also initializes class-specific alpha parameters.
 			\param [in] dim Dimensionality of the vector.
 			\param [in] chnkWght Size of each vector chunk.
-			\param [in] numCls Number of classes in the classification problem, specifies the size of \link alphas \endlink vector.
+			\param [in] numCls Number of classes in the classification problem.
+			\param [in] sparse If true, the vector is stored as sorted arrays of indices and values of non-zero elements instead of vector chunks. \sa sparseStorage
 		*/
-		budgetedVectorBSGD(unsigned int dim = 0, unsigned int chnkWght = 0, unsigned int numCls = 0) : budgetedVector(dim, chnkWght)
+		budgetedVectorBSGD(unsigned int dim = 0, unsigned int chnkWght = 0, unsigned int numCls = 0, bool sparse = false) : budgetedVector(dim, chnkWght)
 		{
 			if (numClasses == 0)
 				numClasses = numCls;
 			
-			for (unsigned int i = 0; i < numClasses; i++)
-				this->alphas.push_back(0.0);
+			contentHash = 0;
+			numNonZeros = 0;
+			invertedIndexSlot = 0;
+			
+			// sparse vectors do not use vector chunks at all
+			sparseStorage = sparse;
+			if (sparseStorage)
+			{
+				array.clear();
+				arrayLength = 0;
+			}
+		}
+		
+		/*! \fn static bool useSparseStorage(unsigned int numNonZero, unsigned int dim)
+			\brief Decides if a vector with a given number of non-zero elements should use sparse storage, used during model loading.
+			\param [in] numNonZero Number of non-zero elements of the vector.
+			\param [in] dim Dimensionality of the vector.
+			\return True if less than 5% of the elements of the vector are non-zero, same threshold as used for \link parameters::VERY_SPARSE_DATA \endlink.
+		*/
+		static bool useSparseStorage(unsigned int numNonZero, unsigned int dim)
+		{
+			return (100.0 * (double) numNonZero < 5.0 * (double) dim);
+		}
+		
+		/*! \fn bool isSparse(void)
+			\brief Returns \link sparseStorage \endlink, indicating if the vector is stored as sorted arrays of non-zero elements.
+			\return True if the vector uses sparse storage, otherwise false.
+		*/
+		bool isSparse(void)
+		{
+			return sparseStorage;
+		}
+		
+		/*! \fn float getElement(unsigned int idx)
+			\brief Returns an element of the vector, regardless of the way the vector is stored.
+			\param [in] idx Index of vector element that is retrieved.
+			\return Value of the element of the vector.
+		*/
+		float getElement(unsigned int idx);
+		
+		/*! \fn void setElement(unsigned int idx, float value)
+			\brief Sets an element of the vector, regardless of the way the vector is stored; used during model loading.
+			\param [in] idx Index of vector element that is modified.
+			\param [in] value New value of the element.
+			
+			Note that the squared norm of the vector is not updated. In the case of sparse storage the insertion is constant-time if the elements are set in order of increasing indices.
+		*/
+		void setElement(unsigned int idx, float value);
+		
+		/*! \fn virtual void getNonZeroElements(vector <unsigned int> *indices, vector <float> *values)
+			\brief Returns all non-zero elements of the vector in order of increasing indices, regardless of the way the vector is stored; used when saving the model.
+			\param [out] indices Indices of the non-zero elements.
+			\param [out] values Values of the non-zero elements.
+			
+			Sparse storage is listed here, while for chunked storage the implementation of the base class is used. \sa budgetedVector::getNonZeroElements
+		*/
+		virtual void getNonZeroElements(vector <unsigned int> *indices, vector <float> *values);
+		
+		/*! \fn virtual void clear(void)
+			\brief Clears the vector of all non-zero elements, resulting in a zero-vector.
+		*/
+		virtual void clear(void);
+		
+		/*! \fn virtual void extendDimensionality(unsigned int newDim, parameters* param)
+			\brief Extend the dimensionality of the vector, in the case of sparse storage only the bias term (if any) needs to be moved. \sa budgetedVector::extendDimensionality
+			\param [in] newDim New dimensionality of the vector.
+			\param [in] param The parameters of the algorithm.
+		*/
+		virtual void extendDimensionality(unsigned int newDim, parameters* param);
+		
+		/*! \fn virtual long double sqrNorm(void)
+			\brief Calculates a squared L2-norm of the vector.
+			\return Squared L2-norm of the vector.
+		*/
+		virtual long double sqrNorm(void);
+		
+		/*! \fn virtual long double linearKernel(unsigned int t, budgetedData* inputData, parameters *param)
+			\brief Computes linear kernel between vector and given input data point, in the case of sparse storage by walking sorted non-zero elements of the vector and of the data point in parallel.
+			\param [in] t Index of the input vector in the input data.
+			\param [in] inputData Input data from which t-th vector is considered.
+			\param [in] param The parameters of the algorithm.
+			\return Value of linear kernel between two input vectors.
+		*/
+		virtual long double linearKernel(unsigned int t, budgetedData* inputData, parameters *param);
+		
+		/*! \fn virtual long double linearKernel(budgetedVector* otherVector)
+			\brief Computes linear kernel between this vector and another vector, where either of the two can use sparse storage.
+			\param [in] otherVector The second input vector to linear kernel.
+			\return Value of linear kernel between two input vectors.
+		*/
+		virtual long double linearKernel(budgetedVector* otherVector);
+		
+		/*! \fn virtual void createVectorUsingDataPoint(budgetedData* inputData, unsigned int t, parameters* param)
+			\brief Create new vector from training data point, and compute its \link contentHash \endlink.
+			\param [in] inputData Input data from which t-th vector is considered.
+			\param [in] t Index of the input vector in the input data.
+			\param [in] param The parameters of the algorithm.
+			
+			Copies non-zero elements of the data point as done in budgetedVector::createVectorUsingDataPoint(), and in addition computes the content hash directly from the data point, which is linear in the number of non-zero features.
+		*/
+		virtual void createVectorUsingDataPoint(budgetedData* inputData, unsigned int t, parameters* param);
+		
+		/*! \fn static unsigned int hashDataPoint(budgetedData* inputData, unsigned int t, parameters* param, unsigned int *numNonZero = NULL)
+			\brief Computes the content hash of a data point from budgetedData, equal to the \link contentHash \endlink of a vector created from that data point.
+			\param [in] inputData Input data from which t-th vector is considered.
+			\param [in] t Index of the input vector in the input data.
+			\param [in] param The parameters of the algorithm.
+			\param [out] numNonZero If provided, set to the number of non-zero elements of the data point.
+			\return Content hash of the data point.
+		*/
+		static unsigned int hashDataPoint(budgetedData* inputData, unsigned int t, parameters* param, unsigned int *numNonZero = NULL);
+		
+		/*! \fn void updateContentHash(void)
+			\brief Recomputes \link contentHash \endlink and \link numNonZeros \endlink by traversing all allocated vector chunks, called after the vector is modified.
+		*/
+		void updateContentHash(void);
+		
+		/*! \fn unsigned int getContentHash(void)
+			\brief Returns \link contentHash \endlink of the vector.
+			\return Order-independent hash of the non-zero elements of the vector.
+		*/
+		unsigned int getContentHash(void)
+		{
+			return contentHash;
+		}
+		
+		/*! \fn bool isEqualToDataPoint(budgetedData* inputData, unsigned int t, parameters* param)
+			\brief Checks if the vector is identical to a data point, used to confirm that a data point and a vector with the same \link contentHash \endlink are exact duplicates.
+			\param [in] inputData Input data from which t-th vector is considered.
+			\param [in] t Index of the input vector in the input data.
+			\param [in] param The parameters of the algorithm.
+			\return True if the vector has exactly the same elements as the data point, otherwise false.
+			
+			The check is linear in the number of non-zero features of the data point, as the number of non-zero elements of the vector is already known from \link numNonZeros \endlink.
+		*/
+		bool isEqualToDataPoint(budgetedData* inputData, unsigned int t, parameters* param);
+		
+		/*! \fn unsigned int getNumNonZeroAlphas(void)
+			\brief Returns the number of non-zero class-specific alpha parameters.
+			\return Number of non-zero alphas.
+		*/
+		unsigned int getNumNonZeroAlphas(void)
+		{
+			return (unsigned int) alphaClasses.size();
+		}
+		
+		/*! \fn unsigned int getAlphaClass(unsigned int i)
+			\brief Returns the class of i-th non-zero alpha, non-zero alphas are sorted by their classes.
+			\param [in] i Index of non-zero alpha, smaller than \link getNumNonZeroAlphas \endlink.
+			\return Class index of i-th non-zero alpha.
+		*/
+		unsigned int getAlphaClass(unsigned int i)
+		{
+			return alphaClasses[i];
+		}
+		
+		/*! \fn long double getAlphaValue(unsigned int i)
+			\brief Returns the value of i-th non-zero alpha, non-zero alphas are sorted by their classes.
+			\param [in] i Index of non-zero alpha, smaller than \link getNumNonZeroAlphas \endlink.
+			\return Value of i-th non-zero alpha.
+		*/
+		long double getAlphaValue(unsigned int i)
+		{
+			return alphaValues[i];
 		}
 		
+		/*! \fn long double getAlpha(unsigned int k)
+			\brief Returns the alpha parameter of a given class.
+			\param [in] k Class index.
+			\return Alpha of k-th class, or 0 if not among the non-zero alphas.
+		*/
+		long double getAlpha(unsigned int k);
+		
+		/*! \fn void setAlpha(unsigned int k, long double value)
+			\brief Sets the alpha parameter of a given class, setting it to 0 removes it from the non-zero alphas.
+			\param [in] k Class index.
+			\param [in] value New value of the alpha.
+		*/
+		void setAlpha(unsigned int k, long double value);
+		
+		/*! \fn void combineAlphas(budgetedVectorBSGD* v, long double thisCoef, long double otherCoef)
+			\brief Sets alphas to a linear combination of alphas of this and another vector, used when two support vectors are merged.
+			\param [in] v The other vector.
+			\param [in] thisCoef Coefficient of the alphas of this vector.
+			\param [in] otherCoef Coefficient of the alphas of the other vector.
+			
+			The new alphas are computed as thisCoef * alphas + otherCoef * v->alphas, only for the classes where at least one of the two vectors has a non-zero alpha.
+		*/
+		void combineAlphas(budgetedVectorBSGD* v, long double thisCoef, long double otherCoef);
+		
 		/*! \fn long double alphaNorm(void)
 			\brief Computes the norm of alpha vector.
 			\return Norm of the alpha vector.
 			
-			Computes the l2-norm of the alpha vector. \sa budgetedVector::alphas
+			Computes the l2-norm of the alpha vector. \sa budgetedVectorBSGD::alphaValues
 		*/	
 		long double alphaNorm(void);
 		
@@ -93,12 +322,146 @@ class budgetedVectorBSGD : public budgetedVector
 		*/
 		void downgrade(unsigned long oto)
 		{
-			for (unsigned int i = 0; i < alphas.size(); i++)
-				if (alphas[i] != 0)
-					alphas[i] *= (1.0 - 1.0 / (long double) oto);
+			for (unsigned int i = 0; i < alphaValues.size(); i++)
+				alphaValues[i] *= (1.0 - 1.0 / (long double) oto);
 		};
 };
 
+/*! \class budgetedInvertedIndexBSGD
+    \brief Inverted index of the support vectors, used to compute kernels between an incoming data point and all support vectors at once on very sparse data.
+	
+	For each feature the index keeps a posting list of (slot, value) pairs, one for every support vector that has a non-zero value of that feature, where slot
+	identifies the support vector (see \link budgetedVectorBSGD::invertedIndexSlot \endlink). Dot products between a data point and all support vectors are then accumulated
+	in a single pass over the non-zero features of the data point, and support vectors that do not share any feature with the data point are never visited. All implemented kernels,
+	except for the user-defined one, are functions of the dot product and of the squared norms of the two vectors, and are computed from the accumulated dot products and the
+	norms cached in the vectors. The index has to be kept in sync with the support vector set, i.e., a support vector has to be removed from the index before it is modified or
+	deleted, and added back after it is modified.
+*/
+class budgetedInvertedIndexBSGD
+{
+	/*! \var vector <vector <pair <unsigned int, float> > > postings
+		\brief Posting lists, where i-th list holds slots and i-th feature values of all indexed vectors with non-zero i-th feature.
+	*/
+	/*! \var vector <unsigned int> freeSlots
+		\brief Slots released by removed vectors, reused when new vectors are added.
+	*/
+	/*! \var vector <long double> dotProducts
+		\brief Dot products between the last data point given to \link computeDotProducts \endlink and the indexed vectors, indexed by slot.
+	*/
+	protected:
+		vector < vector < pair <unsigned int, float> > > postings;
+		vector <unsigned int> freeSlots;
+		vector <long double> dotProducts;
+	
+	public:
+		/*! \fn void addVector(budgetedVectorBSGD* v)
+			\brief Adds a vector to the index, and assigns it a slot.
+			\param [in] v Vector being added.
+		*/
+		void addVector(budgetedVectorBSGD* v);
+		
+		/*! \fn void removeVector(budgetedVectorBSGD* v)
+			\brief Removes a vector from the index, must be called before the vector is deleted or modified.
+			\param [in] v Vector being removed.
+			
+			The removal is linear in the total length of posting lists of the non-zero features of the vector.
+		*/
+		void removeVector(budgetedVectorBSGD* v);
+		
+		/*! \fn void rebuild(vector <budgetedVectorBSGD*>* v)
+			\brief Clears the index and adds all given vectors, used when the vectors are changed all at once (e.g., their dimensionality is extended).
+			\param [in] v Vectors being indexed.
+		*/
+		void rebuild(vector <budgetedVectorBSGD*>* v);
+		
+		/*! \fn void computeDotProducts(unsigned int t, budgetedData* inputData, parameters *param)
+			\brief Computes dot products between a data point and all indexed vectors, by traversing posting lists of the non-zero features of the data point.
+			\param [in] t Index of the input vector in the input data.
+			\param [in] inputData Input data from which t-th vector is considered.
+			\param [in] param The parameters of the algorithm.
+		*/
+		void computeDotProducts(unsigned int t, budgetedData* inputData, parameters *param);
+		
+		/*! \fn long double computeKernel(budgetedVectorBSGD* v, long double inputVectorSqrNorm, parameters *param)
+			\brief Computes kernel between an indexed vector and the data point last given to \link computeDotProducts \endlink.
+			\param [in] v Indexed vector.
+			\param [in] inputVectorSqrNorm Squared norm of the data point, used by Gaussian and exponential kernels.
+			\param [in] param The parameters of the algorithm.
+			\return Value of kernel between the vector and the data point, same as returned by budgetedVector::computeKernel(unsigned int, budgetedData*, parameters*, long double).
+			
+			User-defined kernel can not be computed from a dot product, and the index should not be used in that case.
+		*/
+		long double computeKernel(budgetedVectorBSGD* v, long double inputVectorSqrNorm, parameters *param);
+};
+
+/*! \class budgetedHashIndexBSGD
+    \brief Hash index of the support vectors, used to find a support vector identical to an incoming data point without computing any kernels.
+	
+	Support vectors are kept in buckets selected by the lowest bits of their \link budgetedVectorBSGD::contentHash \endlink, and the number of buckets is doubled whenever there
+	are more indexed vectors than buckets, so that a lookup visits only a constant number of vectors on average. As with \link budgetedInvertedIndexBSGD \endlink, the index has
+	to be kept in sync with the support vector set, i.e., a support vector has to be removed from the index before it is modified or deleted, and added back after it is modified.
+*/
+class budgetedHashIndexBSGD
+{
+	/*! \var vector <vector <budgetedVectorBSGD*> > buckets
+		\brief Buckets of the index, where a vector is kept in the bucket given by its content hash modulo the number of buckets, which is always a power of two.
+	*/
+	/*! \var unsigned int numVectors
+		\brief Number of indexed vectors.
+	*/
+	protected:
+		vector < vector <budgetedVectorBSGD*> > buckets;
+		unsigned int numVectors;
+		
+		/*! \fn vector <budgetedVectorBSGD*>* getBucket(unsigned int hash)
+			\brief Returns the bucket of vectors with a given content hash.
+			\param [in] hash Content hash of a vector.
+			\return Bucket where the vectors with the given content hash are kept.
+		*/
+		vector <budgetedVectorBSGD*>* getBucket(unsigned int hash)
+		{
+			return &(buckets[hash & (unsigned int) (buckets.size() - 1)]);
+		}
+	
+	public:
+		/*! \fn budgetedHashIndexBSGD(void)
+			\brief Constructor, initializes an empty index.
+		*/
+		budgetedHashIndexBSGD(void)
+		{
+			buckets.resize(16);
+			numVectors = 0;
+		}
+		
+		/*! \fn void addVector(budgetedVectorBSGD* v)
+			\brief Adds a vector to the index, its content hash must be up to date.
+			\param [in] v Vector being added.
+		*/
+		void addVector(budgetedVectorBSGD* v);
+		
+		/*! \fn void removeVector(budgetedVectorBSGD* v)
+			\brief Removes a vector from the index, must be called before the vector is deleted or modified.
+			\param [in] v Vector being removed.
+		*/
+		void removeVector(budgetedVectorBSGD* v);
+		
+		/*! \fn void rebuild(vector <budgetedVectorBSGD*>* v)
+			\brief Clears the index and adds all given vectors, used when the content hashes of the vectors are changed all at once (e.g., their dimensionality is extended).
+			\param [in] v Vectors being indexed.
+		*/
+		void rebuild(vector <budgetedVectorBSGD*>* v);
+		
+		/*! \fn budgetedVectorBSGD* findDataPoint(unsigned int hash, budgetedData* inputData, unsigned int t, parameters* param)
+			\brief Finds an indexed vector identical to a data point.
+			\param [in] hash Content hash of the data point, see budgetedVectorBSGD::hashDataPoint().
+			\param [in] inputData Input data from which t-th vector is considered.
+			\param [in] t Index of the input vector in the input data.
+			\param [in] param The parameters of the algorithm.
+			\return Indexed vector identical to the data point, NULL if there is no such vector.
+		*/
+		budgetedVectorBSGD* findDataPoint(unsigned int hash, budgetedData* inputData, unsigned int t, parameters* param);
+};
+
 /*! \class budgetedModelBSGD
     \brief Class which holds the BSGD model (comprising the support vectors stored as \link budgetedVectorBSGD \endlink), and implements methods to load BSGD model from and save BSGD model to text file.
 */
@@ -20,6 +20,9 @@
 #include <string.h>
 #include <cstdlib>
 #include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 using namespace std;
 
 #include "budgetedSVM.h"
@@ -500,6 +503,89 @@ bool budgetedData::readChunk(unsigned int size, bool assign)
 	return false;      
 }
 
+/* \fn unsigned int sampleReservoir(unsigned int size, budgetedData *sample)
+	\brief Reads the entire input .txt file once and keeps a uniformly random sample of its data points.
+	\param [in] size Maximum number of data points in the sample.
+	\param [out] sample Data object which receives the sampled data points, initially created using the vanilla constructor.
+	\return Total number of data points in the input file, or 0 if the data is not loaded from a file.
+*/
+unsigned int budgetedData::sampleReservoir(unsigned int size, budgetedData *sample)
+{
+	char line[262143];	// maximum length of the line to be read is set to 262143, as in readChunk()
+	string text;
+	int pos;
+	unsigned int numPoints = 0, slot, dimSeen, i, j;
+	unsigned long start = clock(), nextTaken;
+	double w;
+	FILE *sampleFile = NULL;
+	
+	// if not loaded from .txt file just exit
+	if ((!dataPartiallyLoaded) || (size == 0))
+		return 0;
+	
+	sampleFile = fopen(ifileName, "rt");
+	if (!sampleFile)
+		svmPrintErrorString("Error opening the input file for sampling of the data points!\n");
+	
+	// the first size data points fill the reservoir, and afterwards the number of data points skipped before the next one replaces a random sampled point is geometric
+	vector < vector <unsigned int> > sampleIndices(size);
+	vector < vector <float> > sampleValues(size);
+	w = exp(log(((double) rand() + 1.0) / ((double) RAND_MAX + 2.0)) / (double) size);
+	nextTaken = (unsigned long) size + (unsigned long) floor(log(((double) rand() + 1.0) / ((double) RAND_MAX + 2.0)) / log(1.0 - w));
+	while (fgets(line, 262143, sampleFile))
+	{
+		numPoints++;
+		if (numPoints <= size)
+			slot = numPoints - 1;
+		else if (numPoints - 1 == nextTaken)
+		{
+			slot = (unsigned int) (rand() % size);
+			w *= exp(log(((double) rand() + 1.0) / ((double) RAND_MAX + 2.0)) / (double) size);
+			nextTaken += (unsigned long) floor(log(((double) rand() + 1.0) / ((double) RAND_MAX + 2.0)) / log(1.0 - w)) + 1;
+		}
+		else
+			continue;
+		
+		// parse the sampled data point, skipping its label
+		stringstream ss;
+		ss << line;
+		sampleIndices[slot].clear();
+		sampleValues[slot].clear();
+		ss >> text;
+		while (ss >> text)
+		{
+			if ((pos = (int) text.find(":")))
+			{
+				sampleIndices[slot].push_back((unsigned int) atoi(text.substr(0, pos).c_str()));
+				sampleValues[slot].push_back((float) atof(text.substr(pos + 1, text.length()).c_str()));
+			}
+		}
+	}
+	fclose(sampleFile);
+	
+	// store the sample in the sparse structure of the output data object
+	(*sample).flushData();
+	(*sample).numNonZeroFeatures = 0;
+	for (i = 0; (i < size) && (i < numPoints); i++)
+	{
+		(*sample).ai.push_back((unsigned int) (*sample).aj.size());
+		for (j = 0; j < (unsigned int) sampleIndices[i].size(); j++)
+		{
+			dimSeen = sampleIndices[i][j];
+			(*sample).aj.push_back(dimSeen);
+			(*sample).an.push_back(sampleValues[i][j]);
+			if ((*sample).dimensionHighestSeen < dimSeen)
+				(*sample).dimensionHighestSeen = dimSeen;
+		}
+		(*sample).numNonZeroFeatures += (unsigned int) sampleIndices[i].size();
+		(*sample).N++;
+	}
+	(*sample).loadedDataPointsSoFar = (*sample).N;
+	loadTime += (clock() - start);
+	
+	return numPoints;
+}
+
 /* \fn float getElementOfVector(unsigned int vector, unsigned int element)
 	\brief Returns an element of a vector stored in\link budgetedData\endlink structure.
 	\param [in] vector Index of the vector (C-style indexing used, starting from 0; note that LibSVM format indices start from 1).
@@ -804,13 +890,20 @@ float& budgetedVector::operator[](int idx)
 */
 void budgetedVector::createVectorUsingVector(budgetedVector* existingVector)
 {
+	unsigned int chunkSize;
+	
 	clear();
 	for (unsigned int i = 0; i < arrayLength; i++)
 	{
 		if (existingVector->array[i] != NULL)
 		{
-			array[i] = new (nothrow) float[chunkWeight];
-			for (unsigned int j = 0; j < chunkWeight; j++)
+			// the last chunk might be smaller than the rest
+			chunkSize = chunkWeight;
+			if ((i == (arrayLength - 1)) && (dimension % chunkWeight != 0))
+				chunkSize = dimension % chunkWeight;
+			
+			array[i] = new (nothrow) float[chunkSize];
+			for (unsigned int j = 0; j < chunkSize; j++)
 				array[i][j] = existingVector->array[i][j];
 		}
 	}
@@ -857,7 +950,8 @@ long double budgetedVector::sqrNorm(void)
 	{
 		if (array[i] != NULL)
 		{
-			if ((i == (arrayLength - 1)) && (dimension != chunkWeight))
+			// the last chunk might be smaller than the rest
+			if ((i == (arrayLength - 1)) && (dimension % chunkWeight != 0))
 				chunkSize = dimension % chunkWeight;
 			
 			for (unsigned int j = 0; j < chunkSize; j++)
@@ -867,6 +961,37 @@ long double budgetedVector::sqrNorm(void)
 	return tempSum;
 }
 
+/* \fn void budgetedVector::getNonZeroElements(vector <unsigned int> *indices, vector <float> *values)
+	\brief Lists the non-zero elements of the vector.
+	\param [out] indices Zero-based indices of the non-zero elements, in increasing order.
+	\param [out] values Values of the non-zero elements.
+*/
+void budgetedVector::getNonZeroElements(vector <unsigned int> *indices, vector <float> *values)
+{
+	unsigned long chunkSize = chunkWeight;
+	
+	(*indices).clear();
+	(*values).clear();
+	for (unsigned int i = 0; i < arrayLength; i++)
+	{
+		if (array[i] != NULL)
+		{
+			// the last chunk might be smaller than the rest
+			if ((i == (arrayLength - 1)) && (dimension % chunkWeight != 0))
+				chunkSize = dimension % chunkWeight;
+			
+			for (unsigned int j = 0; j < chunkSize; j++)
+			{
+				if (array[i][j] != 0.0f)
+				{
+					(*indices).push_back(i * chunkWeight + j);
+					(*values).push_back(array[i][j]);
+				}
+			}
+		}
+	}
+}
+
 /* \fn long double budgetedVector::gaussianKernel(budgetedVector* otherVector, parameters *param)
 	\brief Computes Gaussian kernel between this and some other vector.
 	\param [in] otherVector The second input vector to RBF kernel.
@@ -1180,6 +1305,22 @@ long double budgetedVector::computeKernel(unsigned int t, budgetedData* inputDat
 	}
 }
 
+/* \fn unsigned int getNumThreads(parameters *param)
+	\brief Returns the number of threads that the parallelized parts of the algorithms should use.
+	\param [in] param The parameters of the algorithm.
+	\return Number of threads, equal to NUM_THREADS parameter, or to the number of available cores if it is set to 0; always 1 if the toolbox is compiled without OpenMP support.
+*/
+unsigned int getNumThreads(parameters *param)
+{
+#ifdef _OPENMP
+	if ((*param).NUM_THREADS == 0)
+		return (unsigned int) omp_get_max_threads();
+	return (*param).NUM_THREADS;
+#else
+	return 1;
+#endif
+}
+
 /* \fn void printUsagePrompt(bool trainingPhase)
 	\brief Prints the instructions on how to use the software to standard output.
 	\param [in] trainingPhase Indicator if training or testing phase instructions.
@@ -1235,10 +1376,52 @@ void printUsagePrompt(bool trainingPhase, parameters *param)
 		svmPrintString(" m - budget maintenance in BSGD (0 - removal; 1 - merging, uses Gaussian kernel), OR\n");
 		sprintf(text,  "       landmark selection in LLSVM (0 - random; 1 - k-means; 2 - k-medoids) (%d)\n", (*param).MAINTENANCE_SAMPLING_STRATEGY);
 		svmPrintString(text);
+		svmPrintString(" Q - maximum number of members of a cluster among which k-medoids searches for\n");
+		sprintf(text,  "       the new medoid, where 0 means all members (LLSVM; %d)\n", (*param).MEDOID_SAMPLE_SIZE);
+		svmPrintString(text);
+		svmPrintString(" R - number of points sampled from the entire training file to select landmark\n");
+		sprintf(text,  "       points from, where 0 means the first data chunk is used (LLSVM; %d)\n", (*param).LANDMARK_RESERVOIR_SIZE);
+		svmPrintString(text);
+		svmPrintString(" W - if set to 1, the model also stores the BxB transformation matrix, otherwise\n");
+		sprintf(text,  "       only the coefficients of the landmark points are stored (LLSVM; %d)\n", (*param).STORE_MATRIX_W);
+		svmPrintString(text);
+		svmPrintString(" l - rank of the approximation of the landmark kernel matrix found by randomized\n");
+		sprintf(text,  "       eigensolver, where 0 means exact eigendecomposition (LLSVM; %d)\n", (*param).NYSTROM_RANK);
+		svmPrintString(text);
+		sprintf(text, " O - oversampling of the randomized eigensolver (LLSVM; %d)\n", (*param).NYSTROM_OVERSAMPLING);
+		svmPrintString(text);
+		svmPrintString(" f - if set to 1, the mapped training data is kept in single precision, which halves\n");
+		sprintf(text,  "       the memory needed for a data chunk (LLSVM; %d)\n", (*param).FLOAT_MAPPED_DATA);
+		svmPrintString(text);
+		svmPrintString(" X - if set to 1, the mapped data chunks are stored to a temporary file and linear SVM\n");
+		sprintf(text,  "       is trained over all of them, otherwise chunk by chunk (LLSVM; %d)\n", (*param).OUT_OF_CORE_TRAINING);
+		svmPrintString(text);
+		svmPrintString(" E - budget slack in BSGD with removal strategy, number of SVs allowed over the budget\n");
+		sprintf(text,  "       before one removal pass brings their number back to the budget size (%d)\n", (*param).BUDGET_SLACK);
+		svmPrintString(text);
 
 		sprintf(text, " C - clone probability when misclassification occurs in AMM (%.2f)\n", (*param).CLONE_PROBABILITY);
 		svmPrintString(text);
-		sprintf(text, " y - clone probability decay when weight cloning occurs in AMM (%.2f)\n\n", (*param).CLONE_PROBABILITY_DECAY);
+		sprintf(text, " y - clone probability decay when weight cloning occurs in AMM (%.2f)\n", (*param).CLONE_PROBABILITY_DECAY);
+		svmPrintString(text);
+		sprintf(text, " p - minimum number of weights for which AMM scores the weights in parallel (%d)\n", (*param).PARALLEL_SCORING_MIN);
+		svmPrintString(text);
+		svmPrintString(" N - number of updates of the norm of an AMM weight after which the norm is\n");
+		sprintf(text,  "       recomputed before pruning, where 0 means never (%d)\n", (*param).NORM_RESYNC_INTERVAL);
+		svmPrintString(text);
+		svmPrintString(" M - mini-batch size, number of examples processed together in a single update,\n");
+		sprintf(text,  "       where 1 means one example at a time (Pegasos, AMM online; %d)\n", (*param).MINI_BATCH_SIZE);
+		svmPrintString(text);
+		svmPrintString(" P - if set to 1, the examples of a mini-batch are scored using a packed weight\n");
+		svmPrintString("       matrix built once per mini-batch, which takes DIMENSION x NUMBER_OF_WEIGHTS\n");
+		sprintf(text,  "       floats of memory (Pegasos, AMM online; %d)\n", (*param).PACKED_WEIGHTS);
+		svmPrintString(text);
+		svmPrintString(" H - if set to 1, T threads concurrently process the training examples, where\n");
+		svmPrintString("       Pegasos threads update the shared weights without locking, and AMM online\n");
+		sprintf(text,  "       threads train their own models that are averaged (Pegasos, AMM online; %d)\n", (*param).PARALLEL_TRAINING);
+		svmPrintString(text);
+		svmPrintString(" F - number of examples after which the models of the threads of parallel AMM\n");
+		sprintf(text,  "       online are averaged, where 0 means once per data chunk (%d)\n\n", (*param).SYNC_INTERVAL);
 		svmPrintString(text);
 		
 		svmPrintString(" z - training and test file are loaded in chunks so that the algorithms can\n");
@@ -1254,6 +1437,9 @@ void printUsagePrompt(bool trainingPhase, parameters *param)
 		svmPrintString("       features is less than 5%, and 0 when percentage is larger than 5%)\n");
 		sprintf(text, " r - randomize the algorithms; 1 to randomize, 0 not to randomize (%d)\n", (*param).RANDOMIZE);
 		svmPrintString(text);
+		svmPrintString(" T - number of threads used by the parallelized parts of the algorithms, 0 to\n");
+		sprintf(text,  "       use all available cores; requires compilation with OpenMP (%d)\n", (*param).NUM_THREADS);
+		svmPrintString(text);
 		sprintf(text, " v - verbose output; 1 to show the algorithm steps, 0 for quiet mode (%d)\n\n", (*param).VERBOSE);
 		svmPrintString(text);
 	}
@@ -1282,6 +1468,10 @@ void printUsagePrompt(bool trainingPhase, parameters *param)
 		svmPrintString(" S - if set to 1 data is assumed sparse, if 0 data assumed non-sparse, used to\n");
 		svmPrintString("       speed up kernel computations (default is 1 when percentage of non-zero\n");
 		svmPrintString("       features is less than 5%, and 0 when percentage is larger than 5%)\n");
+		svmPrintString(" P - if set to 1, AMM and Pegasos scores are computed using a packed weight\n");
+		svmPrintString("       matrix, which is faster but takes DIMENSION x NUMBER_OF_WEIGHTS floats\n");
+		sprintf(text,  "       of memory (%d)\n", (*param).PACKED_WEIGHTS);
+		svmPrintString(text);
 		svmPrintString(" o - if set to 1, the output file will contain not only the class predictions,\n");
 		sprintf(text,  "       but also tab-delimited scores of the winning class (%d)\n", (*param).OUTPUT_SCORES);
 		svmPrintString(text);
@@ -1442,6 +1632,63 @@ void parseInputPrompt(int argc, char **argv, bool trainingPhase, char *inputFile
 					(*param).MAINTENANCE_SAMPLING_STRATEGY = (unsigned int) value[i];
 					break; 
 				
+				case 'Q':
+					if (value[i] < 0.0)
+					{
+						sprintf(text, "Input parameter '-Q' should be a non-negative integer!\nRun 'budgetedsvm-train' for help.\n");
+						svmPrintErrorString(text);
+					}
+					(*param).MEDOID_SAMPLE_SIZE = (unsigned int) value[i];
+					break;
+				
+				case 'R':
+					if (value[i] < 0.0)
+					{
+						sprintf(text, "Input parameter '-R' should be a non-negative integer!\nRun 'budgetedsvm-train' for help.\n");
+						svmPrintErrorString(text);
+					}
+					(*param).LANDMARK_RESERVOIR_SIZE = (unsigned int) value[i];
+					break;
+				
+				case 'W':
+					(*param).STORE_MATRIX_W = (value[i] != 0);
+					break;
+				
+				case 'l':
+					if (value[i] < 0.0)
+					{
+						sprintf(text, "Input parameter '-l' should be a non-negative integer!\nRun 'budgetedsvm-train' for help.\n");
+						svmPrintErrorString(text);
+					}
+					(*param).NYSTROM_RANK = (unsigned int) value[i];
+					break;
+				
+				case 'O':
+					if (value[i] < 0.0)
+					{
+						sprintf(text, "Input parameter '-O' should be a non-negative integer!\nRun 'budgetedsvm-train' for help.\n");
+						svmPrintErrorString(text);
+					}
+					(*param).NYSTROM_OVERSAMPLING = (unsigned int) value[i];
+					break;
+				
+				case 'f':
+					(*param).FLOAT_MAPPED_DATA = (value[i] != 0);
+					break;
+				
+				case 'X':
+					(*param).OUT_OF_CORE_TRAINING = (value[i] != 0);
+					break;
+				
+				case 'E':
+					if (value[i] < 0.0)
+					{
+						sprintf(text, "Input parameter '-E' should be a non-negative integer!\nRun 'budgetedsvm-train' for help.\n");
+						svmPrintErrorString(text);
+					}
+					(*param).BUDGET_SLACK = (unsigned int) value[i];
+					break;
+				
 				case 'b':
 					(*param).BIAS_TERM = (double) value[i];
 					break;
@@ -1494,6 +1741,59 @@ void parseInputPrompt(int argc, char **argv, bool trainingPhase, char *inputFile
 					}
 					break;
 
+				case 'M':
+					if (value[i] < 1.0)
+					{
+						sprintf(text, "Input parameter '-M' should be a positive integer!\nRun 'budgetedsvm-train' for help.\n");
+						svmPrintErrorString(text);
+					}
+					(*param).MINI_BATCH_SIZE = (unsigned int) value[i];
+					break;
+
+				case 'P':
+					(*param).PACKED_WEIGHTS = (value[i] != 0);
+					break;
+
+				case 'H':
+					(*param).PARALLEL_TRAINING = (value[i] != 0);
+					break;
+
+				case 'F':
+					(*param).SYNC_INTERVAL = (unsigned int) value[i];
+					if (value[i] < 0.0)
+					{
+						sprintf(text, "Input parameter '-F' should be a non-negative integer!\nRun 'budgetedsvm-train' for help.\n");
+						svmPrintErrorString(text);
+					}
+					break;
+
+				case 'T':
+					(*param).NUM_THREADS = (unsigned int) value[i];
+					if (value[i] < 0.0)
+					{
+						sprintf(text, "Input parameter '-T' should be a non-negative integer!\nRun 'budgetedsvm-train' for help.\n");
+						svmPrintErrorString(text);
+					}
+					break;
+
+				case 'p':
+					(*param).PARALLEL_SCORING_MIN = (unsigned int) value[i];
+					if (value[i] < 0.0)
+					{
+						sprintf(text, "Input parameter '-p' should be a non-negative integer!\nRun 'budgetedsvm-train' for help.\n");
+						svmPrintErrorString(text);
+					}
+					break;
+
+				case 'N':
+					(*param).NORM_RESYNC_INTERVAL = (unsigned int) value[i];
+					if (value[i] < 0.0)
+					{
+						sprintf(text, "Input parameter '-N' should be a non-negative integer!\nRun 'budgetedsvm-train' for help.\n");
+						svmPrintErrorString(text);
+					}
+					break;
+
 				default:
 					sprintf(text, "Error, unknown input parameter '-%c'!\nRun 'budgetedsvm-train' for help.\n", option[i]);
 					svmPrintErrorString(text);
@@ -1509,6 +1809,19 @@ void parseInputPrompt(int argc, char **argv, bool trainingPhase, char *inputFile
 			(*param).KERNEL = KERNEL_FUNC_GAUSSIAN;
 		}
 		
+		// the budget slack only pays off with removal, where the removal scores are shared by the whole pass; each merge searches the whole SV set
+		//	anyway, so with merging the slack would only make the maintenance slower
+		if (((*param).ALGORITHM == BSGD) && ((*param).BUDGET_SLACK > 0) && ((*param).MAINTENANCE_SAMPLING_STRATEGY == BUDGET_MAINTAIN_MERGE))
+		{
+			svmPrintErrorString("Error, budget slack can only be used with removal strategy, set either '-E' to 0 or '-m' to 0!\nRun 'budgetedsvm-train' for help.\n");
+		}
+		
+		// the threads of parallel training update the weights one example at a time, which cannot be combined with mini-batches
+		if (((*param).PARALLEL_TRAINING) && ((*param).MINI_BATCH_SIZE > 1))
+		{
+			svmPrintErrorString("Error, parallel training cannot be combined with mini-batches, set either '-H' to 0 or '-M' to 1!\nRun 'budgetedsvm-train' for help.\n");
+		}
+		
 		// signal error if a user wants to use RBF kernel, but didn't specify either data dimension or kernel width
 		if ((((*param).ALGORITHM == LLSVM) || ((*param).ALGORITHM == BSGD)) && (((*param).KERNEL == KERNEL_FUNC_GAUSSIAN) || ((*param).KERNEL == KERNEL_FUNC_EXPONENTIAL)))
 		{
@@ -1578,6 +1891,11 @@ void parseInputPrompt(int argc, char **argv, bool trainingPhase, char *inputFile
 				svmPrintString(text);
 				sprintf(text, "Bias term \t\t\t: %f\n", (*param).BIAS_TERM);
 				svmPrintString(text);
+				if (((*param).ALGORITHM != AMM_BATCH) && ((*param).MINI_BATCH_SIZE > 1))
+				{
+					sprintf(text, "Mini-batch size \t\t: %d\n", (*param).MINI_BATCH_SIZE);
+					svmPrintString(text);
+				}
 				if ((*param).ALGORITHM != PEGASOS)
 				{
 					sprintf(text, "Pruning frequency k \t\t: %d\n", (*param).K_PARAM);
@@ -1586,6 +1904,16 @@ void parseInputPrompt(int argc, char **argv, bool trainingPhase, char *inputFile
 					svmPrintString(text);
 					sprintf(text, "Max num. of weights per class \t: %d\n", (*param).BUDGET_SIZE);
 					svmPrintString(text);
+					if (getNumThreads(param) > 1)
+					{
+						sprintf(text, "Number of threads \t\t: %d\n", getNumThreads(param));
+						svmPrintString(text);
+					}
+					if (((*param).ALGORITHM == AMM_ONLINE) && ((*param).PARALLEL_TRAINING))
+					{
+						sprintf(text, "Model averaging interval \t: %d\n", (*param).SYNC_INTERVAL);
+						svmPrintString(text);
+					}
 					sprintf(text, "Number of epochs \t\t: %d\n\n", (*param).NUM_EPOCHS);
 					svmPrintString(text);
 				}
@@ -1608,6 +1936,11 @@ void parseInputPrompt(int argc, char **argv, bool trainingPhase, char *inputFile
 					svmPrintString(text);
 					sprintf(text, "Size of the budget \t\t: %d\n", (*param).BUDGET_SIZE);
 					svmPrintString(text);
+					if ((*param).BUDGET_SLACK > 0)
+					{
+						sprintf(text, "Budget slack \t\t\t: %d\n", (*param).BUDGET_SLACK);
+						svmPrintString(text);
+					}
 				}
 				else if ((*param).ALGORITHM == LLSVM)
 				{		
@@ -1621,6 +1954,11 @@ void parseInputPrompt(int argc, char **argv, bool trainingPhase, char *inputFile
 							break;
 						case LANDMARK_SAMPLE_KMEDOIDS:
 							svmPrintString("Landmark sampling \t\t: 1 (k-medoids initialization)\n");
+							if ((*param).MEDOID_SAMPLE_SIZE > 0)
+							{
+								sprintf(text, "Medoid sample size \t\t: %d\n", (*param).MEDOID_SAMPLE_SIZE);
+								svmPrintString(text);
+							}
 							break;
 						default:
 							svmPrintErrorString("Error, unknown landmark sampling set. Run 'budgetedsvm-train' for help.\n");
@@ -1628,6 +1966,16 @@ void parseInputPrompt(int argc, char **argv, bool trainingPhase, char *inputFile
 					}
 					sprintf(text, "Number of landmark points \t: %d\n", (*param).BUDGET_SIZE);
 					svmPrintString(text);
+					if ((*param).LANDMARK_RESERVOIR_SIZE > 0)
+					{
+						sprintf(text, "Landmark reservoir size \t: %d\n", (*param).LANDMARK_RESERVOIR_SIZE);
+						svmPrintString(text);
+					}
+					if (((*param).NYSTROM_RANK > 0) && ((*param).NYSTROM_RANK < (*param).BUDGET_SIZE))
+					{
+						sprintf(text, "Nystrom rank \t\t\t: %d (oversampling %d)\n", (*param).NYSTROM_RANK, (*param).NYSTROM_OVERSAMPLING);
+						svmPrintString(text);
+					}
 				}
 				
 				// now print the common parameters
@@ -1760,6 +2108,10 @@ void parseInputPrompt(int argc, char **argv, bool trainingPhase, char *inputFile
 					(*param).VERY_SPARSE_DATA = (unsigned int) (value[i] != 0);
 					break;
 				
+				case 'P':
+					(*param).PACKED_WEIGHTS = (value[i] != 0);
+					break;
+				
 				case 'o':
 					(*param).OUTPUT_SCORES = (value[i] != 0);
 					break;
@@ -193,11 +193,72 @@ struct parameters
 			- 1 - landmark points will be cluster centers after running k-means on the first loaded data chunk (default setting) 
 			- 2 - landmark points will be cluster medoids after running k-medoids on the first loaded data chunk
 	*/
+	/*! \var unsigned int BUDGET_SLACK
+		\brief Number of support vectors BSGD is allowed to keep over \link BUDGET_SIZE \endlink before the budget maintenance is triggered (default: 0)
+		
+		With the default value of 0 the budget maintenance is performed every time a support vector is added to the full budget. When set to a positive value S, the support vectors
+		are allowed to accumulate up to \link BUDGET_SIZE \endlink + S, after which a single removal pass brings their number back to \link BUDGET_SIZE \endlink. The removal 
+		scores are computed only once per pass and all S + 1 removed support vectors are found with a single partial sort, which amortizes the cost of the maintenance over S + 1 steps.
+		The slack can only be used with the removal strategy, as each merge searches the whole support vector set and a larger set would only make merging slower. The additional
+		support vectors are kept only during training, and the model is brought back to \link BUDGET_SIZE \endlink support vectors at the end of training.
+	*/
 	/*! \var unsigned int K_MEANS_ITERS
-		\brief Number of k-means iterations in initialization of LLSVM algorithm (default: 10)
+		\brief Maximum number of k-means iterations in initialization of LLSVM algorithm (default: 10)
 		
 		In order to find better lower-dimensional representation of the data set using Nystrom method, k-means can be used to improve the choice of landmark points. Unlike in random sampling
-		of landmark points from the data set, cluster centers of k-means will represent \link BUDGET_SIZE \endlink points used for the Nystrom method.
+		of landmark points from the data set, cluster centers of k-means will represent \link BUDGET_SIZE \endlink points used for the Nystrom method. K-means stops before the maximum
+		number of iterations if no data point changes its cluster.
+	*/
+	/*! \var unsigned int MEDOID_SAMPLE_SIZE
+		\brief Maximum number of members of a cluster among which k-medoids searches for the new medoid of the cluster, where 0 means all members (default: 1000)
+		
+		Finding the member of a cluster with the smallest sum of distances to the other members takes time quadratic in the size of the cluster. For clusters with more members, 
+		k-medoids in initialization of LLSVM searches for the medoid among a random sample of MEDOID_SAMPLE_SIZE members, which always includes the current medoid, and computes the 
+		sums of distances over the sample, similarly to CLARA algorithm. This bounds the cost of the medoid update by O(BUDGET_SIZE x MEDOID_SAMPLE_SIZE^2) distance computations,
+		which allows k-medoids to be run on large data chunks.
+	*/
+	/*! \var unsigned int LANDMARK_RESERVOIR_SIZE
+		\brief Number of data points sampled from the entire training file on which the landmark points of LLSVM are selected, where 0 means that the first data chunk is used (default: 0)
+		
+		By default the landmark points are selected from the first loaded data chunk, which biases them towards the beginning of the training file and requires the chunk to hold at least
+		\link BUDGET_SIZE \endlink data points. If the parameter is non-zero and the training file does not fit into a single chunk, before training LLSVM reads the file once more and keeps 
+		a uniformly random sample of max(LANDMARK_RESERVOIR_SIZE, BUDGET_SIZE) data points using reservoir sampling, and the landmark points are selected from this sample using 
+		random sampling, k-means, or k-medoids. The memory taken by the sample does not depend on \link CHUNK_SIZE \endlink, so a large number of landmark points can be used together with 
+		small data chunks. \sa budgetedData::sampleReservoir()
+	*/
+	/*! \var bool STORE_MATRIX_W
+		\brief Store the (BUDGET_SIZE x BUDGET_SIZE) transformation matrix and the linear SVM weight vector in LLSVM model files, 1 - stored; 0 - only the coefficients of the landmark points are stored (default: 0)
+		
+		Prediction only needs the coefficients of the landmark points, computed as the product of the transformation matrix and the weight vector, so by default the model file takes
+		O(BUDGET_SIZE) numbers in addition to the landmark points instead of O(BUDGET_SIZE^2). \sa budgetedModelLLSVM::modelLLSVMcoefficients
+	*/
+	/*! \var unsigned int NYSTROM_RANK
+		\brief Rank of the approximation of the kernel matrix of the landmark points in LLSVM, where 0 means that the exact eigendecomposition is used (default: 0)
+		
+		The transformation matrix of LLSVM is found from the eigendecomposition of the (BUDGET_SIZE x BUDGET_SIZE) kernel matrix of the landmark points, which takes O(BUDGET_SIZE^3)
+		time. If the parameter is non-zero and smaller than BUDGET_SIZE, only the NYSTROM_RANK leading eigenpairs are found by a randomized eigensolver, in O(BUDGET_SIZE^2 x NYSTROM_RANK) 
+		time, and the data points are mapped to a NYSTROM_RANK-dimensional space instead of a BUDGET_SIZE-dimensional one. \sa NYSTROM_OVERSAMPLING
+	*/
+	/*! \var unsigned int NYSTROM_OVERSAMPLING
+		\brief Number of random vectors used by the randomized eigensolver of LLSVM in addition to \link NYSTROM_RANK \endlink (default: 10)
+		
+		The randomized eigensolver finds the range of the kernel matrix of the landmark points by multiplying it with (NYSTROM_RANK + NYSTROM_OVERSAMPLING) random vectors, 
+		and the extra vectors improve the accuracy of the leading NYSTROM_RANK eigenpairs that are kept.
+	*/
+	/*! \var bool FLOAT_MAPPED_DATA
+		\brief Keep the training data mapped by LLSVM in single precision, 1 - single precision; 0 - double precision (default: 1)
+		
+		LLSVM trains linear SVM on the loaded data chunk mapped into a (CHUNK_SIZE x BUDGET_SIZE) matrix, or (CHUNK_SIZE x NYSTROM_RANK) matrix if the randomized eigensolver is used, 
+		which takes most of the memory during training. Keeping the matrix in single precision halves this memory, allowing twice larger data chunks, while the kernels and the 
+		mapping are still computed in double precision. The dot products of linear SVM are computed in the precision of the matrix, and as its passes over the matrix are limited by memory bandwidth, 
+		they also take about half the time in single precision.
+	*/
+	/*! \var bool OUT_OF_CORE_TRAINING
+		\brief Train LLSVM over all data chunks at once, 1 - mapped chunks are stored to a temporary file; 0 - linear SVM is trained on each chunk in turn (default: 0)
+		
+		By default linear SVM is trained on each mapped chunk separately, starting from the weights found on the previous chunk, so that the result depends on the size of 
+		the chunks. If set, the mapped chunks are written in single precision to a temporary file, and after the entire training file has been read the dual coordinate 
+		descent makes passes over the temporary file, keeping the dual variables of all data points, until the stopping criterion holds over the entire training data.
 	*/
 	/*! \var double KERNEL_GAMMA_PARAM
 		\brief Kernel width parameter in Gaussian kernel exp(-0.5 * KERNEL_GAMMA_PARAM * ||x - y||^2) (default: 1/DIMENSIONALITY)
@@ -257,11 +318,65 @@ struct parameters
 		
 		If a user does not manually set this parameter to 0 (i.e., instructs the toolbox to compute kernels as in case (1)) or 1 (i.e., compute kernels as in case (2)), the default setting will be 0 if the sparsity of the loaded data is less than 5% (i.e., less than 5% of the features are non-zero on average), otherwise it will default to 1. For this default behavior that is adaptive to the found data sparsity a developer can set this parameter to anything other than 0 or 1. For more details, please see the train and test functions of the implemented algorithms, and look for code parts where VERY_SPARSE_DATA appears. \sa updateVerySparseDataParameter(), budgetedVector::linearKernel(unsigned int, budgetedData*, parameters*), budgetedVector::linearKernel(budgetedVector*), budgetedVector::gaussianKernel(unsigned int, budgetedData*, parameters*, long double), budgetedVector::gaussianKernel(budgetedVector*, parameters*)
 	*/
+	/*! \var bool PACKED_WEIGHTS
+		\brief Compute the scores of AMM and Pegasos weights during prediction using a packed weight matrix, 1 - packed weight matrix; 0 - score each weight separately (default: 0)
+		
+		When set, all weights of the model are copied into a single contiguous matrix with one column per weight, and a data point is scored against all weights at once 
+		by adding the matrix rows of its non-zero features. The matrix is built lazily, and rebuilt only after the weights 
+		change. Since the matrix is dense it takes DIMENSION x NUMBER_OF_WEIGHTS floats of memory, which is why the option is most useful for data of moderate dimensionality. 
+		During training the option is used only by mini-batch Pegasos and AMM online, where the weights do not change within a mini-batch. \sa budgetedModelAMM::computePackedScores(), MINI_BATCH_SIZE
+	*/
+	/*! \var unsigned int MINI_BATCH_SIZE
+		\brief Number of training examples processed together in a single update of Pegasos and AMM online, where 1 gives the original one-example-at-a-time algorithms (default: 1)
+		
+		When set to a value B larger than 1, the training data is processed in mini-batches of B examples. All examples of a mini-batch are scored against the model as it was 
+		at the start of the mini-batch, and the sub-gradients of the examples that violate the margin are recorded. Then the weights are degraded once, and each updated weight 
+		receives the sum of its recorded sub-gradients averaged over the mini-batch, while the new and cloned weights of AMM are added at the end of the mini-batch. The learning 
+		rate decreases with the number of mini-batches instead of the number of examples. If \link PACKED_WEIGHTS \endlink is also set, the examples of a mini-batch are scored 
+		using a packed weight matrix that is built once per mini-batch.
+	*/
+	/*! \var bool PARALLEL_TRAINING
+		\brief Train Pegasos and AMM online using \link NUM_THREADS \endlink threads that concurrently process the training examples, 1 - parallel training; 0 - serial training (default: 0)
+		
+		When set, the threads of Pegasos take the examples of the loaded data chunk from a shared queue and update the shared weights of the classes without any 
+		locking (the so-called Hogwild training), where the learning rate and the degradation of the weights are coordinated through a global step counter. The threads
+		of AMM online instead train their own copies of the model on disjoint parts of the data, and the copies are averaged every \link SYNC_INTERVAL \endlink examples. 
+		Unlike the parallel scoring of the weights, the learned model then depends on the scheduling of the threads, and is not reproducible even with fixed random seed. 
+		The option cannot be combined with mini-batches. \sa MINI_BATCH_SIZE
+	*/
+	/*! \var unsigned int SYNC_INTERVAL
+		\brief Number of training examples after which the models of the threads of parallel AMM online are averaged, where 0 means that they are averaged once per data chunk (default: 10000)
+		
+		The threads train their copies of the model on the examples of a segment of SYNC_INTERVAL examples, after which the inherited weights of the copies are averaged, the weights 
+		added by the threads are all kept, and each class is pruned back to \link BUDGET_SIZE \endlink weights. Longer segments reduce the overhead of copying and averaging the models,
+		while the copies drift further apart. \sa PARALLEL_TRAINING
+	*/
+	/*! \var unsigned int NORM_RESYNC_INTERVAL
+		\brief Number of incremental updates of the squared norm of an AMM weight after which the norm is recomputed from the elements of the weight, where 0 means that it is never recomputed (default: 1000)
+		
+		The squared norms of the weights, used by AMM to decide which weights to prune, are updated incrementally by each training update of a weight, and the round-off errors of
+		the updates accumulate over long training runs. Before pruning, the norms of the weights updated at least NORM_RESYNC_INTERVAL times since their norms were last computed are
+		recomputed, which costs O(DIMENSION) per recomputed norm. With verbose output the number of the recomputed norms and their largest relative drift are reported at the end of
+		training. \sa budgetedModelAMM::resyncNorms()
+	*/
+	/*! \var unsigned int NUM_THREADS
+		\brief Number of threads used by the parallelized parts of the algorithms, where 0 means that all available cores are used (default: 1)
+		
+		The parameter has an effect only when the toolbox is compiled with OpenMP support (e.g., using -fopenmp flag of gcc), otherwise all computations are done serially. 
+		\sa getNumThreads()
+	*/
+	/*! \var unsigned int PARALLEL_SCORING_MIN
+		\brief Minimum number of weights of AMM model for which the weights are scored in parallel during training (default: 256)
+		
+		When training AMM models, for each training example the scores of all weights of all classes are computed. If the model holds at least PARALLEL_SCORING_MIN weights 
+		and \link NUM_THREADS \endlink is not 1, these scores are computed in parallel, and otherwise serially, as for small models the overhead of starting the threads 
+		outweighs the gain. The learned model is the same in both cases.
+	*/
 	
 	unsigned int ALGORITHM,	NUM_SUBEPOCHS, NUM_EPOCHS, K_PARAM, DIMENSION, CHUNK_SIZE, CHUNK_WEIGHT, KERNEL, 
-		BUDGET_SIZE, K_MEANS_ITERS, MAINTENANCE_SAMPLING_STRATEGY, VERY_SPARSE_DATA;
+		BUDGET_SIZE, BUDGET_SLACK, K_MEANS_ITERS, MEDOID_SAMPLE_SIZE, LANDMARK_RESERVOIR_SIZE, NYSTROM_RANK, NYSTROM_OVERSAMPLING, MAINTENANCE_SAMPLING_STRATEGY, VERY_SPARSE_DATA, MINI_BATCH_SIZE, NUM_THREADS, PARALLEL_SCORING_MIN, SYNC_INTERVAL, NORM_RESYNC_INTERVAL;
 	double       C_PARAM, BIAS_TERM, KERNEL_GAMMA_PARAM, KERNEL_DEGREE_PARAM, KERNEL_COEF_PARAM, LAMBDA_PARAM, CLONE_PROBABILITY, CLONE_PROBABILITY_DECAY;
-	bool         VERBOSE, RANDOMIZE, OUTPUT_SCORES;
+	bool         VERBOSE, RANDOMIZE, OUTPUT_SCORES, PACKED_WEIGHTS, PARALLEL_TRAINING, STORE_MATRIX_W, FLOAT_MAPPED_DATA, OUT_OF_CORE_TRAINING;
 	
 	/*! \fn parameters(void)
 		\brief Constructor of the structure. The default values of the parameters can be modified here manually.
@@ -282,21 +397,36 @@ struct parameters
 		
 		BUDGET_SIZE                		= 50;      		// maximum number of weights per class in AMM, OR SVM budget size in BSGD, OR number of landmark points in LLSVM
 		MAINTENANCE_SAMPLING_STRATEGY	= 1;        	// 0 - smallest removal or 1 - merging maintenance in BSGD, OR sampling of landmark points in LLSVM: 0 - random; 1 - k-means; 2 - k-medoids
+		BUDGET_SLACK					= 0;			// number of SVs allowed over the budget in BSGD with removal before one removal pass brings their number back to BUDGET_SIZE
 		KERNEL							= 0;			// kernel to use in kernel-based algorithms, 0 - Gaussian, 1 - exponential, 2 - polynomial, 3 - linear, 4 - sigmoid, 5 - user-defined
 		KERNEL_GAMMA_PARAM				= 0.0;      	// sigma scale parameter in Gaussian kernel (default value of 0.0 indicates that the Gaussian kernel width for RBF kernel is set to 1/dimensionality)
 		KERNEL_DEGREE_PARAM				= 2.0;			// degree parameter in polynomial kernel, OR slope parameter in sigmoid kernel
 		KERNEL_COEF_PARAM				= 1.0;			// coefficient (intercept) in polynomial and sigmoid kernels
 		
-		K_MEANS_ITERS					= 10;			// number of k-means / k-medoids iterations during initialization
+		K_MEANS_ITERS					= 10;			// maximum number of k-means iterations / number of k-medoids iterations during initialization
+		MEDOID_SAMPLE_SIZE				= 1000;			// maximum number of members of a cluster among which k-medoids searches for the new medoid, 0 - all members
+		LANDMARK_RESERVOIR_SIZE			= 0;			// number of data points sampled from the entire training file to select the LLSVM landmark points from, 0 - the first data chunk is used
+		STORE_MATRIX_W					= 0;			// store the LLSVM transformation matrix and linear SVM weights in the model, 1 - stored, 0 - only the coefficients of the landmark points are stored
+		NYSTROM_RANK					= 0;			// rank of the approximation of the kernel matrix of the LLSVM landmark points, 0 - exact eigendecomposition
+		NYSTROM_OVERSAMPLING			= 10;			// number of additional random vectors used by the randomized eigensolver of LLSVM
+		FLOAT_MAPPED_DATA				= 1;			// keep the training data mapped by LLSVM in single precision, 1 - single precision, 0 - double precision
+		OUT_OF_CORE_TRAINING			= 0;			// train LLSVM over all data chunks stored to a temporary file, 1 - over all chunks, 0 - chunk by chunk
 
 		CLONE_PROBABILITY				= 0.0;			// probability of creating a clone weight
 		CLONE_PROBABILITY_DECAY			= 0.99;			// decay of clone probability
+		NORM_RESYNC_INTERVAL			= 1000;			// number of incremental updates of the norm of an AMM weight after which the norm is recomputed before pruning, 0 - never recomputed
 
 		VERBOSE							= 0;        	// verbose output
 		OUTPUT_SCORES					= 0;        	// output the winning class scores in addition to class predictions
+		PACKED_WEIGHTS					= 0;			// score AMM and Pegasos weights during prediction using a packed weight matrix, 1 - packed matrix, 0 - each weight separately
 		RANDOMIZE						= 1;        	// randomize (i.e., shuffle) the training data, 1 - randimization on, 0 - randomization off
 		CHUNK_SIZE						= 50000;    	// size of chunk of file loaded in budgetedData (when a file is too budget to fit in memory)
 		CHUNK_WEIGHT                	= 1000;     	// size of chunk of budgetedVector weight (since vector is split into many small parts)
+		MINI_BATCH_SIZE					= 1;			// number of training examples processed together in a single update of Pegasos and AMM online
+		PARALLEL_TRAINING				= 0;			// train Pegasos and AMM online with NUM_THREADS threads, 1 - parallel training, 0 - serial training
+		SYNC_INTERVAL					= 10000;		// number of examples after which the models of the threads of parallel AMM online are averaged, 0 - once per data chunk
+		NUM_THREADS						= 1;			// number of threads used by the parallelized parts of the algorithms, 0 - use all available cores
+		PARALLEL_SCORING_MIN			= 256;			// minimum number of AMM weights for which the weights are scored in parallel during training
 		VERY_SPARSE_DATA				= 99;        	// for sparse data, we can speed up computations by directly computing kernels from budgetedData, 99 for default, 0 and 1 when set by user;
 														// 		0 when a user wants all kernel computations done between budgetedVectors, 1 for computations between budgetedVectors and vectors 
 														//		stored in the input budgetedData; when the data is very sparse directly computing kernels with data points stored in budgetedData on
@@ -496,6 +626,19 @@ class budgetedData
 		*/	
 		virtual bool readChunk(unsigned int size, bool assign = false);
 		
+		/*! \fn unsigned int sampleReservoir(unsigned int size, budgetedData *sample)
+			\brief Reads the entire input .txt file once and keeps a uniformly random sample of its data points.
+			\param [in] size Maximum number of data points in the sample.
+			\param [out] sample Data object which receives the sampled data points, initially created using the vanilla constructor.
+			\return Total number of data points in the input file, or 0 if the data is not loaded from a file.
+			
+			The file is read independently of the currently loaded chunk, which remains unaffected, and only the memory for the sample is taken. The data points are sampled using 
+			reservoir sampling with geometric skips, "Algorithm L" from Li, Kim-Hung. "Reservoir-sampling algorithms of time complexity O(n(1 + log(N/n)))." ACM Transactions on 
+			Mathematical Software 20.4 (1994): 481-493, so that only the lines of the data points that enter the sample are parsed. The labels of the sampled data points are not kept.
+			If the input file holds no more than size data points, the sample holds all of them.
+		*/	
+		unsigned int sampleReservoir(unsigned int size, budgetedData *sample);
+		
 		/*! \fn float getElementOfVector(unsigned int vector, unsigned int element)
 			\brief Returns an element of a vector stored in \link budgetedData \endlink structure.
 			\param [in] vector Index of the vector (C-style indexing used, starting from 0; note that LibSVM format indices start from 1).
@@ -665,6 +808,10 @@ class budgetedVector
 			for (unsigned int i = 0; i < arrayLength; i++)
 				array.push_back(NULL);
 			
+			// the vectors can be created by concurrent threads of parallel training, so the IDs are taken atomically
+#ifdef _OPENMP
+			#pragma omp atomic capture
+#endif
 			weightID = id++;
 			sqrL2norm = 0.0;
 		}
@@ -717,6 +864,15 @@ class budgetedVector
 		*/	
 		virtual long double sqrNorm(void);
 		
+		/*! \fn virtual void getNonZeroElements(vector <unsigned int> *indices, vector <float> *values)
+			\brief Lists the non-zero elements of the vector.
+			\param [out] indices Zero-based indices of the non-zero elements, in increasing order.
+			\param [out] values Values of the non-zero elements.
+			
+			Only the allocated chunks of the vector are visited, so the cost is linear in the number of non-zero chunks and not in the dimensionality of the vector.
+		*/
+		virtual void getNonZeroElements(vector <unsigned int> *indices, vector <float> *values);
+		
 		/*! \fn virtual long double gaussianKernel(budgetedVector* otherVector, parameters *param)
 			\brief Computes Gaussian kernel between this budgetedVector vector and another vector stored in budgetedVector.
 			\param [in] otherVector The second input vector to RBF kernel.
@@ -964,6 +1120,13 @@ void parseInputPrompt(int argc, char **argv, bool trainingPhase, char *inputFile
 */
 void printUsagePrompt(bool trainingPhase, parameters *param);
 
+/*! \fn unsigned int getNumThreads(parameters *param)
+	\brief Returns the number of threads that the parallelized parts of the algorithms should use.
+	\param [in] param The parameters of the algorithm.
+	\return Number of threads, equal to \link parameters::NUM_THREADS \endlink, or to the number of available cores if it is set to 0; always 1 if the toolbox is compiled without OpenMP support.
+*/
+unsigned int getNumThreads(parameters *param);
+
 #ifdef __cplusplus
 }
 #endif
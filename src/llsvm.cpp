@@ -35,12 +35,45 @@ template <class T> static inline void mySwap(T& x, T& y) { T t=x; x=y; y=t; }
 template <class T> static inline T myMin(T x,T y) { return (x<y)?x:y; }
 template <class T> static inline T myMax(T x,T y) { return (x>y)?x:y; }
 
+// xorshift64* generator used to permute the data points in linear SVM solvers, it is much cheaper than rand() and each solver running in its own thread keeps its own state
+static inline unsigned int fastRandom(unsigned long long *state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return (unsigned int) ((*state * 2685821657736338717ULL) >> 32);
+}
+
+// the data mapped by LLSVM is accessed one data point at a time when training linear SVM, so it is stored row by row
+typedef Matrix<double, Dynamic, Dynamic, RowMajor> MatrixXdRowMajor;
+typedef Matrix<float, Dynamic, Dynamic, RowMajor> MatrixXfRowMajor;
+
+// the temporary file with the mapped training data can be larger than 2GB, so it is positioned using 64-bit offsets
+#ifdef _WIN32
+	#define fseek64(file, offset) _fseeki64(file, (__int64) (offset), SEEK_SET)
+#else
+	#define fseek64(file, offset) fseeko(file, (off_t) (offset), SEEK_SET)
+#endif
+
 /* prototypes of functions used in llsvm.cpp to find the mapping function; for details see the documentation for each function below
 void invSquareRoot(MatrixXd &A);
-MatrixXd sqDist(MatrixXd &A, MatrixXd &B);
-void kMeans(MatrixXd &data, unsigned int numClusters, unsigned int maxIter, MatrixXd &center);
+void randomizedInvSquareRoot(MatrixXd &A, unsigned int rank, unsigned int oversampling);
+void orthonormalizeColumns(MatrixXd &A);
+void indexCenters(vector <kMeansCenter> *centers, unsigned int dim, kMeansIndex *index);
+void dotsWithCenters(budgetedData *data, unsigned int t, vector <kMeansCenter> *centers, kMeansIndex *index, vector <double> *dots);
+double dotWithCenter(budgetedData *data, unsigned int t, kMeansCenter *center);
+double dotBetweenCenters(kMeansCenter *a, kMeansCenter *b);
+void setCenterToPoint(budgetedData *data, unsigned int t, kMeansCenter *center);
+double kernelFromDotProduct(double dot, double sqrNormA, double sqrNormB, parameters *param);
+void prepareLandmarks(vector <budgetedVectorLLSVM*> *vectors, parameters *param, landmarkMatrix *landmarks);
+void landmarkKernelMatrix(landmarkMatrix *landmarks, parameters *param, MatrixXd &K);
+template <typename MatrixType> void mapToLandmarkSpace(budgetedData *data, landmarkMatrix *landmarks, const MatrixXd &W, parameters *param, MatrixType &mapped);
+void seedCenters(budgetedData *data, parameters *param, vector <double> *pointNorms, vector <kMeansCenter> *centers);
+void kMeans(budgetedData *data, parameters *param, vector <kMeansCenter> *centers);
 void kMedoids(budgetedData *trainData, parameters *param, unsigned int *medoidIndex);
-void liblinear_Solve_l2r_l1(const MatrixXd &X, unsigned char *y, VectorXd &w, parameters *param, vector <int> *yLabels);
+template <typename MatrixType> void liblinear_Solve_l2r_l1(const MatrixType &X, unsigned char *y, VectorXd &w, parameters *param, unsigned char positiveLabel, unsigned int seed);
+template <typename MatrixType> void liblinear_Solve_oneVsRest(const MatrixType &X, unsigned char *y, MatrixXd &weights, parameters *param);
+void liblinear_Solve_l2r_l1_outOfCore(FILE *mappedFile, vector <unsigned char> *y, MatrixXd &weights, parameters *param);
 */
 
 /*! \fn void invSquareRoot(MatrixXd &A)
@@ -63,111 +96,888 @@ void invSquareRoot(MatrixXd &A)
 	A = eigVecW * res;
 }
 
-/*! \fn MatrixXd sqDist(MatrixXd &A, MatrixXd &B)
-	\brief Computes squared Euclidean distance between rows of matrices A and B.
-	\param [in] A The first matrix with data points in rows.
-	\param [in] B The second matrix with data points in rows.
-	\return Matrix of distances between data points in A and data points in B.
+/*! \fn void orthonormalizeColumns(MatrixXd &A)
+	\brief Replaces the columns of the input matrix by an orthonormal basis of their span, found by Householder QR decomposition.
+	\param [in,out] A Matrix with no more columns than rows, whose columns are to be orthonormalized.
+*/
+void orthonormalizeColumns(MatrixXd &A)
+{
+	HouseholderQR<MatrixXd> qr(A);
+	A = qr.householderQ() * MatrixXd::Identity(A.rows(), A.cols());
+}
+
+/*! \fn void randomizedInvSquareRoot(MatrixXd &A, unsigned int rank, unsigned int oversampling)
+	\brief Computes square root of inverse of the input matrix restricted to its leading eigenvectors, found by a randomized eigensolver.
+	\param [in,out] A Symmetric positive semi-definite matrix whose square root of inverse is to be computed, replaced by a matrix with at most \a rank columns.
+	\param [in] rank Number of leading eigenpairs that are kept.
+	\param [in] oversampling Number of random vectors used in addition to \a rank to find the range of the matrix.
 	
-	The function computes a matrix of distances between data points in A and data points in B. If the return matrix is C, then, e.g., C(0, 1) is a distance between the first row in matrix A and the second row in matrix B.
+	Follows "Finding structure with randomness: Probabilistic algorithms for constructing approximate matrix decompositions" by Halko, Martinsson, and Tropp. 
+	The input matrix is multiplied by (rank + oversampling) Gaussian random vectors, followed by power iterations that sharpen the decay of the spectrum, and the 
+	eigendecomposition of A restricted to the orthonormal basis Q of the resulting range, Q' * A * Q, gives approximate eigenpairs A ~ U * V * U'. The result is then
+	U * V.^(-0.5) for the leading eigenpairs, computed in O(n^2 * rank) time instead of O(n^3) time taken by the exact eigendecomposition.
 */
-MatrixXd sqDist(MatrixXd &A, MatrixXd &B)
+void randomizedInvSquareRoot(MatrixXd &A, unsigned int rank, unsigned int oversampling)
 {
-	MatrixXd aa = A.rowwise().squaredNorm();
-	MatrixXd bb = B.rowwise().squaredNorm();
-	MatrixXd dist = (MatrixXd)(- 2.0 * A * B.transpose());
+	const unsigned int numPowerIterations = 2;
+	unsigned int n = (unsigned int) A.rows(), numVectors = myMin(rank + oversampling, n), numKept = 0, i, j;
+	MatrixXd Q(n, numVectors), AQ, T;
+	double u1, u2, maxVal, twoPi = 8.0 * atan(1.0);
+	
+	// Gaussian random vectors, using Box-Muller transform
+	for (j = 0; j < numVectors; j++)
+	{
+		for (i = 0; i < n; i++)
+		{
+			u1 = ((double) rand() + 1.0) / ((double) RAND_MAX + 2.0);
+			u2 = (double) rand() / ((double) RAND_MAX + 1.0);
+			Q(i, j) = sqrt(-2.0 * log(u1)) * cos(twoPi * u2);
+		}
+	}
 	
-	for (int i = 0; i < dist.cols(); i++)
-		dist.col(i) += aa;
-	for (int i = 0; i < dist.rows(); i++)
-		dist.row(i) += bb.transpose();
+	// find the range of A, re-orthonormalizing the basis after each multiplication to keep the small eigenvalues from being lost to rounding errors
+	Q = A * Q;
+	for (i = 0; i < numPowerIterations; i++)
+	{
+		orthonormalizeColumns(Q);
+		Q = A * Q;
+	}
+	orthonormalizeColumns(Q);
 	
-	dist = dist.cwiseAbs();
-	return dist;
+	// the eigenvalues are returned in increasing order, keep the leading ones that are not too small, as in the exact computation
+	AQ = A * Q;
+	T = Q.transpose() * AQ;
+	SelfAdjointEigenSolver<MatrixXd> eigensolver(T);
+	maxVal = eigensolver.eigenvalues()(numVectors - 1);
+	for (i = 0; (i < myMin(rank, numVectors)) && (eigensolver.eigenvalues()(numVectors - 1 - i) > maxVal * 1E-5); i++)
+		numKept++;
+	
+	A = Q * eigensolver.eigenvectors().rightCols(numKept).rowwise().reverse();
+	for (i = 0; i < numKept; i++)
+		A.col(i) /= sqrt(eigensolver.eigenvalues()(numVectors - 1 - i));
 }
-/*! \fn void kMeans(MatrixXd &data, unsigned int numClusters, unsigned int maxIter, MatrixXd &center)
 
-	\brief Selects the landmark points from the input data using k-means algorithm.
-	\param [in] data Data which is input to k-means.
-	\param [in] numClusters Number of clusters that will be found.
-	\param [in] maxIter Number of iterations of k-means.
-	\param [out] center The cluster centers after k-means.
+/*! \struct kMeansCenter
+	\brief Cluster center found by k-means, kept either as a dense vector or as a list of its non-zero elements, whichever takes less memory.
 	
-	The function selects the landmark points from the input data using k-means algorithm, used as an initialization of LLSVM.
+	Centers of sparse high-dimensional data have only as many non-zero elements as there are distinct features in the points of their clusters, so keeping them 
+	as dense vectors of length DIMENSION, as well as expanding the data points to dense vectors, can take orders of magnitude more memory than the data itself.
+*/
+struct kMeansCenter
+{
+	vector <unsigned int> indices;	// zero-based indices of the non-zero elements in increasing order, used only if the center is sparse
+	vector <double> values;			// values of the non-zero elements of a sparse center, or all elements of a dense center
+	bool isDense;
+	double sqrNorm;
+};
+
+/*! \struct kMeansIndex
+	\brief Inverted index of the k-means centers, which lists for each feature the sparse centers that have it, used to compute the dot products of a data point with all centers at once.
+*/
+struct kMeansIndex
+{
+	vector <unsigned int> featureStart;		// position of the first posting of each feature, of length (DIMENSION + 1)
+	vector <unsigned int> postingCenter;	// index of the center of each posting
+	vector <double> postingValue;			// value of the element of the center of each posting
+	vector <unsigned int> denseCenters;		// indices of the dense centers, which are not in the postings
+};
+
+/*! \fn void indexCenters(vector <kMeansCenter> *centers, unsigned int dim, kMeansIndex *index)
+	\brief Builds an inverted index of the non-zero elements of the sparse k-means centers.
+	\param [in] centers The k-means centers.
+	\param [in] dim Dimensionality of the data.
+	\param [out] index Inverted index of the centers.
 */
-void kMeans(MatrixXd &data, unsigned int numClusters, unsigned int maxIter, MatrixXd &center)
+void indexCenters(vector <kMeansCenter> *centers, unsigned int dim, kMeansIndex *index)
 {
-	unsigned int N = (unsigned int) data.rows(), dim = (unsigned int) data.cols(), counter, iter, i, cluster;
-	MatrixXd dist;
+	unsigned int cluster, i, numPostings = 0;
 	
-	// randomize
-	vector <int> rnd(N, 0);
-	for (i = 0; i < N; i++)
+	(*index).featureStart.assign(dim + 1, 0);
+	(*index).denseCenters.clear();
+	for (cluster = 0; cluster < (unsigned int) (*centers).size(); cluster++)
 	{
-		rnd[i] = i;
+		if ((*centers)[cluster].isDense)
+		{
+			(*index).denseCenters.push_back(cluster);
+			continue;
+		}
+		for (i = 0; i < (unsigned int) (*centers)[cluster].indices.size(); i++)
+			(*index).featureStart[(*centers)[cluster].indices[i] + 1]++;
+		numPostings += (unsigned int) (*centers)[cluster].indices.size();
 	}
-	random_shuffle(rnd.begin(), rnd.end());
+	for (i = 0; i < dim; i++)
+		(*index).featureStart[i + 1] += (*index).featureStart[i];
 	
-	// random select initial cluster centers
-	for (i = 0; i < numClusters; i++)
+	(*index).postingCenter.resize(numPostings);
+	(*index).postingValue.resize(numPostings);
+	for (cluster = 0; cluster < (unsigned int) (*centers).size(); cluster++)
+	{
+		if ((*centers)[cluster].isDense)
+			continue;
+		for (i = 0; i < (unsigned int) (*centers)[cluster].indices.size(); i++)
+		{
+			unsigned int &position = (*index).featureStart[(*centers)[cluster].indices[i]];
+			(*index).postingCenter[position] = cluster;
+			(*index).postingValue[position] = (*centers)[cluster].values[i];
+			position++;
+		}
+	}
+	
+	// the positions were moved to the end of each feature's postings, shift them back
+	for (i = dim; i > 0; i--)
+		(*index).featureStart[i] = (*index).featureStart[i - 1];
+	(*index).featureStart[0] = 0;
+}
+
+/*! \fn void dotsWithCenters(budgetedData *data, unsigned int t, vector <kMeansCenter> *centers, kMeansIndex *index, vector <double> *dots)
+	\brief Computes the dot products of a data point with all k-means centers.
+	\param [in] data Input data.
+	\param [in] t Index of the data point in the input data.
+	\param [in] centers The k-means centers.
+	\param [in] index Inverted index of the centers.
+	\param [out] dots Dot products of the data point with the centers.
+	
+	For each non-zero feature of the point, only the dense centers and the sparse centers that have the feature are visited.
+*/
+void dotsWithCenters(budgetedData *data, unsigned int t, vector <kMeansCenter> *centers, kMeansIndex *index, vector <double> *dots)
+{
+	unsigned int j, k, feature, iend = (t == data->N - 1) ? (unsigned int) data->aj.size() : data->ai[t + 1];
+	double value;
+	
+	(*dots).assign((*centers).size(), 0.0);
+	for (j = data->ai[t]; j < iend; j++)
+	{
+		value = (double) data->an[j];
+		feature = data->aj[j] - 1;
+		for (k = (*index).featureStart[feature]; k < (*index).featureStart[feature + 1]; k++)
+			(*dots)[(*index).postingCenter[k]] += value * (*index).postingValue[k];
+		for (k = 0; k < (unsigned int) (*index).denseCenters.size(); k++)
+			(*dots)[(*index).denseCenters[k]] += value * (*centers)[(*index).denseCenters[k]].values[feature];
+	}
+}
+
+/*! \fn double dotWithCenter(budgetedData *data, unsigned int t, kMeansCenter *center)
+	\brief Computes the dot product of a data point with a single k-means center.
+	\param [in] data Input data.
+	\param [in] t Index of the data point in the input data.
+	\param [in] center The k-means center.
+	\return The dot product of the data point and the center.
+	
+	The non-zero features of the point are looked up in a sparse center by binary search.
+*/
+double dotWithCenter(budgetedData *data, unsigned int t, kMeansCenter *center)
+{
+	unsigned int j, iend = (t == data->N - 1) ? (unsigned int) data->aj.size() : data->ai[t + 1];
+	double result = 0.0;
+	vector <unsigned int>::iterator it;
+	
+	for (j = data->ai[t]; j < iend; j++)
+	{
+		if ((*center).isDense)
+			result += (double) data->an[j] * (*center).values[data->aj[j] - 1];
+		else
+		{
+			it = lower_bound((*center).indices.begin(), (*center).indices.end(), data->aj[j] - 1);
+			if ((it != (*center).indices.end()) && (*it == data->aj[j] - 1))
+				result += (double) data->an[j] * (*center).values[it - (*center).indices.begin()];
+		}
+	}
+	return result;
+}
+
+/*! \fn double dotBetweenCenters(kMeansCenter *a, kMeansCenter *b)
+	\brief Computes the dot product of two k-means centers.
+	\param [in] a The first center.
+	\param [in] b The second center.
+	\return The dot product of the centers.
+*/
+double dotBetweenCenters(kMeansCenter *a, kMeansCenter *b)
+{
+	double result = 0.0;
+	unsigned int i, j;
+	
+	if ((*a).isDense && (*b).isDense)
+	{
+		for (i = 0; i < (unsigned int) (*a).values.size(); i++)
+			result += (*a).values[i] * (*b).values[i];
+	}
+	else if ((*a).isDense || (*b).isDense)
+	{
+		kMeansCenter *dense = (*a).isDense ? a : b, *sparse = (*a).isDense ? b : a;
+		for (i = 0; i < (unsigned int) (*sparse).indices.size(); i++)
+			result += (*sparse).values[i] * (*dense).values[(*sparse).indices[i]];
+	}
+	else
 	{
-		center.row(i) = data.row(rnd[i]);
+		// merge the sorted lists of non-zero elements
+		for (i = 0, j = 0; (i < (unsigned int) (*a).indices.size()) && (j < (unsigned int) (*b).indices.size()); )
+		{
+			if ((*a).indices[i] < (*b).indices[j])
+				i++;
+			else if ((*a).indices[i] > (*b).indices[j])
+				j++;
+			else
+				result += (*a).values[i++] * (*b).values[j++];
+		}
+	}
+	return result;
+}
+
+/*! \fn void setCenterToPoint(budgetedData *data, unsigned int t, kMeansCenter *center)
+	\brief Sets a k-means center to a data point, kept as a sparse center.
+	\param [in] data Input data.
+	\param [in] t Index of the data point in the input data.
+	\param [out] center The k-means center.
+*/
+void setCenterToPoint(budgetedData *data, unsigned int t, kMeansCenter *center)
+{
+	unsigned int iend = (t == data->N - 1) ? (unsigned int) data->aj.size() : data->ai[t + 1];
+	
+	(*center).isDense = false;
+	(*center).indices.clear();
+	(*center).values.clear();
+	(*center).sqrNorm = 0.0;
+	for (unsigned int i = data->ai[t]; i < iend; i++)
+	{
+		(*center).indices.push_back(data->aj[i] - 1);
+		(*center).values.push_back((double) data->an[i]);
+		(*center).sqrNorm += (double) data->an[i] * (double) data->an[i];
 	}
 	
-	unsigned int *idx = new unsigned int[N];
-	for (iter = 0; iter < maxIter; iter++)
+	// the features of a data point are not required to be sorted
+	if (!is_sorted((*center).indices.begin(), (*center).indices.end()))
 	{
-		dist = sqDist(center, data);
+		vector < pair <unsigned int, double> > elements((*center).indices.size());
+		for (unsigned int i = 0; i < (unsigned int) elements.size(); i++)
+			elements[i] = make_pair((*center).indices[i], (*center).values[i]);
+		sort(elements.begin(), elements.end());
+		for (unsigned int i = 0; i < (unsigned int) elements.size(); i++)
+		{
+			(*center).indices[i] = elements[i].first;
+			(*center).values[i] = elements[i].second;
+		}
+	}
+}
+
+/*! \fn double kernelFromDotProduct(double dot, double sqrNormA, double sqrNormB, parameters *param)
+	\brief Computes the kernel between two vectors from their dot product and squared norms.
+	\param [in] dot Dot product of the two vectors.
+	\param [in] sqrNormA Squared L2-norm of the first vector.
+	\param [in] sqrNormB Squared L2-norm of the second vector.
+	\param [in] param The parameters of the algorithm.
+	\return Value of the kernel between the two vectors.
+	
+	Gives the same values as budgetedVector::computeKernel() for all but the user-defined kernel, using ||x - y||^2 = ||x||^2 - 2 * x^T * y + ||y||^2 for Gaussian and exponential kernels.
+*/
+double kernelFromDotProduct(double dot, double sqrNormA, double sqrNormB, parameters *param)
+{
+	switch ((*param).KERNEL)
+	{
+		case KERNEL_FUNC_GAUSSIAN:
+			return exp(-0.5 * (*param).KERNEL_GAMMA_PARAM * (sqrNormA + sqrNormB - 2.0 * dot));
 		
-		MatrixXd::Index minRow, minCol;
-		for (i = 0; i < N; i++)
+		case KERNEL_FUNC_EXPONENTIAL:
+			return exp(-0.5 * (*param).KERNEL_GAMMA_PARAM * sqrt(myMax(sqrNormA + sqrNormB - 2.0 * dot, 0.0)));
+		
+		case KERNEL_FUNC_SIGMOID:
+			return tanh((*param).KERNEL_COEF_PARAM + (*param).KERNEL_DEGREE_PARAM * dot);
+		
+		case KERNEL_FUNC_POLYNOMIAL:
+			return pow((*param).KERNEL_COEF_PARAM + dot, (*param).KERNEL_DEGREE_PARAM);
+		
+		case KERNEL_FUNC_LINEAR:
+			return dot;
+		
+		default:
+			svmPrintErrorString("Error, undefined kernel function found! Run 'budgetedsvm-train' for help.\n");
+			return -1.0;
+	}
+}
+
+/*! \struct landmarkMatrix
+	\brief Landmark points of LLSVM, kept in a form that allows computing their kernels with many vectors at once.
+	
+	Unless the data is very sparse, the landmark points are expanded into a dense matrix so that their dot products with a block of vectors are a single matrix product, 
+	otherwise they are kept as lists of their non-zero elements, indexed by feature in the same way as the sparse k-means centers. \sa parameters::VERY_SPARSE_DATA
+*/
+struct landmarkMatrix
+{
+	vector <budgetedVectorLLSVM*> *vectors;	// the landmark points, used to compute the user-defined kernel
+	vector <kMeansCenter> points;			// non-zero elements and squared norms of the landmark points
+	kMeansIndex index;						// inverted index of the non-zero elements of the landmark points, used if the data is very sparse
+	MatrixXd dense;							// (BUDGET_SIZE x DIMENSION) matrix of the landmark points, used if the data is not very sparse
+	vector <double> bias;					// elements of the landmark points that correspond to the bias term, used if the data is very sparse
+};
+
+/*! \fn void prepareLandmarks(vector <budgetedVectorLLSVM*> *vectors, parameters *param, landmarkMatrix *landmarks)
+	\brief Extracts the landmark points into the form used to compute their kernels.
+	\param [in] vectors The landmark points.
+	\param [in] param The parameters of the algorithm.
+	\param [out] landmarks The landmark points, expanded into a dense matrix or indexed by feature depending on the sparsity of the data.
+*/
+void prepareLandmarks(vector <budgetedVectorLLSVM*> *vectors, parameters *param, landmarkMatrix *landmarks)
+{
+	unsigned int numLandmarks = (unsigned int) (*vectors).size(), i, k;
+	vector <float> nonZeroValues;
+	
+	(*landmarks).vectors = vectors;
+	(*landmarks).points.resize(numLandmarks);
+	(*landmarks).bias.assign(numLandmarks, 0.0);
+	for (i = 0; i < numLandmarks; i++)
+	{
+		kMeansCenter &point = (*landmarks).points[i];
+		(*vectors)[i]->getNonZeroElements(&(point.indices), &nonZeroValues);
+		point.values.assign(nonZeroValues.begin(), nonZeroValues.end());
+		point.isDense = false;
+		point.sqrNorm = 0.0;
+		for (k = 0; k < (unsigned int) point.values.size(); k++)
+			point.sqrNorm += point.values[k] * point.values[k];
+		if (((*param).BIAS_TERM != 0.0) && (point.indices.size() > 0) && (point.indices.back() == (*param).DIMENSION - 1))
+			(*landmarks).bias[i] = point.values.back();
+	}
+	
+	if ((*param).VERY_SPARSE_DATA)
+	{
+		indexCenters(&((*landmarks).points), (*param).DIMENSION, &((*landmarks).index));
+		(*landmarks).dense.resize(0, 0);
+	}
+	else
+	{
+		(*landmarks).dense = MatrixXd::Zero(numLandmarks, (*param).DIMENSION);
+		for (i = 0; i < numLandmarks; i++)
+		{
+			for (k = 0; k < (unsigned int) (*landmarks).points[i].indices.size(); k++)
+				(*landmarks).dense(i, (*landmarks).points[i].indices[k]) = (*landmarks).points[i].values[k];
+		}
+	}
+}
+
+/*! \fn void landmarkKernelMatrix(landmarkMatrix *landmarks, parameters *param, MatrixXd &K)
+	\brief Computes the kernel matrix of the landmark points.
+	\param [in] landmarks The landmark points.
+	\param [in] param The parameters of the algorithm.
+	\param [out] K The (BUDGET_SIZE x BUDGET_SIZE) kernel matrix.
+	
+	The matrix of dot products of the landmark points is computed first, split into square blocks of which only the blocks on and above the diagonal are computed, in 
+	parallel. Unless the data is very sparse each block is a product of two row blocks of the dense matrix of the landmark points, otherwise one landmark point at a 
+	time is scattered into a dense vector and its dot products with the landmark points of the block are computed from their non-zero elements. The kernel is then 
+	found from the dot products and the squared norms of the landmark points on the diagonal, which is much faster than computing each kernel separately with 
+	budgetedVector::computeKernel(), used only for the user-defined kernel.
+*/
+void landmarkKernelMatrix(landmarkMatrix *landmarks, parameters *param, MatrixXd &K)
+{
+	const unsigned int blockSize = 256;
+	unsigned int numLandmarks = (unsigned int) (*landmarks).points.size(), numBlocks = (numLandmarks + blockSize - 1) / blockSize, i, j;
+	vector <unsigned int> blockRow, blockCol;
+	VectorXd sqrNorms;
+	
+	K.resize(numLandmarks, numLandmarks);
+	if ((*param).KERNEL == KERNEL_FUNC_USER_DEFINED)
+	{
+		for (i = 0; i < numLandmarks; i++)
 		{
-			dist.col(i).minCoeff(&minRow, &minCol);			
-			idx[i] = (unsigned int) minRow;
+			for (j = i; j < numLandmarks; j++)
+				K(i, j) = K(j, i) = (double) (*((*landmarks).vectors))[i]->computeKernel((*((*landmarks).vectors))[j], param);
 		}
+		return;
+	}
+	
+	// list the blocks on and above the diagonal
+	for (i = 0; i < numBlocks; i++)
+	{
+		for (j = i; j < numBlocks; j++)
+		{
+			blockRow.push_back(i);
+			blockCol.push_back(j);
+		}
+	}
+	
+#ifdef _OPENMP
+	#pragma omp parallel num_threads(getNumThreads(param))
+#endif
+	{
+		vector <double> scattered;
+		if ((*param).VERY_SPARSE_DATA)
+			scattered.assign((*param).DIMENSION, 0.0);
 		
-		for (cluster = 0; cluster < numClusters; cluster++)
-		{	
-			counter = 0;
-			MatrixXd tempMean = MatrixXd::Zero(1, dim);
-			for (i = 0; i < N; i++)
+#ifdef _OPENMP
+		#pragma omp for schedule(dynamic, 1)
+#endif
+		for (int b = 0; b < (int) blockRow.size(); b++)
+		{
+			unsigned int rowStart = blockRow[b] * blockSize, rowEnd = myMin(rowStart + blockSize, numLandmarks);
+			unsigned int colStart = blockCol[b] * blockSize, colEnd = myMin(colStart + blockSize, numLandmarks);
+			
+			if (!(*param).VERY_SPARSE_DATA)
+			{
+				K.block(rowStart, colStart, rowEnd - rowStart, colEnd - colStart).noalias() = 
+					(*landmarks).dense.middleRows(rowStart, rowEnd - rowStart) * (*landmarks).dense.middleRows(colStart, colEnd - colStart).transpose();
+				continue;
+			}
+			
+			for (unsigned int r = rowStart; r < rowEnd; r++)
 			{
-				if (idx[i] == cluster)
+				kMeansCenter &row = (*landmarks).points[r];
+				for (unsigned int n = 0; n < (unsigned int) row.indices.size(); n++)
+					scattered[row.indices[n]] = row.values[n];
+				for (unsigned int c = colStart; c < colEnd; c++)
 				{
-					counter++;
-					tempMean += data.row(i);
+					kMeansCenter &col = (*landmarks).points[c];
+					double dot = 0.0;
+					for (unsigned int n = 0; n < (unsigned int) col.indices.size(); n++)
+						dot += col.values[n] * scattered[col.indices[n]];
+					K(r, c) = dot;
 				}
+				for (unsigned int n = 0; n < (unsigned int) row.indices.size(); n++)
+					scattered[row.indices[n]] = 0.0;
 			}
+		}
+	}
+	
+	// compute the kernels from the dot products above the diagonal, and copy them below the diagonal
+	sqrNorms = K.diagonal();
+#ifdef _OPENMP
+	#pragma omp parallel for num_threads(getNumThreads(param)) schedule(dynamic, 16)
+#endif
+	for (int r = 0; r < (int) numLandmarks; r++)
+	{
+		for (unsigned int c = (unsigned int) r; c < numLandmarks; c++)
+			K(r, c) = kernelFromDotProduct(K(r, c), sqrNorms(r), sqrNorms(c), param);
+	}
+	for (i = 1; i < numLandmarks; i++)
+	{
+		for (j = 0; j < i; j++)
+			K(i, j) = K(j, i);
+	}
+}
+
+/*! \fn template <typename MatrixType> void mapToLandmarkSpace(budgetedData *data, landmarkMatrix *landmarks, const MatrixXd &W, parameters *param, MatrixType &mapped)
+	\brief Maps the data points into the space defined by the landmark points and the transformation matrix.
+	\param [in] data Input data.
+	\param [in] landmarks The landmark points.
+	\param [in] W The transformation matrix.
+	\param [in] param The parameters of the algorithm.
+	\param [out] mapped The mapped data points, equal to E * W where E is the matrix of kernels between the data points and the landmark points, with one row per data point.
+	
+	The data points are processed in blocks of rows, in parallel. For each block the dot products with all landmark points are found either as a product of the block, 
+	expanded into a dense matrix, and the dense matrix of the landmark points, or, if the data is very sparse, from the inverted index of the landmark points. The kernels 
+	are then computed from the dot products and the cached squared norms, and the block is multiplied by the transformation matrix right away, so that the whole 
+	(N x BUDGET_SIZE) matrix E is never kept in memory. The mapped data can be kept in single precision to halve its memory. \sa parameters::FLOAT_MAPPED_DATA
+*/
+template <typename MatrixType>
+void mapToLandmarkSpace(budgetedData *data, landmarkMatrix *landmarks, const MatrixXd &W, parameters *param, MatrixType &mapped)
+{
+	const unsigned int blockSize = 256;
+	unsigned int N = data->N, numLandmarks = (unsigned int) (*landmarks).points.size(), numBlocks = (N + blockSize - 1) / blockSize;
+	bool userDefined = ((*param).KERNEL == KERNEL_FUNC_USER_DEFINED);
+	
+	mapped.resize(N, W.cols());
+	
+	// the user-defined kernel is not assumed to be thread-safe
+#ifdef _OPENMP
+	#pragma omp parallel num_threads(getNumThreads(param)) if (!userDefined)
+#endif
+	{
+		MatrixXd E(blockSize, numLandmarks), denseBlock;
+		vector <double> dots, sqrNorms(blockSize);
+		if (!(*param).VERY_SPARSE_DATA)
+			denseBlock = MatrixXd::Zero(blockSize, (*param).DIMENSION);
+		
+#ifdef _OPENMP
+		#pragma omp for schedule(dynamic, 1)
+#endif
+		for (int b = 0; b < (int) numBlocks; b++)
+		{
+			unsigned int start = (unsigned int) b * blockSize, rows = myMin(blockSize, N - start), r, c, j, jend;
 			
-			if (counter > 0)
+			for (r = 0; r < rows; r++)
 			{
-				center.row(cluster) = (tempMean / (double) counter);
+				sqrNorms[r] = (double) data->getVectorSqrL2Norm(start + r, param);
+				if (userDefined)
+				{
+					for (c = 0; c < numLandmarks; c++)
+						E(r, c) = (double) (*((*landmarks).vectors))[c]->computeKernel(start + r, data, param, (long double) sqrNorms[r]);
+				}
+				else if ((*param).VERY_SPARSE_DATA)
+				{
+					dotsWithCenters(data, start + r, &((*landmarks).points), &((*landmarks).index), &dots);
+					for (c = 0; c < numLandmarks; c++)
+						E(r, c) = dots[c] + (*param).BIAS_TERM * (*landmarks).bias[c];
+				}
+				else
+				{
+					jend = (start + r == N - 1) ? (unsigned int) data->aj.size() : data->ai[start + r + 1];
+					for (j = data->ai[start + r]; j < jend; j++)
+						denseBlock(r, data->aj[j] - 1) = (double) data->an[j];
+					if ((*param).BIAS_TERM != 0.0)
+						denseBlock(r, (*param).DIMENSION - 1) = (*param).BIAS_TERM;
+				}
 			}
-			else
+			
+			if (userDefined)
 			{
-				// do not remove the cluster, randomly select one point as the new center
-				center.row(cluster) = data.row(rand() % N);
+				mapped.middleRows(start, rows) = (E.topRows(rows) * W).template cast <typename MatrixType::Scalar>();
+				continue;
 			}
+			
+			if (!(*param).VERY_SPARSE_DATA)
+			{
+				E.topRows(rows).noalias() = denseBlock.topRows(rows) * (*landmarks).dense.transpose();
+				
+				// clear the block for the next use
+				for (r = 0; r < rows; r++)
+				{
+					jend = (start + r == N - 1) ? (unsigned int) data->aj.size() : data->ai[start + r + 1];
+					for (j = data->ai[start + r]; j < jend; j++)
+						denseBlock(r, data->aj[j] - 1) = 0.0;
+				}
+			}
+			
+			for (r = 0; r < rows; r++)
+			{
+				for (c = 0; c < numLandmarks; c++)
+					E(r, c) = kernelFromDotProduct(E(r, c), sqrNorms[r], (*landmarks).points[c].sqrNorm, param);
+			}
+			mapped.middleRows(start, rows) = (E.topRows(rows) * W).template cast <typename MatrixType::Scalar>();
 		}
 	}
-	delete [] idx;
+}
+
+/*! \fn void seedCenters(budgetedData *data, parameters *param, vector <double> *pointNorms, vector <kMeansCenter> *centers)
+	\brief Chooses the initial k-means centers among the data points using k-means++ seeding.
+	\param [in] data Input data.
+	\param [in] param The parameters of the algorithm.
+	\param [in] pointNorms Squared norms of the data points.
+	\param [out] centers The initial centers.
+	
+	The first center is a random data point, and each next center is a data point chosen with probability proportional to its squared distance from the closest
+	already chosen center, as proposed in "k-means++: The Advantages of Careful Seeding" by Arthur and Vassilvitskii. The spread-out initial centers reduce the 
+	number of iterations needed by k-means. The distances from the newly chosen center are computed in parallel over the points, by scattering the center into a 
+	dense vector.
+*/
+void seedCenters(budgetedData *data, parameters *param, vector <double> *pointNorms, vector <kMeansCenter> *centers)
+{
+	unsigned int N = data->N, numClusters = (*param).BUDGET_SIZE, cluster, i, chosen = (unsigned int) (rand() % N);
+	vector <double> minDist(N, INF), scatteredCenter((*param).DIMENSION, 0.0);
+	double total, threshold;
+	
+	(*centers).resize(numClusters);
+	for (cluster = 0; cluster < numClusters; cluster++)
+	{
+		kMeansCenter &center = (*centers)[cluster];
+		setCenterToPoint(data, chosen, &center);
+		if (cluster == numClusters - 1)
+			break;
+		
+		for (i = 0; i < (unsigned int) center.indices.size(); i++)
+			scatteredCenter[center.indices[i]] = center.values[i];
+#ifdef _OPENMP
+		#pragma omp parallel for num_threads(getNumThreads(param)) schedule(static)
+#endif
+		for (int t = 0; t < (int) N; t++)
+		{
+			unsigned int iend = ((unsigned int) t == N - 1) ? (unsigned int) data->aj.size() : data->ai[t + 1];
+			double dot = 0.0, dist;
+			for (unsigned int j = data->ai[t]; j < iend; j++)
+				dot += (double) data->an[j] * scatteredCenter[data->aj[j] - 1];
+			dist = fabs((*pointNorms)[t] + center.sqrNorm - 2.0 * dot);
+			if (dist < minDist[t])
+				minDist[t] = dist;
+		}
+		for (i = 0; i < (unsigned int) center.indices.size(); i++)
+			scatteredCenter[center.indices[i]] = 0.0;
+		
+		// sample the next center, summing the distances serially so that the choice does not depend on the number of threads
+		total = 0.0;
+		for (i = 0; i < N; i++)
+			total += minDist[i];
+		if (total <= 0.0)
+		{
+			chosen = (unsigned int) (rand() % N);
+			continue;
+		}
+		threshold = total * ((double) rand() / ((double) RAND_MAX + 1.0));
+		for (chosen = 0; chosen < N - 1; chosen++)
+		{
+			threshold -= minDist[chosen];
+			if (threshold < 0.0)
+				break;
+		}
+	}
+}
+
+/*! \fn void kMeans(budgetedData *data, parameters *param, vector <kMeansCenter> *centers)
+	\brief Selects the landmark points from the input data using k-means algorithm.
+	\param [in] data Data which is input to k-means, in its sparse representation.
+	\param [in] param The parameters of the algorithm, where \link parameters::BUDGET_SIZE \endlink clusters are found in at most \link parameters::K_MEANS_ITERS \endlink iterations.
+	\param [out] centers The cluster centers after k-means.
+	
+	The function selects the landmark points from the input data using k-means algorithm, used as an initialization of LLSVM. It works directly on the sparse data points,
+	where the squared distance between a point and a center is computed as ||x||^2 + ||c||^2 - 2 * x^T * c from the cached squared norms of the points and the centers. 
+	The dot products of a point with all centers are computed together, by visiting for each non-zero feature of the point the dense centers and, through an inverted 
+	index, only those sparse centers that have the feature.
+	
+	The initial centers are chosen by k-means++ seeding, and most distance computations of the assignment step are skipped using the bounds of "Making k-means even 
+	faster" by Hamerly. Each point keeps an upper bound on the distance to its assigned center and a lower bound on the distance to any other center. The bounds are 
+	loosened by the distances the centers moved, and the closest center of a point is searched for only if its upper bound exceeds both its lower bound and half of the 
+	distance between its center and the closest other center. The iterations stop once no point changes its cluster. The new centers are computed in a single pass over 
+	the points sorted by their clusters, by summing the points of each cluster into a dense accumulator, and each center is then stored either as a dense or as a sparse 
+	vector. The assignment step and the update of the centers are done in parallel over the points and over the clusters, respectively, and the found centers do not 
+	depend on the number of threads. The memory taken besides the data and the centers is O(N + DIMENSION) per thread, instead of O(N x DIMENSION) taken by the dense data matrix.
+*/
+void kMeans(budgetedData *data, parameters *param, vector <kMeansCenter> *centers)
+{
+	unsigned int N = data->N, dim = (*param).DIMENSION, numClusters = (*param).BUDGET_SIZE, iter, i, j, cluster, iend, farthest = 0;
+	unsigned int numChanged = 0, numIters = 0;
+	double maxDrift, secondMaxDrift, numEvaluations = 0.0;
+	char text[1024];
+	
+	// cache the squared norms of the points
+	vector <double> pointNorms(N, 0.0);
+	for (i = 0; i < N; i++)
+	{
+		iend = (i == N - 1) ? (unsigned int) data->aj.size() : data->ai[i + 1];
+		for (j = data->ai[i]; j < iend; j++)
+			pointNorms[i] += (double) data->an[j] * (double) data->an[j];
+	}
+	seedCenters(data, param, &pointNorms, centers);
+	
+	vector <unsigned int> idx(N, numClusters), clusterStart(numClusters + 1), sortedPoints(N);
+	vector <double> upperBound(N, 0.0), lowerBound(N, 0.0), drift(numClusters), halfGap(numClusters, 0.0);
+	kMeansIndex index;
+	for (iter = 0; iter < (*param).K_MEANS_ITERS; iter++)
+	{
+		indexCenters(centers, dim, &index);
+		
+		// half of the distance from each center to its closest other center, a point closer than that to its center cannot be closer to another center
+		if (iter > 0)
+		{
+#ifdef _OPENMP
+			#pragma omp parallel for num_threads(getNumThreads(param)) schedule(dynamic, 1)
+#endif
+			for (int c = 0; c < (int) numClusters; c++)
+			{
+				double minGap = INF, gap;
+				for (unsigned int other = 0; other < numClusters; other++)
+				{
+					if (other == (unsigned int) c)
+						continue;
+					gap = fabs((*centers)[c].sqrNorm + (*centers)[other].sqrNorm - 2.0 * dotBetweenCenters(&(*centers)[c], &(*centers)[other]));
+					if (gap < minGap)
+						minGap = gap;
+				}
+				halfGap[c] = 0.5 * sqrt(minGap);
+			}
+		}
+		
+		// assign each point to its closest center
+		numChanged = 0;
+#ifdef _OPENMP
+		#pragma omp parallel num_threads(getNumThreads(param)) reduction(+:numChanged, numEvaluations)
+#endif
+		{
+			vector <double> dots;
+#ifdef _OPENMP
+			#pragma omp for schedule(dynamic, 256)
+#endif
+			for (int t = 0; t < (int) N; t++)
+			{
+				double bound, dist, minDist = INF, secondDist = INF;
+				unsigned int closest = 0;
+				
+				if (iter > 0)
+				{
+					// first try to keep the current cluster using the bounds, and then using the exact distance to the current center
+					bound = (halfGap[idx[t]] > lowerBound[t]) ? halfGap[idx[t]] : lowerBound[t];
+					if (upperBound[t] <= bound)
+						continue;
+					upperBound[t] = sqrt(fabs(pointNorms[t] + (*centers)[idx[t]].sqrNorm - 2.0 * dotWithCenter(data, (unsigned int) t, &(*centers)[idx[t]])));
+					numEvaluations++;
+					if (upperBound[t] <= bound)
+						continue;
+				}
+				
+				dotsWithCenters(data, (unsigned int) t, centers, &index, &dots);
+				numEvaluations += numClusters;
+				for (unsigned int c = 0; c < numClusters; c++)
+				{
+					dist = fabs(pointNorms[t] + (*centers)[c].sqrNorm - 2.0 * dots[c]);
+					if (dist < minDist)
+					{
+						secondDist = minDist;
+						minDist = dist;
+						closest = c;
+					}
+					else if (dist < secondDist)
+						secondDist = dist;
+				}
+				
+				if (closest != idx[t])
+					numChanged++;
+				idx[t] = closest;
+				upperBound[t] = sqrt(minDist);
+				lowerBound[t] = sqrt(secondDist);
+			}
+		}
+		numIters++;
+		if (numChanged == 0)
+			break;
+		
+		// sort the points by their clusters, so that the centers are all updated in a single pass over the points
+		clusterStart.assign(numClusters + 1, 0);
+		for (i = 0; i < N; i++)
+			clusterStart[idx[i] + 1]++;
+		for (cluster = 0; cluster < numClusters; cluster++)
+			clusterStart[cluster + 1] += clusterStart[cluster];
+		for (i = 0; i < N; i++)
+			sortedPoints[clusterStart[idx[i]]++] = i;
+		for (cluster = numClusters; cluster > 0; cluster--)
+			clusterStart[cluster] = clusterStart[cluster - 1];
+		clusterStart[0] = 0;
+		
+#ifdef _OPENMP
+		#pragma omp parallel num_threads(getNumThreads(param))
+#endif
+		{
+			vector <double> sum(dim, 0.0);
+			vector <bool> isTouched(dim, false);
+			vector <unsigned int> touched;
+#ifdef _OPENMP
+			#pragma omp for schedule(dynamic, 1)
+#endif
+			for (int c = 0; c < (int) numClusters; c++)
+			{
+				kMeansCenter &center = (*centers)[c];
+				if (clusterStart[c + 1] == clusterStart[c])
+					continue;
+				
+				// sum the points of the cluster, remembering which elements of the sum were touched
+				for (unsigned int k = clusterStart[c]; k < clusterStart[c + 1]; k++)
+				{
+					unsigned int t = sortedPoints[k], tend = (t == N - 1) ? (unsigned int) data->aj.size() : data->ai[t + 1];
+					for (unsigned int l = data->ai[t]; l < tend; l++)
+					{
+						if (!isTouched[data->aj[l] - 1])
+						{
+							isTouched[data->aj[l] - 1] = true;
+							touched.push_back(data->aj[l] - 1);
+						}
+						sum[data->aj[l] - 1] += (double) data->an[l];
+					}
+				}
+				
+				// find how far the center moves, from the dot product of the old center and the mean of the cluster
+				double counter = (double) (clusterStart[c + 1] - clusterStart[c]), newNorm = 0.0, dot = 0.0;
+				for (unsigned int k = 0; k < (unsigned int) touched.size(); k++)
+					newNorm += (sum[touched[k]] / counter) * (sum[touched[k]] / counter);
+				if (center.isDense)
+				{
+					for (unsigned int k = 0; k < (unsigned int) touched.size(); k++)
+						dot += center.values[touched[k]] * sum[touched[k]] / counter;
+				}
+				else
+				{
+					for (unsigned int k = 0; k < (unsigned int) center.indices.size(); k++)
+						dot += center.values[k] * sum[center.indices[k]] / counter;
+				}
+				drift[c] = sqrt(fabs(center.sqrNorm + newNorm - 2.0 * dot));
+				
+				// keep the center dense only if the list of its non-zero elements would take more memory
+				center.isDense = (touched.size() * (sizeof(unsigned int) + sizeof(double)) > dim * sizeof(double));
+				center.indices.clear();
+				center.sqrNorm = newNorm;
+				if (center.isDense)
+					center.values.assign(dim, 0.0);
+				else
+				{
+					sort(touched.begin(), touched.end());
+					center.values.clear();
+				}
+				for (unsigned int k = 0; k < (unsigned int) touched.size(); k++)
+				{
+					unsigned int feature = touched[k];
+					if (center.isDense)
+						center.values[feature] = sum[feature] / counter;
+					else
+					{
+						center.indices.push_back(feature);
+						center.values.push_back(sum[feature] / counter);
+					}
+					sum[feature] = 0.0;
+					isTouched[feature] = false;
+				}
+				touched.clear();
+			}
+		}
+		
+		// do not remove the empty clusters, randomly select one point as the new center; done serially so that the random choices do not depend on the threads
+		for (cluster = 0; cluster < numClusters; cluster++)
+		{
+			if (clusterStart[cluster + 1] > clusterStart[cluster])
+				continue;
+			kMeansCenter oldCenter = (*centers)[cluster];
+			setCenterToPoint(data, (unsigned int) (rand() % N), &(*centers)[cluster]);
+			drift[cluster] = sqrt(fabs(oldCenter.sqrNorm + (*centers)[cluster].sqrNorm - 2.0 * dotBetweenCenters(&oldCenter, &(*centers)[cluster])));
+		}
+		
+		// loosen the bounds by the distances the centers moved
+		maxDrift = secondMaxDrift = 0.0;
+		for (cluster = 0; cluster < numClusters; cluster++)
+		{
+			if (drift[cluster] > maxDrift)
+			{
+				secondMaxDrift = maxDrift;
+				maxDrift = drift[cluster];
+				farthest = cluster;
+			}
+			else if (drift[cluster] > secondMaxDrift)
+				secondMaxDrift = drift[cluster];
+		}
+		for (i = 0; i < N; i++)
+		{
+			upperBound[i] += drift[idx[i]];
+			lowerBound[i] -= (idx[i] == farthest) ? secondMaxDrift : maxDrift;
+		}
+	}
+	
+	if ((*param).VERBOSE)
+	{
+		sprintf(text, "K-means completed after %d iteration(s), computed %.0f point-center distances (%.1f%% of the exhaustive search).\n", numIters, numEvaluations, 
+			100.0 * numEvaluations / ((double) numIters * (double) N * (double) numClusters));
+		svmPrintString(text);
+	}
 }
 
 /*! \fn void kMedoids(budgetedData *trainData, parameters *param, unsigned int *medoidIndex)
 	\brief Selects the landmark points using k-medoids algorithm.
 	\param [in] trainData Input training data.
-	\param [in] param The parameters of the algorithm.
+	\param [in] param The parameters of the algorithm, where \link parameters::BUDGET_SIZE \endlink medoids are found in \link parameters::K_MEANS_ITERS \endlink iterations.
 	\param [out] medoidIndex Indices of medoid centers.
 	
-	Selects the landmark points using k-medoids algorithm, may save memory as compared to k-means algorithm since if the training data is sparse the landmark points will be sparse as well.
-	However, the algorithm is O(N^2), where N is number of data points loaded in the first data chunk, and it may be slower than k-means.
+	Selects the landmark points using k-medoids algorithm, where the landmark points are data points themselves, and are as sparse as the training data.
 	
 	Implemented according to Park, Hae-Sang, and Chi-Hyuck Jun. "A simple and fast algorithm for K-medoids clustering." Expert Systems with Applications 36.2 (2009): 3336-3341.
+	The squared distances are computed as ||x||^2 + ||y||^2 - 2 * x^T * y from the cached squared norms of the points. In the assignment step the medoids are indexed as
+	sparse k-means centers, so that the distances of a point to all medoids are found in a single pass over its non-zero features. The points are then grouped into per-cluster
+	member lists, and the new medoid of each cluster is the member with the smallest sum of distances to the other members. As this takes time quadratic in the size of the
+	cluster, for clusters with more than \link parameters::MEDOID_SAMPLE_SIZE \endlink members the medoid is searched for among a random sample of that many members, including
+	the current medoid, and the sums of distances are computed over the sample, as in CLARA algorithm from Kaufman, Leonard, and Peter J. Rousseeuw. "Finding groups in data:
+	an introduction to cluster analysis." (1990). The pairwise distances within a sample are computed only once for each pair, by scattering one member into a dense vector
+	and taking the dot products of the remaining members with it. The assignment step is done in parallel over the points and the medoid update in parallel over the clusters,
+	and the found medoids do not depend on the number of threads.
 */
 void kMedoids(budgetedData *trainData, parameters *param, unsigned int *medoidIndex)
 {
-	unsigned int iter, cluster, N = trainData->N, i, j;
-	double currentdist, totalDist, tmpTotalDist, minDist;
+	unsigned int iter, cluster, N = trainData->N, dim = (*param).DIMENSION, numClusters = (*param).BUDGET_SIZE, i, j, iend, sampleSize;
+	
+	// cache the squared norms of the points
+	vector <double> pointNorms(N, 0.0);
+	for (i = 0; i < N; i++)
+	{
+		iend = (i == N - 1) ? (unsigned int) trainData->aj.size() : trainData->ai[i + 1];
+		for (j = trainData->ai[i]; j < iend; j++)
+			pointNorms[i] += (double) trainData->an[j] * (double) trainData->an[j];
+	}
 	
 	// initialize the medoidIndex (random initialization)
 	vector <unsigned int> randomPerm(N, 0);
@@ -175,82 +985,169 @@ void kMedoids(budgetedData *trainData, parameters *param, unsigned int *medoidIn
 		randomPerm[i] = i;
 	random_shuffle(randomPerm.begin(), randomPerm.end());
 	
-	for (i = 0; i < param->BUDGET_SIZE; i++)
+	for (i = 0; i < numClusters; i++)
 	{
 		medoidIndex[i] = randomPerm[i];
 	}
 	
-	vector <unsigned int> clusterIndex(N);
-	for (iter = 0; iter < param->K_MEANS_ITERS; iter++)
+	vector <unsigned int> clusterIndex(N), clusterStart(numClusters + 1), members(N), clusterSample(numClusters);
+	vector <kMeansCenter> medoids(numClusters);
+	kMeansIndex index;
+	for (iter = 0; iter < (*param).K_MEANS_ITERS; iter++)
 	{
-		// assign clusters first
+		// assign clusters first, computing the distances of each point to all medoids together
+		for (cluster = 0; cluster < numClusters; cluster++)
+			setCenterToPoint(trainData, medoidIndex[cluster], &medoids[cluster]);
+		indexCenters(&medoids, dim, &index);
+#ifdef _OPENMP
+		#pragma omp parallel num_threads(getNumThreads(param))
+#endif
+		{
+			vector <double> dots;
+#ifdef _OPENMP
+			#pragma omp for schedule(dynamic, 256)
+#endif
+			for (int t = 0; t < (int) N; t++)
+			{
+				double currentDist, minDist = INF;
+				
+				dotsWithCenters(trainData, (unsigned int) t, &medoids, &index, &dots);
+				for (unsigned int c = 0; c < numClusters; c++)
+				{
+					currentDist = fabs(pointNorms[t] + medoids[c].sqrNorm - 2.0 * dots[c]);
+					if (currentDist < minDist)
+					{
+						minDist = currentDist;
+						clusterIndex[t] = c;
+					}
+				}
+			}
+		}
+		
+		// group the points by their clusters, keeping the points of each cluster in increasing order
+		clusterStart.assign(numClusters + 1, 0);
 		for (i = 0; i < N; i++)
+			clusterStart[clusterIndex[i] + 1]++;
+		for (cluster = 0; cluster < numClusters; cluster++)
+			clusterStart[cluster + 1] += clusterStart[cluster];
+		for (i = 0; i < N; i++)
+			members[clusterStart[clusterIndex[i]]++] = i;
+		for (cluster = numClusters; cluster > 0; cluster--)
+			clusterStart[cluster] = clusterStart[cluster - 1];
+		clusterStart[0] = 0;
+		
+		// sample the members of the large clusters, moving the sample to the front of the member list; done serially so that the random choices do not depend on the threads
+		for (cluster = 0; cluster < numClusters; cluster++)
 		{
-			//find the nearest medoid
-			minDist = INF;
-			for (cluster = 0; cluster < param->BUDGET_SIZE; cluster++)
+			sampleSize = clusterStart[cluster + 1] - clusterStart[cluster];
+			if (((*param).MEDOID_SAMPLE_SIZE == 0) || (sampleSize <= (*param).MEDOID_SAMPLE_SIZE))
+			{
+				clusterSample[cluster] = sampleSize;
+				continue;
+			}
+			clusterSample[cluster] = sampleSize = (*param).MEDOID_SAMPLE_SIZE;
+			
+			// the current medoid is always a candidate, so that the medoid found in the previous iterations can be kept
+			unsigned int *first = &members[clusterStart[cluster]], numMembers = clusterStart[cluster + 1] - clusterStart[cluster];
+			for (i = 0; i < numMembers; i++)
 			{
-				currentdist = trainData->distanceBetweenTwoPoints(i, medoidIndex[cluster]);
-				if (currentdist < minDist)
+				if (first[i] == medoidIndex[cluster])
 				{
-					minDist = currentdist;
-					clusterIndex[i] = cluster;
+					mySwap(first[0], first[i]);
+					break;
 				}
 			}
+			for (i = (first[0] == medoidIndex[cluster]) ? 1 : 0; i < sampleSize; i++)
+				mySwap(first[i], first[i + (unsigned int) rand() % (numMembers - i)]);
 		}
 		
 		// update the medoids
-		for (cluster = 0; cluster < param->BUDGET_SIZE; cluster++)
+#ifdef _OPENMP
+		#pragma omp parallel num_threads(getNumThreads(param))
+#endif
 		{
-			tmpTotalDist = INF;
-			for (i = 0; i < N; i++)
+			vector <double> scattered(dim, 0.0), totalDist;
+#ifdef _OPENMP
+			#pragma omp for schedule(dynamic, 1)
+#endif
+			for (int c = 0; c < (int) numClusters; c++)
 			{
-				if (clusterIndex[i] == cluster)
+				unsigned int *sample = &members[clusterStart[c]], size = clusterSample[c];
+				if (size == 0)
+					continue;
+				
+				totalDist.assign(size, 0.0);
+				for (unsigned int k = 0; k < size; k++)
 				{
-					totalDist = 0.0;
-					for (j = 0; j < N; j++)
+					unsigned int p = sample[k], pend = (p == N - 1) ? (unsigned int) trainData->aj.size() : trainData->ai[p + 1];
+					for (unsigned int l = trainData->ai[p]; l < pend; l++)
+						scattered[trainData->aj[l] - 1] = (double) trainData->an[l];
+					
+					// the distances to the earlier members of the sample were already added when they were scattered
+					for (unsigned int m = k + 1; m < size; m++)
 					{
-						if (clusterIndex[j] == cluster)
-							totalDist += trainData->distanceBetweenTwoPoints(i, j);
+						unsigned int q = sample[m], qend = (q == N - 1) ? (unsigned int) trainData->aj.size() : trainData->ai[q + 1];
+						double dot = 0.0, currentDist;
+						for (unsigned int l = trainData->ai[q]; l < qend; l++)
+							dot += (double) trainData->an[l] * scattered[trainData->aj[l] - 1];
+						currentDist = fabs(pointNorms[p] + pointNorms[q] - 2.0 * dot);
+						totalDist[k] += currentDist;
+						totalDist[m] += currentDist;
 					}
-					if (totalDist < tmpTotalDist)
+					
+					for (unsigned int l = trainData->ai[p]; l < pend; l++)
+						scattered[trainData->aj[l] - 1] = 0.0;
+				}
+				
+				double tmpTotalDist = INF;
+				for (unsigned int k = 0; k < size; k++)
+				{
+					if (totalDist[k] < tmpTotalDist)
 					{
-						tmpTotalDist = totalDist;
-						medoidIndex[cluster] = i; // I used maxIter as stop criteria (set to a small number). No need to store previous medoid index
+						tmpTotalDist = totalDist[k];
+						medoidIndex[c] = sample[k]; // I used maxIter as stop criteria (set to a small number). No need to store previous medoid index
 					}
 				}
 			}
 		}
-	}	
+	}
 }
-/*! \fn void liblinear_Solve_l2r_l1(const MatrixXd &X, unsigned char *y, VectorXd &w, parameters *param, vector <int> *yLabels)
+
+/*! \fn template <typename MatrixType> void liblinear_Solve_l2r_l1(const MatrixType &X, unsigned char *y, VectorXd &w, parameters *param, unsigned char positiveLabel, unsigned int seed)
 	\brief Solves linear C-SVM on the transformed data points, taken from LibLINEAR implementation.
 	\param [in] X Transformed data which is to be solved by linear SVM, each row is one data point.
 	\param [in] y Labels of the data points.
 	\param [in,out] w Current linear SVM-model parameters modified by the function, zero-weight at the start of training.
-
 	\param [in] param The parameters of the algorithm.
+	\param [in] positiveLabel Label of the data points on the positive side of the hyperplane, the remaining data points are on its negative side.
+	\param [in] seed Seed of the random number generator used to permute the data points.
 	
 	The function computes a linear separating hyperplane between two classes. It is used after the data points are projected from their original input feature space to a new feature space, defined by the projection matrix \link modelLLSVMmatrixW\endlink. The function is taken nearly verbatim from the LibLINEAR package.
+	
+	The dot products are computed in the precision of the mapped data, so that they are vectorized over the contiguous rows of the data, while the hyperplane itself is updated
+	in double precision, as single precision loses the small updates once the hyperplane grows large. The optimization stops once the projected gradient falls within the 
+	tolerance, or once the updated data points add up to 30 passes over the data; the passes over the small set of data points left after shrinking are cheap, and do not use 
+	up the budget as the full passes do.
 */
-void liblinear_Solve_l2r_l1(const MatrixXd &X, unsigned char *y, VectorXd &w, parameters *param, vector <int> *yLabels)
+template <typename MatrixType>
+void liblinear_Solve_l2r_l1(const MatrixType &X, unsigned char *y, VectorXd &w, parameters *param, unsigned char positiveLabel, unsigned int seed)
 {
 	// solve l2 regularized l1 loss SVM by dual coordinate descent method
 	// min_\alpha   0.5(\alpha^T (Q) \alpha) - e^T \alpha
 	//         s.t     0 <= alpha_i <= c
 	//     where Qij = yi yj Xi^T Xj 
 	
-	// to train linear kernel we need -1 and +1 labels, but a user can give us any labels, e.g., 0/1 labels; therefore
-	//	here we set the default labels, such that the first user-provided label is renamed as -1, and the second +1
-	char defaultLabels[2] = {-1, 1};
+	typedef typename MatrixType::Scalar Scalar;
 	
 	int l = (int) X.rows();      // number of examples
-	int i, s, iter = 0;
+	int i, s;
 	MatrixXd Q = MatrixXd::Zero(l,1);
-	int maxIter = 30;
+	unsigned long long numUpdates = 0, maxUpdates = 30ULL * (unsigned long long) l;
+	unsigned long long randomState = ((unsigned long long) seed << 1) | 1ULL;
 	int *index = Malloc(int, l);
 	int activeSize = l;      // shrinkage
 	double *alpha = Malloc(double, l);
+	Matrix <Scalar, Dynamic, 1> ws;     // copy of the hyperplane in the precision of the data, for the dot products
 	
 	// PG: projected gradient, for shrinking and stopping
 	double PG;
@@ -260,28 +1157,33 @@ void liblinear_Solve_l2r_l1(const MatrixXd &X, unsigned char *y, VectorXd &w, pa
 
 	for(i = 0; i < l; i++)
 	{
-		Q(i,0) = X.row(i)*(X.row(i).transpose());    // Q(i,i) = (x_i)^T*(x_i) for l1-loss svm
+		Q(i,0) = (double) X.row(i).squaredNorm();    // Q(i,i) = (x_i)^T*(x_i) for l1-loss svm
 		index[i] = i;
 		alpha[i] = 0;
 	}
 
-	while (iter < maxIter)
+	while (numUpdates < maxUpdates)
 	{
 		PGmaxNew = -INF;
 		PGminNew = INF;
+		numUpdates += (unsigned long long) activeSize;
+		
+		// the copy is updated together with the hyperplane, and re-synchronized once per pass so that its rounding errors do not accumulate
+		ws = w.template cast <Scalar>();
 
 		for (i = 0; i < activeSize; i++)          	// randomly permute the examples in the active set
 		{
-			int j = i + rand() % (activeSize - i);
+			int j = i + (int) (fastRandom(&randomState) % (unsigned int) (activeSize - i));
 			mySwap(index[i], index[j]);
 		}
 
 		for (s = 0; s < activeSize; s++)
 		{
 			i = index[s];
-			//double yi = (double) (*yLabels)[y[i]];
-			double yi = (double) defaultLabels[y[i]];
-			double tmp = w.dot(X.row(i));
+			// to train linear kernel we need -1 and +1 labels, but a user can give us any labels, e.g., 0/1 labels; therefore
+			//	here the data points with the positive label are renamed as +1, and all the others as -1
+			double yi = (y[i] == positiveLabel) ? 1.0 : -1.0;
+			double tmp = (double) ws.dot(X.row(i).transpose());
 			double G = tmp * yi - 1.0;				// gradient
 			
 			// projected gradient
@@ -321,10 +1223,10 @@ void liblinear_Solve_l2r_l1(const MatrixXd &X, unsigned char *y, VectorXd &w, pa
 			{
 				double alphaOld = alpha[i];
 				alpha[i] = myMin(myMax(alpha[i] - G/(double)Q(i, 0), 0.0), 1.0 / (*param).LAMBDA_PARAM);
-				w = w + (alpha[i] - alphaOld)* yi * (X.row(i).transpose());					
+				w += ((alpha[i] - alphaOld) * yi) * X.row(i).transpose().template cast <double>();
+				ws += (Scalar) ((alpha[i] - alphaOld) * yi) * X.row(i).transpose();
 			}
 		}
-		iter++;
 		double eps = 0.01;      // stopping criterion
 		if (PGmaxNew - PGminNew <= eps)
 		{
@@ -350,6 +1252,217 @@ void liblinear_Solve_l2r_l1(const MatrixXd &X, unsigned char *y, VectorXd &w, pa
 	Q.resize(0, 0);
 }
 
+/*! \fn template <typename MatrixType> void liblinear_Solve_oneVsRest(const MatrixType &X, unsigned char *y, MatrixXd &weights, parameters *param)
+	\brief Solves the linear C-SVMs of LLSVM model on the transformed data points.
+	\param [in] X Transformed data which is to be solved by linear SVM, each row is one data point.
+	\param [in] y Labels of the data points.
+	\param [in,out] weights Current linear SVM-model parameters modified by the function, one column per linear classifier.
+	\param [in] param The parameters of the algorithm.
+	
+	For binary problems a single hyperplane separates the second class from the first. For multi-class problems each class is separated from all the others by its own hyperplane,
+	where the hyperplanes are found in parallel on the same transformed data, so that the data points are mapped only once regardless of the number of classes.
+*/
+template <typename MatrixType>
+void liblinear_Solve_oneVsRest(const MatrixType &X, unsigned char *y, MatrixXd &weights, parameters *param)
+{
+	int numClassifiers = (int) weights.cols();
+	
+	// the seeds are drawn before the solvers start, so that the result does not depend on the order in which the threads run
+	vector <unsigned int> seeds(numClassifiers);
+	for (int k = 0; k < numClassifiers; k++)
+		seeds[k] = (unsigned int) rand();
+	
+#ifdef _OPENMP
+	#pragma omp parallel for num_threads(getNumThreads(param)) schedule(dynamic, 1) if (numClassifiers > 1)
+#endif
+	for (int k = 0; k < numClassifiers; k++)
+	{
+		VectorXd w = weights.col(k);
+		liblinear_Solve_l2r_l1(X, y, w, param, (unsigned char) ((numClassifiers == 1) ? 1 : k), seeds[k]);
+		weights.col(k) = w;
+	}
+}
+
+/*! \fn void liblinear_Solve_l2r_l1_outOfCore(FILE *mappedFile, vector <unsigned char> *y, MatrixXd &weights, parameters *param)
+	\brief Solves the linear C-SVMs of LLSVM model on the mapped data of all data chunks, kept in a file, by dual coordinate descent.
+	\param [in] mappedFile Binary file holding the mapped data points one after another, each as weights.rows() single-precision numbers.
+	\param [in] y Labels of the data points.
+	\param [in,out] weights Linear SVM-model parameters, zero-weight at the start of training, one column per linear classifier.
+	\param [in] param The parameters of the algorithm.
+	
+	The same dual coordinate descent method as in liblinear_Solve_l2r_l1(), but the data points are read from the file in blocks of \link parameters::CHUNK_SIZE \endlink
+	points, in random order within each block. Each block is put together from short runs of consecutive data points taken from random places in the file, different in each
+	pass, so that a block is a sample of the entire training data even if the training file is sorted, e.g., by labels. The dual variables and the shrinking state of all data points are kept in memory, so that each pass over the file continues
+	from where the previous pass stopped, and the stopping criterion is evaluated over all data points, which makes the solution independent of the size of the data chunks.
+	In multi-class problems the one-vs-rest classifiers are updated in parallel on each block that is read, and the passes stop once all of them have converged.
+	\sa parameters::OUT_OF_CORE_TRAINING
+*/
+void liblinear_Solve_l2r_l1_outOfCore(FILE *mappedFile, vector <unsigned char> *y, MatrixXd &weights, parameters *param)
+{
+	unsigned int l = (unsigned int) (*y).size(), dim = (unsigned int) weights.rows(), blockSize = myMin((*param).CHUNK_SIZE, l), rows, s, r;
+	unsigned int runLength = myMax(blockSize / 256, (unsigned int) 1), numRuns = (l + runLength - 1) / runLength, numBlocks = (l + blockSize - 1) / blockSize;
+	unsigned int runsPerBlock = (numRuns + numBlocks - 1) / numBlocks;
+	int numClassifiers = (int) weights.cols(), numConverged = 0, iter = 0;
+	int maxIter = 30;
+	double eps = 0.01;      // stopping criterion
+	double C = 1.0 / (*param).LAMBDA_PARAM;
+	vector <double> QD(l, 0.0);
+	vector < vector <double> > alpha(numClassifiers, vector <double>(l, 0.0));
+	vector < vector <bool> > active(numClassifiers, vector <bool>(l, true));
+	vector <unsigned int> numActive(numClassifiers, l), index(runsPerBlock * runLength), blockPoints(runsPerBlock * runLength), runs(numRuns);
+	vector <bool> converged(numClassifiers, false);
+	MatrixXfRowMajor block(runsPerBlock * runLength, dim);
+	MatrixXf weightsFloat;     // copy of the hyperplanes in the precision of the mapped data, for the dot products
+	unsigned long long randomState = ((unsigned long long) rand() << 1) | 1ULL;
+	char text[256];
+	
+	for (r = 0; r < numRuns; r++)
+		runs[r] = r;
+	
+	// PG: projected gradient, for shrinking and stopping, kept for each linear classifier
+	vector <double> PGmaxOld(numClassifiers, INF);
+	vector <double> PGminOld(numClassifiers, -INF);
+	vector <double> PGmaxNew(numClassifiers), PGminNew(numClassifiers);
+	
+	while ((iter < maxIter) && (numConverged < numClassifiers))
+	{
+		PGmaxNew.assign(numClassifiers, -INF);
+		PGminNew.assign(numClassifiers, INF);
+		
+		// the copy is updated together with the hyperplanes, and re-synchronized once per pass so that its rounding errors do not accumulate
+		weightsFloat = weights.cast <float>();
+		
+		// randomly permute the runs of consecutive data points, each block is then read from several runs
+		for (r = 0; r < numRuns; r++)
+			mySwap(runs[r], runs[r + fastRandom(&randomState) % (numRuns - r)]);
+		
+		for (unsigned int firstRun = 0; firstRun < numRuns; firstRun += runsPerBlock)
+		{
+			rows = 0;
+			for (r = firstRun; r < myMin(firstRun + runsPerBlock, numRuns); r++)
+			{
+				unsigned int runStart = runs[r] * runLength, runRows = myMin(runLength, l - runStart);
+				if ((fseek64(mappedFile, (unsigned long long) runStart * dim * sizeof(float)) != 0) ||
+					(fread(block.row(rows).data(), sizeof(float), (size_t) runRows * dim, mappedFile) != (size_t) runRows * dim))
+					svmPrintErrorString("Error reading the mapped training data from the temporary file!\n");
+				
+				for (s = 0; s < runRows; s++)
+					blockPoints[rows + s] = runStart + s;
+				rows += runRows;
+			}
+			
+			// Q(i,i) = (x_i)^T*(x_i) for l1-loss svm, computed in the first pass
+			if (iter == 0)
+			{
+				for (s = 0; s < rows; s++)
+					QD[blockPoints[s]] = block.row(s).template cast <double>().squaredNorm();
+			}
+			
+			for (s = 0; s < rows; s++)          	// randomly permute the examples in the block
+			{
+				index[s] = s;
+				mySwap(index[s], index[fastRandom(&randomState) % (s + 1)]);
+			}
+			
+#ifdef _OPENMP
+			#pragma omp parallel for num_threads(getNumThreads(param)) schedule(dynamic, 1) if (numClassifiers > 1)
+#endif
+			for (int k = 0; k < numClassifiers; k++)
+			{
+				if (converged[k])
+					continue;
+				
+				// for binary problems the second class is the positive one, otherwise the k-th class is separated from all the others
+				unsigned char positiveLabel = (unsigned char) ((numClassifiers == 1) ? 1 : k);
+				for (unsigned int t = 0; t < rows; t++)
+				{
+					unsigned int i = blockPoints[index[t]];
+					if (!active[k][i])
+						continue;
+					
+					double yi = ((*y)[i] == positiveLabel) ? 1.0 : -1.0;
+					double G = (double) weightsFloat.col(k).dot(block.row(index[t]).transpose()) * yi - 1.0;	// gradient
+					
+					// projected gradient, shrink the data points whose dual variables are likely to stay at the bounds
+					double PG = 0.0;
+					if (alpha[k][i] == 0.0)
+					{
+						if (G > PGmaxOld[k])
+						{
+							active[k][i] = false;
+							numActive[k]--;
+							continue;
+						}
+						else if (G < 0.0)
+							PG = G;
+					}
+					else if (alpha[k][i] == C)
+					{
+						if (G < PGminOld[k])
+						{
+							active[k][i] = false;
+							numActive[k]--;
+							continue;
+						}
+						else if (G > 0.0)
+							PG = G;
+					}
+					else
+						PG = G;
+					
+					PGmaxNew[k] = myMax(PGmaxNew[k], PG);
+					PGminNew[k] = myMin(PGminNew[k], PG);
+					
+					if ((fabs(PG) > 1.0e-12) && (QD[i] > 0.0))     // |PG| != 0
+					{
+						double alphaOld = alpha[k][i];
+						alpha[k][i] = myMin(myMax(alpha[k][i] - G / QD[i], 0.0), C);
+						weights.col(k) += ((alpha[k][i] - alphaOld) * yi) * block.row(index[t]).transpose().cast <double>();
+						weightsFloat.col(k) += (float) ((alpha[k][i] - alphaOld) * yi) * block.row(index[t]).transpose();
+					}
+				}
+			}
+		}
+		iter++;
+		
+		for (int k = 0; k < numClassifiers; k++)
+		{
+			if (converged[k])
+				continue;
+			
+			if (PGmaxNew[k] - PGminNew[k] <= eps)
+			{
+				if (numActive[k] == l)
+				{
+					converged[k] = true;
+					numConverged++;
+				}
+				else
+				{
+					// converged on the active data points, check again over all data points
+					active[k].assign(l, true);
+					numActive[k] = l;
+					PGmaxOld[k] = INF;
+					PGminOld[k] = -INF;
+				}
+				continue;
+			}
+			PGmaxOld[k] = PGmaxNew[k];
+			PGminOld[k] = PGminNew[k];
+			if (PGmaxOld[k] <= 0)
+				PGmaxOld[k] = INF;
+			if (PGminOld[k] >= 0)
+				PGminOld[k] = -INF;
+		}
+	}
+	
+	if ((*param).VERBOSE)
+	{
+		sprintf(text, "Linear SVM trained in %d pass(es) over the mapped data.\n", iter);
+		svmPrintString(text);
+	}
+}
+
 /* \fn float predictLLSVM(budgetedData *testData, parameters *param, budgetedModelLLSVM *model, vector <int> *labels, vector <float> *scores)
 	\brief Given an LLSVM model, predict the labels of testing data.
 	\param [in] testData Input test data.
@@ -361,14 +1474,11 @@ void liblinear_Solve_l2r_l1(const MatrixXd &X, unsigned char *y, VectorXd &w, pa
 */
 float predictLLSVM(budgetedData *testData, parameters *param, budgetedModelLLSVM *model, vector <int> *labels, vector <float> *scores)
 {
-	// to train linear kernel we need -1 and +1 labels, but a user can give us any labels, e.g., 0/1 labels; therefor
-	//	here we set the default labels, such that the first user-provided label is renamed as -1, and the second +1
-	int defaultLabels[2] = {-1, 1};
-	
     unsigned long N, err = 0, total = 0, timeCalc = 0, start;
+	unsigned int numClassifiers = (unsigned int) (*model).modelLLSVMcoefficients.cols();
 	bool stillChunksLeft = true;
 	char text[256];
-	VectorXd v((*param).BUDGET_SIZE), temp((*param).BUDGET_SIZE);
+	VectorXd v((*param).BUDGET_SIZE);
 	budgetedVectorLLSVM *currentData = NULL;
 	long double tempSqrNorm;
 	
@@ -385,7 +1495,7 @@ float predictLLSVM(budgetedData *testData, parameters *param, budgetedModelLLSVM
 		start = clock();
 		
 		// calculate E, kernel between testing points and landmark points
-    	VectorXd predictions(N);
+    	MatrixXd predictions(N, numClassifiers);
 		for (unsigned int i = 0; i < N; i++)
 		{
 			if ((*param).VERY_SPARSE_DATA)
@@ -414,21 +1524,32 @@ float predictLLSVM(budgetedData *testData, parameters *param, budgetedModelLLSVM
 				currentData = NULL;
 			}
 			
-			temp = v.transpose() * (*model).modelLLSVMmatrixW;
-			predictions(i) = temp.dot((*model).modelLLSVMweightVector);
+			// the transformation matrix is already folded into the coefficients of the landmark points, the scores of all classes are found from the same kernel values
+			predictions.row(i).noalias() = v.transpose() * (*model).modelLLSVMcoefficients;
 		}
 		
 		for (unsigned int i = 0; i < N; i++)
 		{
-			if ((predictions(i) > 0.0) != (defaultLabels[testData->al[i]] > 0))
+			// binary model predicts the second class for positive scores, and multi-class model predicts the class with the highest one-vs-rest score
+			int winner;
+			double winnerScore;
+			if (numClassifiers == 1)
+			{
+				winner = (predictions(i, 0) > 0.0);
+				winnerScore = fabs(predictions(i, 0));
+			}
+			else
+				winnerScore = predictions.row(i).maxCoeff(&winner);
+			
+			if (winner != (int) testData->al[i])
     			err++;
 			
 			// save predicted label, will be sent to output ...
 			if (labels)
-				(*labels).push_back((int)(testData->yLabels)[(predictions(i) > 0)]);
+				(*labels).push_back((int)(testData->yLabels)[winner]);
 			// ... and the scores
 			if (scores)
-				(*scores).push_back((float) abs(predictions(i)));
+				(*scores).push_back((float) winnerScore);
 		}
 		
 		timeCalc += clock() - start;
@@ -462,7 +1583,7 @@ void selectLandmarkPoints(budgetedData *trainData, parameters *param, budgetedMo
 	unsigned int N = trainData->N, i;
 	budgetedVectorLLSVM *currentRow = NULL;
 	vector <unsigned int> randomPerm;
-	MatrixXd X, kMeansCenters;
+	vector <kMeansCenter> kMeansCenters;
 	VectorXd tempVector;
 	
 	switch ((*param).MAINTENANCE_SAMPLING_STRATEGY)
@@ -493,32 +1614,24 @@ void selectLandmarkPoints(budgetedData *trainData, parameters *param, budgetedMo
 			if ((*param).VERBOSE)
 				svmPrintString("Running k-means to choose landmark points ...\n");
 			
-			// perform k-means
-			// first put the data into matrix (online k-means maybe?)
-			X = MatrixXd::Zero(N, (*param).DIMENSION);
+			// perform k-means directly on the sparse data
+			kMeans(trainData, param, &kMeansCenters);
 			
-			for (i = 0; i < N; i++)
-			{
-				unsigned int istart = trainData->ai[i];    
-				unsigned int iend = (i == trainData->N - 1) ? (unsigned int) trainData->aj.size() : trainData->ai[i + 1];
-				for (unsigned int j = istart; j < iend; j++)
-					X(i, trainData->aj[j] - 1) = trainData->an[j];
-			}
-			
-			// perform k-means
-			kMeansCenters = MatrixXd::Zero((*param).BUDGET_SIZE, (*param).DIMENSION);
-			kMeans(X, (*param).BUDGET_SIZE, (*param).K_MEANS_ITERS, kMeansCenters);
-			X.resize(0, 0);
-			
-			// insert landmark points as a matrix of data of size (points x dims)
+			// insert landmark points, keeping the sparse centers sparse
 			for (i = 0; i < (*param).BUDGET_SIZE; i++)
 			{
 				currentRow = new budgetedVectorLLSVM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
-				tempVector = kMeansCenters.row(i);
-				currentRow->createVectorUsingDataPointMatrix(tempVector);
+				if (kMeansCenters[i].isDense)
+				{
+					tempVector = Map<VectorXd>(&kMeansCenters[i].values[0], (*param).DIMENSION);
+					currentRow->createVectorUsingDataPointMatrix(tempVector);
+				}
+				else
+					currentRow->createVectorUsingSparsePoint(kMeansCenters[i].indices, kMeansCenters[i].values);
 				(*(model->modelLLSVMlandmarks)).push_back(currentRow);
 				currentRow = NULL;
-			}			
+			}
+			kMeansCenters.clear();
 			break;
 			
 		case LANDMARK_SAMPLE_KMEDOIDS:
@@ -556,17 +1669,24 @@ void selectLandmarkPoints(budgetedData *trainData, parameters *param, budgetedMo
 void trainLLSVM(budgetedData *trainData, parameters *param, budgetedModelLLSVM *model)
 {
 	unsigned long timeCalc = 0, start;
-	unsigned int i, j, total = 0, N, temp;
+	unsigned int total = 0, N, temp;
 	bool stillChunksLeft = true, firstChunk = true;
-	long double tempSqrNorm;
 	char text[256];
-	budgetedVectorLLSVM *currentData = NULL;
+	budgetedData *landmarkData = NULL, landmarkReservoir;
+	landmarkMatrix landmarks;
+	MatrixXdRowMajor mappedData;
+	MatrixXfRowMajor mappedDataFloat;
+	FILE *mappedFile = NULL;
+	vector <unsigned char> mappedLabels;
+	
+	// products of large matrices are parallelized by Eigen, using the same number of threads as the rest of training
+	setNbThreads((int) getNumThreads(param));
 	
 	// W matrix for Nystrom method, here employ Eigen library since we need complex matrix operations
 	(*model).modelLLSVMmatrixW = MatrixXd::Zero((*param).BUDGET_SIZE, (*param).BUDGET_SIZE);
 	
-	// initialize weight (i.e., hyperplane) in the projected space to zero-vector
-	(*model).modelLLSVMweightVector = VectorXd::Zero((*param).BUDGET_SIZE);
+	// initialize weight (i.e., hyperplane) in the projected space to zero-vector, more classifiers are added if more than two classes are found
+	(*model).modelLLSVMweights = MatrixXd::Zero((*param).BUDGET_SIZE, 1);
 	
 	// commence with LLSVM training procedure
 	stillChunksLeft = true;
@@ -591,9 +1711,10 @@ void trainLLSVM(budgetedData *trainData, parameters *param, budgetedModelLLSVM *
 			(*param).DIMENSION = temp;
 		}
 		
-		if (trainData->yLabels.size() != 2)
+		// a chunk may hold a single class if the training file is sorted by labels, but the entire training file has to hold at least two classes
+		if ((trainData->yLabels.size() < 2) && !stillChunksLeft)
 		{
-			sprintf(text, "LLSVM is a binary classifier, but %d class(es) detected!\n", (int) trainData->yLabels.size());
+			sprintf(text, "LLSVM needs at least two classes, but %d class detected!\n", (int) trainData->yLabels.size());
 			svmPrintErrorString(text);
 		}
 		
@@ -604,82 +1725,119 @@ void trainLLSVM(budgetedData *trainData, parameters *param, budgetedModelLLSVM *
 		// if we just started training initialize the landmark points
 		if (firstChunk)
 		{
-			if (N < (*param).BUDGET_SIZE)
+			firstChunk = false;
+			
+			// if the training file does not fit into the first chunk, select the landmark points from a sample of the entire file instead of from the first chunk,
+			//	the sample is read separately and the loaded chunk is then used for training as usual
+			landmarkData = trainData;
+			if (((*param).LANDMARK_RESERVOIR_SIZE > 0) && stillChunksLeft)
+			{
+				if ((*param).VERBOSE)
+					svmPrintString("Sampling the training data to choose landmark points from ...\n");
+				
+				temp = trainData->sampleReservoir(myMax((*param).LANDMARK_RESERVOIR_SIZE, (*param).BUDGET_SIZE), &landmarkReservoir);
+				if ((*param).VERBOSE)
+				{
+					sprintf(text, "Sampled %d out of %d data points.\n", landmarkReservoir.N, temp);
+					svmPrintString(text);
+				}
+				landmarkData = &landmarkReservoir;
+				
+				// the sample might hold features not seen in the first chunk
+				temp = landmarkReservoir.getDataDimensionality() + (int)(param->BIAS_TERM != 0.0);
+				if ((*param).DIMENSION < temp)
+				{
+					(*model).extendDimensionalityOfModel(temp, param);
+					(*param).DIMENSION = temp;
+				}
+			}
+			
+			if (landmarkData->N < (*param).BUDGET_SIZE)
 			{
 				trainData->flushData();
-				svmPrintErrorString("Number of landmark points larger than size of the loaded chunk!\n");
+				if (landmarkData == trainData)
+					svmPrintErrorString("Number of landmark points larger than size of the loaded chunk!\n");
+				else
+					svmPrintErrorString("Number of landmark points larger than size of the training data!\n");
 			}
-			firstChunk = false;
 			
 			// select landmark points
-			selectLandmarkPoints(trainData, param, model);
+			selectLandmarkPoints(landmarkData, param, model);
+			landmarkReservoir.flushData();
 			
 			if ((*param).VERBOSE)
 				svmPrintString("Computing the mapping function ...\n");
 				
 			// compute the W matrix, done just once per training
-			for (i = 0; i < (*param).BUDGET_SIZE; i++)
+			prepareLandmarks(model->modelLLSVMlandmarks, param, &landmarks);
+			landmarkKernelMatrix(&landmarks, param, (*model).modelLLSVMmatrixW);
+			
+			// finally, compute K_zz = W^(-0.5), initialization is complete; if only the leading eigenpairs are used the data is mapped to a lower-dimensional space
+			if (((*param).NYSTROM_RANK > 0) && ((*param).NYSTROM_RANK < (*param).BUDGET_SIZE))
 			{
-				for (j = 0; j < (*param).BUDGET_SIZE; j++)
+				randomizedInvSquareRoot((*model).modelLLSVMmatrixW, (*param).NYSTROM_RANK, (*param).NYSTROM_OVERSAMPLING);
+				(*model).modelLLSVMweights = MatrixXd::Zero((*model).modelLLSVMmatrixW.cols(), 1);
+				if ((*param).VERBOSE)
 				{
-					if (i <= j)
-					{
-						(*model).modelLLSVMmatrixW(i, j) = (double) (*(model->modelLLSVMlandmarks))[i]->computeKernel((*(model->modelLLSVMlandmarks))[j], param);
-					}
-					else
-					{
-						(*model).modelLLSVMmatrixW(i, j) = (*model).modelLLSVMmatrixW(j, i);
-					}
+					sprintf(text, "Mapping to %d dimensions found by the randomized eigensolver.\n", (int) (*model).modelLLSVMmatrixW.cols());
+					svmPrintString(text);
 				}
 			}
-			
-			// finally, compute K_zz = W^(-0.5), initialization is complete
-			invSquareRoot((*model).modelLLSVMmatrixW);
+			else
+				invSquareRoot((*model).modelLLSVMmatrixW);
+		}
+		else
+		{
+			// the sparsity and the dimensionality of the data might have changed with the new chunk
+			prepareLandmarks(model->modelLLSVMlandmarks, param, &landmarks);
 		}
 		
-		// done with initialization phase, next we compute the mapping in the new space and solve linear SVM
+		// done with initialization phase, next we compute the mapping in the new space and solve linear SVM; one-vs-rest classifiers are trained
+		//	for multi-class data, and the loaded chunk might hold classes that were not seen before
+		(*model).extendNumberOfClasses((unsigned int) trainData->yLabels.size());
 		
 		if ((*param).VERBOSE)
 			svmPrintString("Computing mapping of the training data ...\n");
 		
-		// here compute kernel matrix E between input data and landmark points
-		MatrixXd E = MatrixXd::Zero(N, (*param).BUDGET_SIZE);
-		for (i = 0; i < N; i++)
+		// compute kernel matrix E between input data and landmark points, and the new representation of data set E * W which will be used to train SVM
+		if ((*param).OUT_OF_CORE_TRAINING)
 		{
-			if ((*param).VERY_SPARSE_DATA)
+			// store the mapped chunk to a temporary file, linear SVM is trained over all chunks once the entire training file has been read
+			if (mappedFile == NULL)
 			{
-				// since we are computing kernels using vectors directly from the budgetedData, we need square norm of the vector to speed-up
-				// 	computations, here we compute it just once; no need to do it in non-sparse case, since this norm can be retrieved directly
-				// 	from budgetedVector
-				tempSqrNorm = trainData->getVectorSqrL2Norm(i, param);
-				for (j = 0; j < (*param).BUDGET_SIZE; j++)
+				mappedFile = tmpfile();
+				if (mappedFile == NULL)
 				{
-					E(i, j) = (double)(*(model->modelLLSVMlandmarks))[j]->computeKernel(i, trainData, param, tempSqrNorm);
-				}	
+					trainData->flushData();
+					svmPrintErrorString("Error creating a temporary file for the mapped training data!\n");
+				}
 			}
-			else
+			mapToLandmarkSpace(trainData, &landmarks, (*model).modelLLSVMmatrixW, param, mappedDataFloat);
+			if (fwrite(mappedDataFloat.data(), sizeof(float), (size_t) mappedDataFloat.size(), mappedFile) != (size_t) mappedDataFloat.size())
 			{
-				// first create the budgetedVector using the vector from budgetedData, to be used in gaussianKernel() method below
-				currentData = new budgetedVectorLLSVM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
-				currentData->createVectorUsingDataPoint(trainData, i, param);
-				
-				for (j = 0; j < (*param).BUDGET_SIZE; j++)
-				{
-					E(i, j) = (double)(*(model->modelLLSVMlandmarks))[j]->computeKernel(currentData, param);
-				}			
-				delete currentData;
-				currentData = NULL;
+				trainData->flushData();
+				svmPrintErrorString("Error writing the mapped training data to a temporary file!\n");
 			}
+			
+			for (unsigned int i = 0; i < N; i++)
+				mappedLabels.push_back(trainData->al[i]);
 		}
-		
-		// compute new representation of data set which will be used to train SVM
-		E = E * (*model).modelLLSVMmatrixW;		
-		
-		if ((*param).VERBOSE)
-			svmPrintString("Training linear SVM ...\n");
+		else if ((*param).FLOAT_MAPPED_DATA)
+			mapToLandmarkSpace(trainData, &landmarks, (*model).modelLLSVMmatrixW, param, mappedDataFloat);
+		else
+			mapToLandmarkSpace(trainData, &landmarks, (*model).modelLLSVMmatrixW, param, mappedData);
 		
 		// now we can move on to training SVM using data in a new space
-		liblinear_Solve_l2r_l1(E, trainData->al, (*model).modelLLSVMweightVector, param, &(trainData->yLabels));
+		if (!(*param).OUT_OF_CORE_TRAINING)
+		{
+			if ((*param).VERBOSE)
+				svmPrintString("Training linear SVM ...\n");
+			
+			if ((*param).FLOAT_MAPPED_DATA)
+				liblinear_Solve_oneVsRest(mappedDataFloat, trainData->al, (*model).modelLLSVMweights, param);
+			else
+				liblinear_Solve_oneVsRest(mappedData, trainData->al, (*model).modelLLSVMweights, param);
+		}
 		timeCalc += clock() - start;
 		
 		if (((*param).VERBOSE) && (N > 0))
@@ -691,6 +1849,22 @@ void trainLLSVM(budgetedData *trainData, parameters *param, budgetedModelLLSVM *
 	// training done, get rid of training data
 	trainData->flushData();
 	
+	// train linear SVM on the mapped data of all chunks, keeping the dual variables of all data points between the passes over the temporary file
+	if (mappedFile != NULL)
+	{
+		mappedDataFloat.resize(0, 0);
+		if ((*param).VERBOSE)
+			svmPrintString("Training linear SVM on the mapped data of all chunks ...\n");
+		
+		start = clock();
+		liblinear_Solve_l2r_l1_outOfCore(mappedFile, &mappedLabels, (*model).modelLLSVMweights, param);
+		timeCalc += clock() - start;
+		fclose(mappedFile);
+	}
+	
+	// fold the transformation matrix into the coefficients of the landmark points used for prediction
+	(*model).computeCoefficients();
+	
 	//timeCalc += clock() - startTotal;
     if ((*param).VERBOSE)
     {
@@ -708,7 +1882,8 @@ void trainLLSVM(budgetedData *trainData, parameters *param, budgetedModelLLSVM *
 */
 bool budgetedModelLLSVM::saveToTextFile(const char *filename, vector <int>* yLabels, parameters *param)
 {
-	unsigned int i, j;
+	unsigned int i, j, k, numClassifiers = (unsigned int) modelLLSVMcoefficients.cols();
+	bool storeMatrixW;
 	FILE *fModel = NULL;
 	
 	fModel = fopen(filename, "wt");	
@@ -749,16 +1924,28 @@ bool budgetedModelLLSVM::saveToTextFile(const char *filename, vector <int>* yLab
 	// kernel coef/intercept parameter
 	fprintf(fModel, "KERNEL_COEF_PARAM: %f\n", (*param).KERNEL_COEF_PARAM);
 	
+	// version of the format of the model, and whether the transformation matrix is stored; the matrix can only be stored if it is kept in the model
+	storeMatrixW = ((*param).STORE_MATRIX_W) && ((unsigned int) modelLLSVMmatrixW.rows() == (unsigned int) (*modelLLSVMlandmarks).size());
+	fprintf(fModel, "MODEL_VERSION: %d\n", LLSVM_MODEL_VERSION);
+	fprintf(fModel, "MATRIX_W: %d\n", (int) storeMatrixW);
+	
 	// save the model
 	fprintf(fModel, "MODEL:\n");
 	for (i = 0; i < (*modelLLSVMlandmarks).size(); i++)
 	{
-		// put the i-th value of linear SVM hyperplane
-		fprintf(fModel, "%2.6f", (double)modelLLSVMweightVector(i));
+		// put the coefficients of the i-th landmark point, one for each linear classifier
+		for (k = 0; k < numClassifiers; k++)
+			fprintf(fModel, (k == 0) ? "%2.6f" : " %2.6f", (double)modelLLSVMcoefficients(i, k));
 		
-		// next, put the values of one row of modelLLSVMmatrixW
-		for (j = 0; j < (*param).BUDGET_SIZE; j++)
-			fprintf(fModel, " %2.6f", modelLLSVMmatrixW(i, j));
+		if (storeMatrixW)
+		{
+			// put the i-th values of linear SVM hyperplanes, and the values of one row of modelLLSVMmatrixW; if the data was mapped to a lower-dimensional
+			//	space, both are padded with zeros to BUDGET_SIZE dimensions
+			for (k = 0; k < numClassifiers; k++)
+				fprintf(fModel, " %2.6f", (i < (unsigned int) modelLLSVMweights.rows()) ? (double)modelLLSVMweights(i, k) : 0.0);
+			for (j = 0; j < (*param).BUDGET_SIZE; j++)
+				fprintf(fModel, " %2.6f", (j < (unsigned int) modelLLSVMmatrixW.cols()) ? modelLLSVMmatrixW(i, j) : 0.0);
+		}
 		
 		// finally, store the landmark point
 		for (j = 0; j < (*param).DIMENSION; j++)
@@ -782,13 +1969,13 @@ bool budgetedModelLLSVM::saveToTextFile(const char *filename, vector <int>* yLab
 */
 bool budgetedModelLLSVM::loadFromTextFile(const char *filename, vector <int>* yLabels, parameters *param)
 {
-	unsigned int i, numClasses;
+	unsigned int i, k, numClasses, numClassifiers;
 	float tempFloat;
 	string text;
 	char oneWord[1024];
 	int pos, tempInt;
 	FILE *fModel = NULL;
-	bool doneReadingBool;
+	bool doneReadingBool, hasMatrixW = true, isOldVersion = false;
 	long double sqrNorm;
 	
 	fModel = fopen(filename, "rt");
@@ -809,12 +1996,13 @@ bool budgetedModelLLSVM::loadFromTextFile(const char *filename, vector <int>* yL
 		svmPrintErrorString("Error reading number of dimensions from the model file!\n");
 	}
 	
-	// number of classes (for LLSVM always equal to 2)
+	// number of classes, binary models hold one linear classifier and multi-class models one per class
 	fseek (fModel, strlen("NUMBER_OF_CLASSES: "), SEEK_CUR);
 	if (!fscanf(fModel, "%d\n", &numClasses))
 	{
 		svmPrintErrorString("Error reading number of classes from the model file!\n");
 	}
+	numClassifiers = getNumClassifiers(numClasses);
 	
 	// labels
 	fseek (fModel, strlen("LABELS: "), SEEK_CUR);
@@ -875,30 +2063,82 @@ bool budgetedModelLLSVM::loadFromTextFile(const char *filename, vector <int>* yL
 	}
 	(*param).KERNEL_COEF_PARAM = tempFloat;
 	
-	// allocate memory for model
-	modelLLSVMmatrixW.resize((*param).BUDGET_SIZE, (*param).BUDGET_SIZE);
+	// the version of the format of the model is not stored in the model files written by the earlier versions of the toolbox, which store the transformation matrix and no coefficients
+	if (!fscanf(fModel, "%1023s\n", oneWord))
+	{
+		svmPrintErrorString("Error reading the model from the model file!\n");
+	}
+	if (strcmp(oneWord, "MODEL_VERSION:") == 0)
+	{
+		if (!fscanf(fModel, "%d\n", &tempInt))
+		{
+			svmPrintErrorString("Error reading version of the model from the model file!\n");
+		}
+		if (tempInt > LLSVM_MODEL_VERSION)
+		{
+			fclose(fModel);
+			return false;
+		}
+		
+		// is the transformation matrix stored
+		fseek (fModel, strlen("MATRIX_W: "), SEEK_CUR);
+		if (!fscanf(fModel, "%d\n", &tempInt))
+		{
+			svmPrintErrorString("Error reading transformation matrix indicator from the model file!\n");
+		}
+		hasMatrixW = (tempInt != 0);
+		
+		// skip the "MODEL:" row
+		if (!fscanf(fModel, "%1023s\n", oneWord))
+		{
+			svmPrintErrorString("Error reading the model from the model file!\n");
+		}
+		modelLLSVMcoefficients.resize((*param).BUDGET_SIZE, numClassifiers);
+	}
+	else
+		isOldVersion = true;
+	(*param).STORE_MATRIX_W = hasMatrixW;
 	
-	// initialize weight (i.e., hyperplane) in the projected space to zero-vector
-	modelLLSVMweightVector.resize((*param).BUDGET_SIZE);
+	// allocate memory for model
+	if (hasMatrixW)
+	{
+		modelLLSVMmatrixW.resize((*param).BUDGET_SIZE, (*param).BUDGET_SIZE);
+		
+		// initialize weight (i.e., hyperplane) in the projected space to zero-vector
+		modelLLSVMweights.resize((*param).BUDGET_SIZE, numClassifiers);
+	}
 	
 	// load the model
-	fseek (fModel, strlen("MODEL:\n") + 1, SEEK_CUR);
 	for (i = 0; i < (*param).BUDGET_SIZE; i++)
 	{
 		budgetedVectorLLSVM *eNew = new budgetedVectorLLSVM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
 		sqrNorm = 0.0L;
 		
-		// get alphas and features below
-		
-		// get linear SVM feature
-		doneReadingBool = fgetWord(fModel, oneWord);
-		modelLLSVMweightVector(i) = (double) atof(oneWord);
+		// get the coefficients of the landmark point
+		if (!isOldVersion)
+		{
+			for (k = 0; k < numClassifiers; k++)
+			{
+				doneReadingBool = fgetWord(fModel, oneWord);
+				modelLLSVMcoefficients(i, k) = (double) atof(oneWord);
+			}
+		}
 		
-		// get elements of modelLLSVMmatrixW
-		for (unsigned int j = 0; j < (*param).BUDGET_SIZE; j++)
+		if (hasMatrixW)
 		{
-			doneReadingBool = fgetWord(fModel, oneWord);
-			modelLLSVMmatrixW(i, j) = (double) atof(oneWord);
+			// get linear SVM features
+			for (k = 0; k < numClassifiers; k++)
+			{
+				doneReadingBool = fgetWord(fModel, oneWord);
+				modelLLSVMweights(i, k) = (double) atof(oneWord);
+			}
+			
+			// get elements of modelLLSVMmatrixW
+			for (unsigned int j = 0; j < (*param).BUDGET_SIZE; j++)
+			{
+				doneReadingBool = fgetWord(fModel, oneWord);
+				modelLLSVMmatrixW(i, j) = (double) atof(oneWord);
+			}
 		}
 		
 		// get features
@@ -922,5 +2162,8 @@ bool budgetedModelLLSVM::loadFromTextFile(const char *filename, vector <int>* yL
 		eNew = NULL;
 	}
 	fclose(fModel);
+	
+	if (isOldVersion)
+		computeCoefficients();
 	return true;
 }
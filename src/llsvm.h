@@ -20,6 +20,12 @@
 extern "C" {
 #endif
 
+/*!
+    \brief Version of the format of LLSVM model files, version 1 files (without the MODEL_VERSION row) store the transformation matrix in place of the coefficients of the landmark points,
+	and version 2 files store a single binary classifier.
+*/
+#define LLSVM_MODEL_VERSION 3
+
 /*! \class budgetedVectorLLSVM
     \brief Class which holds sparse vector, which is split into a number of arrays to trade-off between speed of access and memory usage of sparse data, with added methods for LLSVM algorithm.
 */
@@ -53,6 +59,26 @@ class budgetedVectorLLSVM : public budgetedVector
 			}
 		};
 		
+		/*! \fn void createVectorUsingSparsePoint(vector <unsigned int> &indices, vector <double> &values)
+			\brief Initialize the vector using the non-zero elements of a data point.
+			\param [in] indices Zero-based indices of the non-zero elements.
+			\param [in] values Values of the non-zero elements.
+			
+			Used during the initialization stage of the LLSVM algorithm to store a sparse landmark point found by k-means in an instance of budgetedVectorLLSVM class, without 
+			expanding it to a (1 x DIMENSION) matrix.
+		*/
+		void createVectorUsingSparsePoint(vector <unsigned int> &indices, vector <double> &values)
+		{
+			for (unsigned int i = 0; i < (unsigned int) indices.size(); i++)
+			{
+				if (values[i] != 0.0)
+				{
+					(*this)[indices[i]] = (float) values[i];
+					sqrL2norm += (values[i] * values[i]);
+				}
+			}
+		};
+		
 		/*! \fn budgetedVectorLLSVM(unsigned int dim = 0, unsigned int chnkWght = 0) : budgetedVector(dim, chnkWght)
 			\brief Constructor, initializes the LLSVM vector to zero weights.
 		*/
@@ -69,14 +95,67 @@ class budgetedModelLLSVM : public budgetedModel
 	*/
 	/*! \var MatrixXd modelLLSVMmatrixW
 		\brief Holds transformation matrix, used to compute the mapping from original feature space into low-D space.
+		
+		The matrix has BUDGET_SIZE rows, and either BUDGET_SIZE columns, or at most \link parameters::NYSTROM_RANK \endlink columns if it was found by the randomized eigensolver.
 	*/
-	/*! \var VectorXd modelLLSVMweightVector
-		\brief Holds weight vector, the solution of linear SVM on transformed points.
+	/*! \var MatrixXd modelLLSVMweights
+		\brief Holds weight vectors, the solutions of linear SVMs on transformed points, one per column.
+		
+		Binary problems have a single weight vector, separating the second class from the first. Multi-class problems have one weight vector per class, separating that class from all
+		the others (one-vs-rest), and all of them are trained on the same transformed points.
+	*/
+	/*! \var MatrixXd modelLLSVMcoefficients
+		\brief Holds coefficients of the landmark points, equal to \link modelLLSVMmatrixW \endlink * \link modelLLSVMweights \endlink, one column per linear classifier.
+		
+		The score of a data point x is k(x)^T * W * w, where k(x) is the vector of kernel values between x and the landmark points. As the linear classifiers do not change after training,
+		the product of the transformation matrix and the weight vectors is computed once after training, and the scores are then obtained as the product of k(x) and the coefficients, 
+		without the (BUDGET_SIZE x BUDGET_SIZE) matrix-vector product for each data point. Only the coefficients are needed for prediction, and the transformation matrix and the weight 
+		vectors are stored in the model file only if \link parameters::STORE_MATRIX_W \endlink is set.
 	*/
 	public:
 		vector <budgetedVectorLLSVM*> *modelLLSVMlandmarks;
-		VectorXd modelLLSVMweightVector;
+		MatrixXd modelLLSVMweights;
 		MatrixXd modelLLSVMmatrixW;
+		MatrixXd modelLLSVMcoefficients;
+		
+		/*! \fn static unsigned int getNumClassifiers(unsigned int numClasses)
+			\brief Returns the number of linear classifiers LLSVM trains for the given number of classes, one for binary problems, and one per class otherwise.
+		*/
+		static unsigned int getNumClassifiers(unsigned int numClasses)
+		{
+			return (numClasses > 2) ? numClasses : 1;
+		};
+		
+		/*! \fn void computeCoefficients(void)
+			\brief Computes the coefficients of the landmark points from the transformation matrix and the weight vectors of linear SVMs. \sa modelLLSVMcoefficients
+		*/
+		void computeCoefficients(void)
+		{
+			modelLLSVMcoefficients = modelLLSVMmatrixW * modelLLSVMweights;
+		};
+		
+		/*! \fn void extendNumberOfClasses(unsigned int numClasses)
+			\brief Adds the linear classifiers for the classes found in the newly loaded data chunk. \sa modelLLSVMweights
+			
+			When a binary model becomes a multi-class one, its weight vector separates the second class from the first, and its negation the first class from the second, which are used as the
+			one-vs-rest weight vectors of the first two classes. The weight vectors of new classes start at zero.
+		*/
+		void extendNumberOfClasses(unsigned int numClasses)
+		{
+			unsigned int oldNumClassifiers = (unsigned int) modelLLSVMweights.cols(), newNumClassifiers = getNumClassifiers(numClasses);
+			if (newNumClassifiers <= oldNumClassifiers)
+				return;
+			
+			MatrixXd oldWeights = modelLLSVMweights;
+			modelLLSVMweights = MatrixXd::Zero(oldWeights.rows(), newNumClassifiers);
+			if (oldNumClassifiers == 1)
+			{
+				modelLLSVMweights.col(0) = -oldWeights.col(0);
+				modelLLSVMweights.col(1) = oldWeights.col(0);
+			}
+			else
+				modelLLSVMweights.leftCols(oldNumClassifiers) = oldWeights;
+		};
 		
 		/*! \fn void extendDimensionalityOfModel(unsigned int newDim, parameters* param)
 			\brief Extends the dimensionality of each landmark point in the LLSVM model.
@@ -103,8 +182,9 @@ class budgetedModelLLSVM : public budgetedModel
 		*/	
 		~budgetedModelLLSVM(void)
 		{
-			modelLLSVMweightVector.resize(0, 0);
+			modelLLSVMweights.resize(0, 0);
 			modelLLSVMmatrixW.resize(0, 0);
+			modelLLSVMcoefficients.resize(0, 0);
 			if (modelLLSVMlandmarks)
 			{
 				for (unsigned int i = 0; i < (*modelLLSVMlandmarks).size(); i++)
@@ -123,11 +203,13 @@ class budgetedModelLLSVM : public budgetedModel
 			\param [in] param The parameters of the algorithm.
 			\return Returns false if error encountered, otherwise true.
 			
-			The text file has the following rows: [\a ALGORITHM, \a DIMENSION, \a NUMBER_OF_CLASSES, \a LABELS, \a NUMBER_OF_WEIGHTS, \a BIAS_TERM, \a KERNEL_WIDTH, \a MODEL]. In order to compress memory and to use the 
-			memory efficiently, we coded the model in the following way:
+			The text file has the following rows: [\a ALGORITHM, \a DIMENSION, \a NUMBER_OF_CLASSES, \a LABELS, \a NUMBER_OF_WEIGHTS, \a BIAS_TERM, \a KERNEL_FUNCTION, \a KERNEL_GAMMA_PARAM,
+			\a KERNEL_DEGREE_PARAM, \a KERNEL_COEF_PARAM, \a MODEL_VERSION, \a MATRIX_W, \a MODEL]. In order to compress memory and to use the memory efficiently, we coded the model in the following way:
 			
-			Each row corresponds to one landmark point. The first element of each row corresponds to element of linear SVM hyperplane for that particular
-			landmark point. This is followed by features of the landmark point in the original feature space of the data set, stored in LIBSVM format.
+			Each row corresponds to one landmark point. The row starts with the coefficients of that particular landmark point (see \link modelLLSVMcoefficients \endlink), one for binary
+			problems and \a NUMBER_OF_CLASSES for multi-class problems. If \a MATRIX_W is 1, they are followed by the elements of linear SVM hyperplanes, as many as there are coefficients, 
+			and by the row of the transformation matrix for that landmark point. This is followed by features of the landmark point in the original feature space of the data set, stored 
+			in LIBSVM format.
 		*/
 		bool saveToTextFile(const char *filename, vector <int>* yLabels, parameters *param);
 		
@@ -138,11 +220,9 @@ class budgetedModelLLSVM : public budgetedModel
 			\param [out] param The parameters of the algorithm.
 			\return Returns false if error encountered, otherwise true.
 			
-			The text file has the following rows: [\a ALGORITHM, \a DIMENSION, \a NUMBER_OF_CLASSES, \a LABELS, \a NUMBER_OF_WEIGHTS, \a BIAS_TERM, \a KERNEL_WIDTH, \a MODEL]. In order to compress memory and to use the 
-			memory efficiently, we coded the model in the following way:
-			
-			Each row corresponds to one landmark point. The first element of each row corresponds to element of linear SVM hyperplane for that particular
-			landmark point. This is followed by features of the landmark point in the original feature space of the data set, stored in LIBSVM format.
+			See \link saveToTextFile \endlink for the format of the file. Model files without the \a MODEL_VERSION row were written by the earlier versions of the toolbox, where each row holds
+			the element of linear SVM hyperplane and the row of the transformation matrix, followed by the features of the landmark point; for these files the coefficients of the 
+			landmark points are computed after loading.
 		*/
 		bool loadFromTextFile(const char *filename, vector <int>* yLabels, parameters *param);
 };
@@ -168,7 +248,7 @@ void trainLLSVM(budgetedData *trainData, parameters *param, budgetedModelLLSVM *
 	\param [out] scores Vector of scores of the winning labels.
 	\return Testing set error rate.
 	
-	Given the learned BSGD model, the function computes the predictions on the testing data, outputing the predicted labels and the error rate.
+	Given the learned LLSVM model, the function computes the predictions on the testing data, outputing the predicted labels and the error rate.
 */
 float predictLLSVM(budgetedData *testData, parameters *param, budgetedModelLLSVM *model, vector <int> *labels = NULL, vector <float> *scores = NULL);
 
@@ -31,15 +31,885 @@ using namespace std;
 namespace
 {
 
-/* \fn double get_random_probability(void)
+/* \fn double get_random_probability(unsigned int *seed = NULL)
 	\brief Samples a random number is [0, 1] range.
+	\param [in,out] seed State of a private linear congruential generator, if NULL the shared generator rand() is used.
 	\return A random value in [0, 1] range.
+	
+	The threads of parallel training use their own generators, as concurrent calls of rand() are not thread-safe.
 */
-double get_random_probability(void)
+double get_random_probability(unsigned int *seed = NULL)
 {
+	if (seed)
+	{
+		*seed = *seed * 1664525U + 1013904223U;
+		return ((double) (*seed >> 8) / (double) 0xFFFFFF);
+	}
 	return ((double) rand() / (double) RAND_MAX);
 }
 
+/* \class weightSlotIndex
+	\brief Hash index of the weights of AMM model, maps the ID of a weight to its class and to its index within the class.
+	
+	AMM batch stores the assignments of training examples to weights as weight IDs, which unlike the positions of the weights in the model are not changed by cloning and pruning.
+	The index is updated whenever a weight is added to or removed from the model, and it is used to find the weight assigned to an example in expected constant time, without scanning
+	the weights of its class. The IDs are given out sequentially, so the lowest bits of an ID select its bucket, and the number of buckets is doubled when there are more IDs than buckets.
+	The ID of a pruned weight is not erased but redirected to a surviving weight of the same class, which takes over the examples assigned to the pruned weight, see pruneWeights().
+*/
+class weightSlotIndex
+{
+	/* \struct weightSlot
+		\brief Entry of the index, for a pruned weight holds the ID of the weight that replaced it.
+	*/
+	struct weightSlot
+	{
+		unsigned int id, classIndex, slot, redirectID;
+		bool pruned;
+	};
+	
+	vector < vector <weightSlot> > buckets;
+	unsigned int numIDs;
+	
+	/* \fn weightSlot* findID(unsigned int id)
+		\brief Finds the entry of the given ID.
+		\param [in] id ID of the weight.
+		\return Pointer to the entry, or NULL if the ID is not in the index.
+	*/
+	weightSlot* findID(unsigned int id)
+	{
+		vector <weightSlot> *bucket = &(buckets[id & (buckets.size() - 1)]);
+		for (unsigned int i = 0; i < (*bucket).size(); i++)
+			if ((*bucket)[i].id == id)
+				return &((*bucket)[i]);
+		return NULL;
+	}
+	
+	/* \fn void grow(void)
+		\brief Doubles the number of buckets and redistributes the entries.
+	*/
+	void grow(void)
+	{
+		vector < vector <weightSlot> > oldBuckets(2 * buckets.size());
+		oldBuckets.swap(buckets);
+		for (unsigned int i = 0; i < oldBuckets.size(); i++)
+			for (unsigned int j = 0; j < oldBuckets[i].size(); j++)
+				buckets[oldBuckets[i][j].id & (buckets.size() - 1)].push_back(oldBuckets[i][j]);
+	}
+	
+	public:
+		/* \fn weightSlotIndex(void)
+			\brief Constructor, creates an empty index.
+		*/
+		weightSlotIndex(void)
+		{
+			buckets.resize(64);
+			numIDs = 0;
+		}
+		
+		/* \fn void setSlot(unsigned int id, unsigned int classIndex, unsigned int slot)
+			\brief Adds a weight to the index, or updates its position if it is already indexed.
+			\param [in] id ID of the weight.
+			\param [in] classIndex Class of the weight.
+			\param [in] slot Index of the weight within its class.
+		*/
+		void setSlot(unsigned int id, unsigned int classIndex, unsigned int slot)
+		{
+			weightSlot *entry = findID(id);
+			if (entry == NULL)
+			{
+				if (++numIDs > buckets.size())
+					grow();
+				buckets[id & (buckets.size() - 1)].push_back(weightSlot());
+				entry = &(buckets[id & (buckets.size() - 1)].back());
+				(*entry).id = id;
+			}
+			(*entry).classIndex = classIndex;
+			(*entry).slot = slot;
+			(*entry).pruned = false;
+		}
+		
+		/* \fn void redirect(unsigned int id, unsigned int targetID)
+			\brief Marks a weight as pruned, the examples assigned to it are from now on assigned to the target weight.
+			\param [in] id ID of the pruned weight.
+			\param [in] targetID ID of the weight that replaces it.
+		*/
+		void redirect(unsigned int id, unsigned int targetID)
+		{
+			weightSlot *entry = findID(id);
+			if (entry)
+			{
+				(*entry).pruned = true;
+				(*entry).redirectID = targetID;
+			}
+		}
+		
+		/* \fn bool find(unsigned int *id, unsigned int *classIndex, unsigned int *slot)
+			\brief Finds the weight with the given ID, following the redirects of pruned weights.
+			\param [in,out] id ID of the weight, on return the ID of the live weight that it resolves to.
+			\param [out] classIndex Class of the found weight.
+			\param [out] slot Index of the found weight within its class.
+			\return True if the weight was found, false otherwise.
+		*/
+		bool find(unsigned int *id, unsigned int *classIndex, unsigned int *slot)
+		{
+			weightSlot *entry = findID(*id);
+			while (entry && (*entry).pruned)
+			{
+				*id = (*entry).redirectID;
+				entry = findID(*id);
+			}
+			if (entry == NULL)
+				return false;
+			
+			*classIndex = (*entry).classIndex;
+			*slot = (*entry).slot;
+			return true;
+		}
+		
+		/* \fn void clearRedirects(void)
+			\brief Removes the entries of pruned weights, called once no assignment refers to them anymore.
+		*/
+		void clearRedirects(void)
+		{
+			for (unsigned int i = 0; i < buckets.size(); i++)
+				for (unsigned int j = 0; j < buckets[i].size(); )
+				{
+					if (buckets[i][j].pruned)
+					{
+						buckets[i][j] = buckets[i].back();
+						buckets[i].pop_back();
+						numIDs--;
+					}
+					else
+						j++;
+				}
+		}
+};
+
+/* \struct weightNorm
+	\brief Squared norm of a weight, together with the class of the weight and its index within the class, used when pruning the model.
+*/
+struct weightNorm
+{
+	long double norm;
+	unsigned int classIndex, slot;
+};
+
+/* \struct largerWeightNorm
+	\brief Strict ordering of weights by their norms, where ties are broken by the class and by the index within the class; as used with heap functions it gives a min-heap.
+*/
+struct largerWeightNorm
+{
+	bool operator()(const weightNorm &a, const weightNorm &b) const
+	{
+		if (a.norm != b.norm)
+			return (a.norm > b.norm);
+		if (a.classIndex != b.classIndex)
+			return (a.classIndex > b.classIndex);
+		return (a.slot > b.slot);
+	}
+};
+
+/* \fn unsigned int pruneWeights(budgetedModelAMM *model, vector <unsigned int> *n, unsigned int numIter, parameters *param, weightSlotIndex *slotIndex = NULL)
+	\brief Removes the weights with the smallest norms from the AMM model, as long as their aggregate squared norm is below the pruning threshold.
+	\param [in,out] model Current AMM model.
+	\param [in,out] n Number of weights per class.
+	\param [in] numIter Total number of training iterations so far.
+	\param [in] param The parameters of the algorithm.
+	\param [in,out] slotIndex Index of the weights, if not NULL the removed weights are redirected in it and the new positions of the remaining weights are updated.
+	\return Number of removed weights.
+	
+	Instead of sorting all weight norms, the weights are put in a min-heap ordered by (norm, class, index) and popped only while their aggregate squared norm is below the threshold,
+	which costs O(W + k log(W)) for W weights and k removed weights, and resolves ties deterministically. The marked weights are then removed in a single compaction pass per class.
+	The last weight of a class is never removed. When the index is given, each removed weight is redirected to the surviving weight of its class with the largest dot product with it,
+	so that the examples assigned to the removed weight are explicitly remapped to that weight.
+*/
+unsigned int pruneWeights(budgetedModelAMM *model, vector <unsigned int> *n, unsigned int numIter, parameters *param, weightSlotIndex *slotIndex = NULL)
+{
+	long double sumNorms = 0.0, sumThreshold = (long double)(*param).C_PARAM * (long double)(*param).C_PARAM / ((long double)numIter * (long double)numIter * (*param).LAMBDA_PARAM * (*param).LAMBDA_PARAM);
+	long double degradationScale = (*model).getDegradationScale();
+	vector <vectorOfBudgetVectors> *weights = (*model).getModel();
+	vector <weightNorm> norms;
+	vector < vector <bool> > toDelete((*weights).size());
+	vectorOfBudgetVectors deleted;
+	unsigned int i, j, k, numDeleted = 0, numKept, bestSlot;
+	long double fx, maxFx;
+	weightNorm currNorm;
+	
+	// first find the norms of weights, recomputing the ones that might have drifted too far from their exact values
+	(*model).resyncNorms(param);
+	for (i = 0; i < (*weights).size(); i++)
+	{
+		toDelete[i].assign((*weights)[i].size(), false);
+		for (j = 0; j < (*weights)[i].size(); j++)
+		{
+			currNorm.norm = (double) ((*weights)[i][j]->getSqrL2norm() * degradationScale * degradationScale);
+			currNorm.classIndex = i;
+			currNorm.slot = j;
+			norms.push_back(currNorm);
+		}
+	}
+	
+	// take the smallest norms one by one, until the threshold is exceeded
+	vector <weightNorm>::iterator heapEnd = norms.end();
+	make_heap(norms.begin(), heapEnd, largerWeightNorm());
+	while (heapEnd != norms.begin())
+	{
+		sumNorms += norms.front().norm;
+		if (sumNorms > sumThreshold)
+			break;
+		
+		pop_heap(norms.begin(), heapEnd, largerWeightNorm());
+		heapEnd--;
+		toDelete[(*heapEnd).classIndex][(*heapEnd).slot] = true;
+	}
+	
+	// remove the marked weights, compacting the weights of each class in a single pass
+	for (i = 0; i < (*weights).size(); i++)
+	{
+		numKept = 0;
+		deleted.clear();
+		for (j = 0; j < (*weights)[i].size(); j++)
+		{
+			if (toDelete[i][j])
+			{
+				// make sure that at least one weight of the class survives
+				if ((numKept == 0) && (j == (*weights)[i].size() - 1))
+				{
+					svmPrintString("Was about to delete all weights of a class, check the K_PARAM and C_PARAM parameters!\n");
+				}
+				else
+				{
+					deleted.push_back((*weights)[i][j]);
+					numDeleted++;
+					continue;
+				}
+			}
+			
+			if ((slotIndex) && (numKept != j))
+				(*slotIndex).setSlot((*weights)[i][j]->getID(), i, numKept);
+			(*weights)[i][numKept++] = (*weights)[i][j];
+		}
+		(*weights)[i].resize(numKept);
+		(*n)[i] = numKept;
+		
+		// remap the examples of each removed weight to the most similar surviving weight of the class, then delete the removed weight
+		for (k = 0; k < deleted.size(); k++)
+		{
+			if (slotIndex)
+			{
+				bestSlot = 0;
+				maxFx = -INF;
+				for (j = 0; j < numKept; j++)
+				{
+					fx = deleted[k]->linearKernel((*weights)[i][j]);
+					if (fx > maxFx)
+					{
+						bestSlot = j;
+						maxFx = fx;
+					}
+				}
+				(*slotIndex).redirect(deleted[k]->getID(), (*weights)[i][bestSlot]->getID());
+			}
+			delete deleted[k];
+		}
+	}
+	return numDeleted;
+}
+
+/* \struct weightScorer
+	\brief Scores of all weights of AMM model for a single training example, computed in parallel when the model is large enough.
+	
+	The scores are stored class after class in the order of the weights in the model, so that the score of j-th weight of i-th class is found at index classOffsets[i] + j.
+	When the model holds at least PARALLEL_SCORING_MIN weights and more than one thread is used the scores are computed in parallel over the whole class x weight grid, 
+	and serially otherwise. Each score is computed by the same call in both cases, while the best-scoring weights are selected from the computed scores serially by the 
+	training functions, so that the learned model, including the breaking of ties between equal scores, does not depend on the number of threads. Mini-batch training can 
+	instead compute the scores using the packed weight matrix of the model, which is then built only once per mini-batch. \sa parameters::MINI_BATCH_SIZE
+*/
+struct weightScorer
+{
+	vector <budgetedVectorAMM*> weights;
+	vector <long double> scores;
+	vector <unsigned int> classOffsets;
+	vector <double> packedScores;
+	bool usePackedWeights;
+	
+	/* \fn weightScorer(bool usePacked = false)
+		\brief Constructor of the structure.
+		\param [in] usePacked If true, the scores are computed using the packed weight matrix of the model. \sa budgetedModelAMM::computePackedScores()
+	*/
+	weightScorer(bool usePacked = false)
+	{
+		usePackedWeights = usePacked;
+	}
+	
+	/* \fn void computeScores(budgetedModelAMM *model, vector <unsigned int> *n, unsigned int t, budgetedData *trainData, budgetedVectorAMM *currentData, parameters *param)
+		\brief Computes the scores of all weights of the model for a single training example.
+		\param [in] model Current AMM model.
+		\param [in] n Number of weights per class.
+		\param [in] t Index of the training example in the loaded data chunk.
+		\param [in] trainData Loaded training data chunk.
+		\param [in] currentData The training example stored in budgetedVectorAMM, not used (and can be NULL) when the data is very sparse or the packed weight matrix is used.
+		\param [in] param The parameters of the algorithm.
+	*/
+	void computeScores(budgetedModelAMM *model, vector <unsigned int> *n, unsigned int t, budgetedData *trainData, budgetedVectorAMM *currentData, parameters *param)
+	{
+		unsigned int numWeights = 0, column = 0;
+		
+		classOffsets.resize((*n).size());
+		for (unsigned int i = 0; i < (*n).size(); i++)
+		{
+			classOffsets[i] = numWeights;
+			numWeights += (*n)[i];
+		}
+		scores.resize(numWeights);
+		
+		if (usePackedWeights)
+		{
+			// the packed scores include the degradation scale of the model, while the returned scores are relative to it as the ones computed by linearKernel()
+			(*model).computePackedScores(t, trainData, param, &packedScores);
+			for (column = 0; column < numWeights; column++)
+				scores[column] = (long double) packedScores[column] / (*model).getDegradationScale();
+			return;
+		}
+		
+#ifdef _OPENMP
+		unsigned int numThreads = getNumThreads(param);
+		if ((numThreads > 1) && (numWeights >= (*param).PARALLEL_SCORING_MIN))
+		{
+			// flatten the class x weight grid, so that it can be split evenly across the threads regardless of the number of weights per class
+			weights.resize(numWeights);
+			for (unsigned int i = 0; i < (*n).size(); i++)
+				for (unsigned int j = 0; j < (*n)[i]; j++)
+					weights[column++] = (*((*model).getModel()))[i][j];
+			
+			#pragma omp parallel for num_threads(numThreads) schedule(static)
+			for (int k = 0; k < (int) numWeights; k++)
+			{
+				if ((*param).VERY_SPARSE_DATA)
+					scores[k] = weights[k]->linearKernel(t, trainData, param);
+				else
+					scores[k] = weights[k]->linearKernel(currentData);
+			}
+			return;
+		}
+#endif
+		
+		for (unsigned int i = 0; i < (*n).size(); i++)
+		{
+			for (unsigned int j = 0; j < (*n)[i]; j++)
+			{
+				if ((*param).VERY_SPARSE_DATA)
+					scores[column++] = (*((*model).getModel()))[i][j]->linearKernel(t, trainData, param);
+				else
+					scores[column++] = (*((*model).getModel()))[i][j]->linearKernel(currentData);
+			}
+		}
+	}
+	
+	/* \fn long double getScore(unsigned int classIndex, unsigned int slot)
+		\brief Returns the score of a weight computed by the last call of computeScores().
+		\param [in] classIndex Class of the weight.
+		\param [in] slot Index of the weight within its class.
+		\return Score of the weight.
+	*/
+	long double getScore(unsigned int classIndex, unsigned int slot)
+	{
+		return scores[classOffsets[classIndex] + slot];
+	}
+};
+
+/* \struct weightUpdate
+	\brief Update of a weight of AMM model by a training example, recorded while a mini-batch is scored against the model and applied at the end of the mini-batch.
+*/
+struct weightUpdate
+{
+	unsigned int classIndex, slot, t;
+	int sign;
+};
+
+/* \fn void applyWeightUpdates(budgetedModelAMM *model, vector <weightUpdate> *updates, budgetedData *trainData, unsigned int numSteps, unsigned int batchSize, parameters *param)
+	\brief Applies the weight updates recorded during a mini-batch, and clears them.
+	\param [in,out] model Current AMM model.
+	\param [in,out] updates Updates recorded during the mini-batch.
+	\param [in] trainData Loaded training data chunk, holding the examples of the mini-batch.
+	\param [in] numSteps Number of training steps so far, including the current mini-batch.
+	\param [in] batchSize Number of examples in the mini-batch.
+	\param [in] param The parameters of the algorithm.
+	
+	The updates are applied in the order they were recorded, each one adding the sub-gradient of its example divided by the mini-batch size to the updated weight,
+	where only the non-zero features of the example are visited. As all updates use the learning rate at the end of the mini-batch, each weight ends up moved by the
+	average of the sub-gradients of its examples, up to floating-point rounding.
+*/
+void applyWeightUpdates(budgetedModelAMM *model, vector <weightUpdate> *updates, budgetedData *trainData, unsigned int numSteps, unsigned int batchSize, parameters *param)
+{
+	for (unsigned int k = 0; k < (*updates).size(); k++)
+	{
+		weightUpdate &update = (*updates)[k];
+		(*((*model).getModel()))[update.classIndex][update.slot]->updateUsingDataPoint(trainData, numSteps, update.t, update.sign, param, (*model).getDegradationScale(), batchSize);
+	}
+	(*updates).clear();
+}
+
+/* \fn void reportEpoch(unsigned int epoch, unsigned int numExamples, unsigned int numErrors, unsigned long epochTime, parameters *param)
+	\brief Prints the training error and the training speed of a completed epoch, used to monitor the convergence of Pegasos and AMM online.
+	\param [in] epoch Index of the completed epoch, starting from 0.
+	\param [in] numExamples Number of examples processed during the epoch.
+	\param [in] numErrors Number of examples misclassified by the model at the time they were scored.
+	\param [in] epochTime Training time of the epoch, in clock ticks.
+	\param [in] param The parameters of the algorithm.
+*/
+void reportEpoch(unsigned int epoch, unsigned int numExamples, unsigned int numErrors, unsigned long epochTime, parameters *param)
+{
+	char text[1024];
+	double epochSeconds = (double) epochTime / (double) CLOCKS_PER_SEC;
+	
+	sprintf(text, "Epoch %d/%d done, training error %.2f%%", epoch + 1, (*param).NUM_EPOCHS, (numExamples > 0) ? 100.0 * (double) numErrors / (double) numExamples : 0.0);
+	svmPrintString(text);
+	if (epochSeconds > 0.0)
+	{
+		sprintf(text, ", %.0f examples/s", (double) numExamples / epochSeconds);
+		svmPrintString(text);
+	}
+	svmPrintString(".\n");
+}
+
+/* \fn void allocateWeightChunks(budgetedModelAMM *model, budgetedData *trainData, parameters *param)
+	\brief Allocates the chunks of all weights of the model that can be modified by the examples of the loaded data chunk.
+	\param [in,out] model Current model.
+	\param [in] trainData Loaded training data chunk.
+	\param [in] param The parameters of the algorithm.
+	
+	The chunks of the weights are otherwise allocated only when one of their elements becomes non-zero, and two threads that concurrently allocate the same 
+	chunk would lose the updates of one of them. After this function is called the updates of the weights by the examples of the chunk do not modify the 
+	structure of the weights, and can be done concurrently.
+*/
+void allocateWeightChunks(budgetedModelAMM *model, budgetedData *trainData, parameters *param)
+{
+	unsigned int numChunks = ((*param).DIMENSION - 1) / (*param).CHUNK_WEIGHT + 1;
+	vector <bool> usedChunks(numChunks, false);
+	
+	for (unsigned long i = 0; i < trainData->aj.size(); i++)
+		usedChunks[(trainData->aj[i] - 1) / (*param).CHUNK_WEIGHT] = true;
+	if ((*param).BIAS_TERM != 0)
+		usedChunks[((*param).DIMENSION - 1) / (*param).CHUNK_WEIGHT] = true;
+	
+	// accessing an element through the non-const operator allocates its chunk, without modifying the element
+	for (unsigned int i = 0; i < (*((*model).getModel())).size(); i++)
+		for (unsigned int j = 0; j < (*((*model).getModel()))[i].size(); j++)
+			for (unsigned int k = 0; k < numChunks; k++)
+				if (usedChunks[k])
+					(*(*((*model).getModel()))[i][j])[(int) (k * (*param).CHUNK_WEIGHT)];
+}
+
+/* \fn unsigned int trainPegasosChunkParallel(budgetedData *trainData, vector <unsigned int> *tv, parameters *param, budgetedModelAMM *model, unsigned int *numIter)
+	\brief Runs Pegasos over the loaded data chunk in parallel, with Hogwild-style updates of the shared weights.
+	\param [in] trainData Loaded training data chunk.
+	\param [in] tv Order in which the examples of the chunk are visited.
+	\param [in] param The parameters of the algorithm.
+	\param [in,out] model Current Pegasos model.
+	\param [in,out] numIter Total number of training iterations so far, increased by the number of examples in the chunk.
+	\return Number of examples misclassified by the model at the time they were scored.
+	
+	The threads take the examples from a shared queue in the order given by tv, and update the shared weights of the classes without any locking, as
+	proposed in "Hogwild!: A Lock-Free Approach to Parallelizing Stochastic Gradient Descent" by Niu et al. The racy updates only touch the non-zero
+	features of the examples, which for sparse data rarely collide. Each example takes its iteration number from a global step counter, which determines 
+	its learning rate and the degradation scale used for its scores and updates, so that the degradation of the weights is coordinated across the threads.
+	The degradation step counter of the model is set to the last step once the chunk is processed. With a single thread the function computes the same 
+	model as the serial Pegasos up to round-off, while with more threads the model depends on the scheduling of the threads.
+*/
+unsigned int trainPegasosChunkParallel(budgetedData *trainData, vector <unsigned int> *tv, parameters *param, budgetedModelAMM *model, unsigned int *numIter)
+{
+	unsigned int sizeOfyLabels = (unsigned int) (*((*model).getModel())).size(), numErrors = 0, step = *numIter;
+	int N = (int) (*tv).size();
+	
+	allocateWeightChunks(model, trainData, param);
+	
+#ifdef _OPENMP
+	#pragma omp parallel for num_threads(getNumThreads(param)) schedule(dynamic, 64) reduction(+:numErrors)
+#endif
+	for (int ot = 0; ot < N; ot++)
+	{
+		unsigned int t = (*tv)[ot], i1 = trainData->al[t], i2 = 0, currStep;
+		long double fx, fx1, fx2 = -INF;
+		
+#ifdef _OPENMP
+		#pragma omp atomic capture
+#endif
+		currStep = ++step;
+		
+		// the scores are computed directly from the data chunk, as creating a budgetedVector for the example would take a weight ID from the shared counter
+		fx1 = (*((*model).getModel()))[i1][0]->linearKernel(t, trainData, param);
+		
+		//calculate i-, fi-
+		for (unsigned int i = 0; i < sizeOfyLabels; i++)
+		{
+			if (i == i1)
+				continue;
+			
+			fx = (*((*model).getModel()))[i][0]->linearKernel(t, trainData, param);
+			if (fx > fx2)
+			{
+				fx2 = fx;
+				i2 = i;
+			}
+		}
+		
+		// the scores were computed from weight degradations that are relative to the degradation scale of the model, which after the previous step 
+		//	is 1 / currStep; the scales are computed from the step of the example and not read from the model, where the shared step counter is set only after the loop
+		fx1 /= (long double) currStep;
+		fx2 /= (long double) currStep;
+		if (fx2 >= fx1)
+			numErrors++;
+		
+		// calculate the margin, if misclassified update weights, using the degradation scale of the model downgraded to the current step
+		if (1.0L + fx2 - fx1 > 0.0L)
+		{
+			(*((*model).getModel()))[i2][0]->updateUsingDataPoint(trainData, currStep, t, -1, param, 1.0L / ((long double) currStep + 1.0L));
+			(*((*model).getModel()))[i1][0]->updateUsingDataPoint(trainData, currStep, t, 1, param, 1.0L / ((long double) currStep + 1.0L));
+		}
+	}
+	
+	// downgrade the weights to the last step of the chunk, which only sets the degradation step counter of the model
+	(*model).downgrade(step);
+	
+	*numIter = step;
+	return numErrors;
+}
+
+/* \struct onlineCounters
+	\brief Counters of AMM online training, kept separately by each thread of the parallel training and summed when the models of the threads are averaged.
+*/
+struct onlineCounters
+{
+	unsigned int numIter, numSteps, numNew, numDeleted, numErrors;
+};
+
+/* \fn void trainAMMonlineExamples(budgetedData *trainData, vector <unsigned int> *examples, unsigned int firstStep, unsigned int stepStride, parameters *param, budgetedModelAMM *model, vector <unsigned int> *n, weightScorer *scorer, onlineCounters *counters, bool prune, unsigned int *seed = NULL)
+	\brief Runs AMM online over the given examples of the loaded data chunk, in mini-batches of \link parameters::MINI_BATCH_SIZE \endlink examples.
+	\param [in] trainData Loaded training data chunk.
+	\param [in] examples Indices of the examples of the chunk, in the order in which they are visited.
+	\param [in] firstStep Training step of the first mini-batch.
+	\param [in] stepStride Difference between the training steps of two consecutive mini-batches.
+	\param [in] param The parameters of the algorithm.
+	\param [in,out] model Current AMM model, degraded up to the step preceding firstStep.
+	\param [in,out] n Number of weights per class.
+	\param [in] scorer Scorer used to compute the scores of the weights.
+	\param [in,out] counters Training counters, where numSteps is set to the training step of the last mini-batch.
+	\param [in] prune If true, the model is pruned whenever the number of processed examples reaches a multiple of \link parameters::K_PARAM \endlink.
+	\param [in,out] seed State of the random number generator used for the cloning decisions, if NULL the shared generator is used. \sa get_random_probability
+	
+	The serial training visits all examples of the chunk with the stride of 1, while each thread of the parallel training visits every K-th example of the chunk,
+	with the training steps of the examples interleaved between the K threads, so that the learning rates and the degradations match the serial training.
+*/
+void trainAMMonlineExamples(budgetedData *trainData, vector <unsigned int> *examples, unsigned int firstStep, unsigned int stepStride, parameters *param, budgetedModelAMM *model, vector <unsigned int> *n, weightScorer *scorer, onlineCounters *counters, bool prune, unsigned int *seed = NULL)
+{
+	long double fx1, fx2, maxFx;
+	unsigned int sizeOfyLabels = (unsigned int) (*n).size(), i1, i2, j1, j2, t, N = (unsigned int) (*examples).size();
+	unsigned int numSteps = firstStep, numInBatch = 0, batchSize = (*param).MINI_BATCH_SIZE;
+	budgetedVectorAMM *currentData = NULL;
+	vector <weightUpdate> updates;
+	vector < pair <unsigned int, unsigned int> > clones;
+	vector <unsigned int> newWeights;
+	
+	for (unsigned int ob = 0; ob < N; ob += numInBatch, numSteps += stepStride)
+	{
+		// the examples of a mini-batch are all scored against the model as it was at the start of the mini-batch
+		numInBatch = ((N - ob) < batchSize) ? (N - ob) : batchSize;
+		(*counters).numSteps = numSteps;
+		for (unsigned int ot = ob; ot < ob + numInBatch; ot++)
+		{
+			(*counters).numIter++;
+			t = (*examples)[ot];
+			
+			if ((!(*param).VERY_SPARSE_DATA) && (!(*scorer).usePackedWeights))
+			{
+				// only create currentData if the data is non-sparse, otherwise kernels will be computed directly from trainData
+				currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
+				currentData->budgetedVector::createVectorUsingDataPoint(trainData, t, param);
+			}
+			
+			// score all weights of the model, in parallel if the model is large enough
+			(*scorer).computeScores(model, n, t, trainData, currentData, param);
+			if (currentData)
+			{
+				delete currentData;
+				currentData = NULL;
+			}
+			
+			//calculate i+,j+
+			i1 = trainData->al[t];
+			j1 = 0;
+			maxFx = -INF;
+			
+			for (unsigned int j = 0; j < (*n)[i1]; j++)
+			{
+				fx1 = (*scorer).getScore(i1, j);
+				if (fx1 > maxFx)
+				{
+					j1 = j;
+					maxFx = fx1;
+				}
+			}
+			fx1 = maxFx;
+			
+			// calculate i-, j-
+			i2 = 0;
+			j2 = 0;
+			fx2 = 0;
+			maxFx = -INF;
+			for (unsigned int i = 0; i < sizeOfyLabels; i++)
+			{
+				if (i == i1)
+					continue;
+					
+				for (unsigned int j = 0; j < (*n)[i]; j++)
+				{
+					fx2 = (*scorer).getScore(i, j);
+					if (fx2 > maxFx)
+					{
+						maxFx = fx2;
+						i2 = i;
+						j2 = j;
+					}
+				}
+			}
+			fx2 = maxFx;
+			
+			// the scores were computed from weight degradations that are relative to the degradation scale of the model
+			fx1 *= (*model).getDegradationScale();
+			fx2 *= (*model).getDegradationScale();
+			if (fx2 >= fx1)
+				(*counters).numErrors++;
+			
+			if (1.0 + fx2 - fx1 > 0.0)
+			{
+				// we made a misprediction, push negative class further away, and positive closer! the updates
+				//	are recorded here, and applied at the end of the mini-batch
+				weightUpdate negativeUpdate = {i2, j2, t, -1};
+				updates.push_back(negativeUpdate);
+				
+				// update the true class weight
+				if (fx1 > 0.0)
+				{
+					// here clone the best weight if the cloning probability allows it
+					if ((unsigned int)(*n)[i1] < (*param).BUDGET_SIZE)
+					{
+						if ((*param).CLONE_PROBABILITY > get_random_probability(seed))
+							clones.push_back(make_pair(i1, j1));
+					}
+					
+					weightUpdate positiveUpdate = {i1, j1, t, 1};
+					updates.push_back(positiveUpdate);
+				}
+				else
+				{
+					// the data point will be added as a new weight of its class
+					newWeights.push_back(t);
+				}
+			}
+		}
+		
+		// downgrade weights once per mini-batch, which only increases the degradation step counter of the model
+		(*model).downgrade(numSteps);
+		
+		// clone the winning weights before they are updated, as long as the budget allows it
+		for (unsigned int k = 0; k < clones.size(); k++)
+		{
+			i1 = clones[k].first;
+			if ((unsigned int)(*n)[i1] < (*param).BUDGET_SIZE)
+			{
+				budgetedVectorAMM *clonedVector = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
+				clonedVector->createVectorUsingVector((*((*model).getModel()))[i1][clones[k].second]);
+				
+				// add the new cloned weight to the model
+				(*((*model).getModel()))[i1].push_back(clonedVector);
+				(*n)[i1]++;
+				clonedVector = NULL;
+				
+				// update the clone probability after successful cloning
+				(*param).CLONE_PROBABILITY *= (*param).CLONE_PROBABILITY_DECAY;
+			}
+		}
+		clones.clear();
+		
+		// the updates use the non-zero features of the data points directly from the budgetedData
+		applyWeightUpdates(model, &updates, trainData, numSteps, numInBatch, param);
+		
+		// add the misclassified data points that had no positively scored weight of their class as new weights
+		for (unsigned int k = 0; k < newWeights.size(); k++)
+		{
+			t = newWeights[k];
+			i1 = trainData->al[t];
+			if ((*n)[i1] < (*param).BUDGET_SIZE) // limit number of weights (we found ~20 is a reasonable number per class)
+			{
+				currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
+				currentData->budgetedVector::createVectorUsingDataPoint(trainData, t, param);
+				
+				(*n)[i1]++;
+				currentData->updateDegradation(numSteps, param, (*model).getDegradationScale(), numInBatch);
+				(*((*model).getModel()))[i1].push_back(currentData);
+				(*counters).numNew++;
+				currentData = NULL;
+			}
+		}
+		newWeights.clear();
+		
+		// pruning phase, done whenever the number of processed examples reaches a multiple of the pruning frequency
+		if ((prune) && (((*counters).numIter / (*param).K_PARAM) != (((*counters).numIter - numInBatch) / (*param).K_PARAM)))
+		{
+			(*counters).numDeleted += pruneWeights(model, n, numSteps, param);
+		}
+	}
+}
+
+/* \fn unsigned int trimToBudget(budgetedModelAMM *model, vector <unsigned int> *n, parameters *param)
+	\brief Removes the weights with the smallest norms from each class of AMM model that holds more than \link parameters::BUDGET_SIZE \endlink weights.
+	\param [in,out] model Current AMM model.
+	\param [in,out] n Number of weights per class.
+	\param [in] param The parameters of the algorithm.
+	\return Number of removed weights.
+*/
+unsigned int trimToBudget(budgetedModelAMM *model, vector <unsigned int> *n, parameters *param)
+{
+	vector <vectorOfBudgetVectors> *weights = (*model).getModel();
+	vector <weightNorm> norms;
+	vector <bool> toDelete;
+	unsigned int i, j, numDeleted = 0, numKept;
+	weightNorm currNorm;
+	
+	(*model).resyncNorms(param);
+	for (i = 0; i < (*weights).size(); i++)
+	{
+		if ((*weights)[i].size() <= (*param).BUDGET_SIZE)
+			continue;
+		
+		// find the BUDGET_SIZE weights with the largest norms, all weights of a class share the degradation scale of the model
+		norms.clear();
+		for (j = 0; j < (*weights)[i].size(); j++)
+		{
+			currNorm.norm = (*weights)[i][j]->getSqrL2norm();
+			currNorm.classIndex = i;
+			currNorm.slot = j;
+			norms.push_back(currNorm);
+		}
+		nth_element(norms.begin(), norms.begin() + (*param).BUDGET_SIZE, norms.end(), largerWeightNorm());
+		toDelete.assign((*weights)[i].size(), false);
+		for (j = (*param).BUDGET_SIZE; j < norms.size(); j++)
+			toDelete[norms[j].slot] = true;
+		
+		numKept = 0;
+		for (j = 0; j < (*weights)[i].size(); j++)
+		{
+			if (toDelete[j])
+			{
+				delete (*weights)[i][j];
+				numDeleted++;
+			}
+			else
+				(*weights)[i][numKept++] = (*weights)[i][j];
+		}
+		(*weights)[i].resize(numKept);
+		(*n)[i] = numKept;
+	}
+	return numDeleted;
+}
+
+/* \fn void trainAMMonlineChunkParallel(budgetedData *trainData, vector <unsigned int> *tv, parameters *param, budgetedModelAMM *model, vector <unsigned int> *n, onlineCounters *counters)
+	\brief Runs AMM online over the loaded data chunk in parallel, by averaging the models trained by the threads on disjoint parts of the chunk.
+	\param [in] trainData Loaded training data chunk.
+	\param [in] tv Order in which the examples of the chunk are visited.
+	\param [in,out] param The parameters of the algorithm.
+	\param [in,out] model Current AMM model.
+	\param [in,out] n Number of weights per class.
+	\param [in,out] counters Training counters.
+	
+	The chunk is split into segments of \link parameters::SYNC_INTERVAL \endlink examples. For each segment, each of the K threads trains its own copy of the model 
+	on every K-th example of the segment, without pruning. The copies are then reconciled into a single model by averaging the weights that the copies inherited 
+	from the model, while the new and the cloned weights of the threads are all kept, as proposed for parallel training of linear models in "Parallelized Stochastic 
+	Gradient Descent" by Zinkevich et al. Finally the model is pruned if the pruning frequency was reached within the segment, and the classes with more than 
+	\link parameters::BUDGET_SIZE \endlink weights are trimmed to the budget by removing their weights with the smallest norms. 
+	
+	The threads draw their cloning decisions from their own random number generators, seeded from the shared generator before the threads are started, 
+	thus the learned model does not depend on the scheduling of the threads. 
+*/
+void trainAMMonlineChunkParallel(budgetedData *trainData, vector <unsigned int> *tv, parameters *param, budgetedModelAMM *model, vector <unsigned int> *n, onlineCounters *counters)
+{
+	unsigned int numThreads = getNumThreads(param), N = (unsigned int) (*tv).size(), segmentSize = ((*param).SYNC_INTERVAL > 0) ? (*param).SYNC_INTERVAL : N;
+	unsigned int segmentStart, segmentEnd, firstStep, i, j, k;
+	double cloneProbability;
+	
+	for (segmentStart = 0; segmentStart < N; segmentStart += segmentSize)
+	{
+		segmentEnd = ((N - segmentStart) < segmentSize) ? N : segmentStart + segmentSize;
+		firstStep = (*counters).numSteps + 1;
+		
+		// each thread trains its own copy of the model, with its own parameters as the clone probability is modified during training
+		vector <budgetedModelAMM*> localModels(numThreads);
+		vector < vector <unsigned int> > localN(numThreads, *n);
+		vector <parameters> localParams(numThreads, *param);
+		vector <onlineCounters> localCounters(numThreads);
+		vector <unsigned int> localSeeds(numThreads);
+		for (k = 0; k < numThreads; k++)
+		{
+			localSeeds[k] = (unsigned int) rand();
+			localModels[k] = new budgetedModelAMM();
+			for (i = 0; i < (*n).size(); i++)
+			{
+				vectorOfBudgetVectors classWeights;
+				for (j = 0; j < (*n)[i]; j++)
+				{
+					classWeights.push_back(new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT));
+					classWeights[j]->createVectorUsingVector((*((*model).getModel()))[i][j]);
+				}
+				(*(localModels[k]->getModel())).push_back(classWeights);
+			}
+			localModels[k]->downgrade(firstStep - 1);
+			
+			localParams[k].NUM_THREADS = 1;
+			localCounters[k].numIter = localCounters[k].numSteps = localCounters[k].numNew = localCounters[k].numDeleted = localCounters[k].numErrors = 0;
+		}
+		
+#ifdef _OPENMP
+		#pragma omp parallel for num_threads(numThreads) schedule(static, 1)
+#endif
+		for (int thread = 0; thread < (int) numThreads; thread++)
+		{
+			vector <unsigned int> stripe;
+			weightScorer scorer;
+			for (unsigned int ot = segmentStart + (unsigned int) thread; ot < segmentEnd; ot += numThreads)
+				stripe.push_back((*tv)[ot]);
+			
+			trainAMMonlineExamples(trainData, &stripe, firstStep + (unsigned int) thread, numThreads, &localParams[thread], localModels[thread], &localN[thread], &scorer, &localCounters[thread], false, &localSeeds[thread]);
+		}
+		
+		// the copies are degraded up to the last step of the segment before they are averaged
+		(*counters).numSteps = firstStep - 1 + segmentEnd - segmentStart;
+		cloneProbability = (*param).CLONE_PROBABILITY;
+		for (k = 0; k < numThreads; k++)
+		{
+			localModels[k]->downgrade((*counters).numSteps);
+			(*counters).numNew += localCounters[k].numNew;
+			(*counters).numErrors += localCounters[k].numErrors;
+			
+			// the clone probability decays by the clonings of all threads
+			if (cloneProbability > 0.0)
+				(*param).CLONE_PROBABILITY *= localParams[k].CLONE_PROBABILITY / cloneProbability;
+		}
+		(*model).averageModels(&localModels, n);
+		for (k = 0; k < numThreads; k++)
+			delete localModels[k];
+		for (i = 0; i < (*n).size(); i++)
+			(*n)[i] = (unsigned int) (*((*model).getModel()))[i].size();
+		
+		// pruning phase, done if the number of processed examples reached a multiple of the pruning frequency within the segment
+		(*counters).numIter += segmentEnd - segmentStart;
+		if (((*counters).numIter / (*param).K_PARAM) != (((*counters).numIter - (segmentEnd - segmentStart)) / (*param).K_PARAM))
+			(*counters).numDeleted += pruneWeights(model, n, (*counters).numSteps, param);
+		(*counters).numDeleted += trimToBudget(model, n, param);
+	}
+}
+
 } // end namespace
 
 /* \fn ~budgetedModelAMM(void)
@@ -62,6 +932,211 @@ budgetedModelAMM::~budgetedModelAMM(void)
 	}
 }
 
+/* \fn void budgetedModelAMM::packWeights(parameters *param)
+	\brief Builds packed weight matrix from the current weights of the model.
+	\param [in] param The parameters of the algorithm.
+	
+	Each weight becomes a column of a row-major matrix of size (DIMENSION x NUMBER_OF_WEIGHTS), while its degradation (together with the degradation scale of the model, if called during training) 
+	is kept per column and applied once to the computed score of the column.
+*/
+void budgetedModelAMM::packWeights(parameters *param)
+{
+	unsigned int i, j, k, l, column = 0, chunkSize;
+	long double degradationScale = getDegradationScale();
+	float *chunk = NULL;
+	
+	numPackedWeights = 0;
+	for (i = 0; i < (*modelMM).size(); i++)
+		numPackedWeights += (unsigned int) (*modelMM)[i].size();
+	
+	packedWeights.assign((unsigned long) (*param).DIMENSION * (unsigned long) numPackedWeights, 0.0f);
+	packedDegradations.resize(numPackedWeights);
+	for (i = 0; i < (*modelMM).size(); i++)
+	{
+		for (j = 0; j < (*modelMM)[i].size(); j++)
+		{
+			budgetedVectorAMM *currWeight = (*modelMM)[i][j];
+			packedDegradations[column] = (double) (currWeight->degradation * degradationScale);
+			
+			// only the allocated chunks of the weight have non-zero elements
+			for (k = 0; k < currWeight->arrayLength; k++)
+			{
+				chunk = currWeight->array[k];
+				if (chunk == NULL)
+					continue;
+				
+				chunkSize = currWeight->chunkWeight;
+				if ((k == currWeight->arrayLength - 1) && (currWeight->dimension % currWeight->chunkWeight != 0))
+					chunkSize = currWeight->dimension % currWeight->chunkWeight;
+				
+				for (l = 0; (l < chunkSize) && (k * currWeight->chunkWeight + l < (*param).DIMENSION); l++)
+					packedWeights[(unsigned long) (k * currWeight->chunkWeight + l) * numPackedWeights + column] = chunk[l];
+			}
+			column++;
+		}
+	}
+	packedWeightsValid = true;
+}
+
+/* \fn void budgetedModelAMM::computePackedScores(unsigned int t, budgetedData *inputData, parameters *param, vector <double> *weightScores)
+	\brief Computes the scores of all weights of the model for a data point, using packed weight matrix which is rebuilt first if the weights changed.
+	\param [in] t Index of the input vector in the input data.
+	\param [in] inputData Input data from which t-th vector is considered.
+	\param [in] param The parameters of the algorithm.
+	\param [out] weightScores Scores of all weights, ordered by class and by the index of the weight within the class.
+*/
+void budgetedModelAMM::computePackedScores(unsigned int t, budgetedData *inputData, parameters *param, vector <double> *weightScores)
+{
+	unsigned long pointIndexPointer = inputData->ai[t];
+	unsigned long maxPointIndex = ((t + 1) == inputData->N) ? inputData->aj.size() : inputData->ai[t + 1];
+	unsigned int idx, w;
+	char text[256];
+	
+	if (!packedWeightsValid)
+		packWeights(param);
+	
+	// the scores are accumulated in doubles, which the compiler can vectorize unlike long doubles
+	(*weightScores).assign(numPackedWeights, 0.0);
+	if (numPackedWeights == 0)
+		return;
+	double *scores = &(*weightScores)[0];
+	const float *row = NULL;
+	double value;
+	for (unsigned long i = pointIndexPointer; i < maxPointIndex; i++)
+	{
+		idx = inputData->aj[i] - 1;
+		if (idx >= (*param).DIMENSION)
+		{
+			sprintf(text, "Error, input vector is longer than the model weights, detected dimension %d in function computePackedScores(), check your input data.\n", idx + 1);
+			svmPrintErrorString(text);
+		}
+		
+		// add the contiguous row of the feature to the scores of all weights
+		row = &packedWeights[(unsigned long) idx * numPackedWeights];
+		value = (double) inputData->an[i];
+		for (w = 0; w < numPackedWeights; w++)
+			scores[w] += value * (double) row[w];
+	}
+	if ((*param).BIAS_TERM != 0)
+	{
+		row = &packedWeights[(unsigned long) ((*param).DIMENSION - 1) * numPackedWeights];
+		value = (double) (*param).BIAS_TERM;
+		for (w = 0; w < numPackedWeights; w++)
+			scores[w] += value * (double) row[w];
+	}
+	
+	// finally account for the degradation of each weight
+	for (w = 0; w < numPackedWeights; w++)
+		scores[w] *= packedDegradations[w];
+}
+
+/* \fn void budgetedModelAMM::averageModels(vector <budgetedModelAMM*> *models, vector <unsigned int> *numShared)
+	\brief Replaces the weights of the model by the average of several models, which were all trained starting from a copy of this model.
+	\param [in] models Models that are averaged, all with the same degradation scale.
+	\param [in] numShared Number of weights per class that the models inherited from this model, found at the start of the weights of each class.
+	
+	The degradations of the averaged weights are relative to the common degradation scale, so they are folded into the elements of the average, which is 
+	accumulated chunk by chunk in doubles and only then rounded to floats.
+*/
+void budgetedModelAMM::averageModels(vector <budgetedModelAMM*> *models, vector <unsigned int> *numShared)
+{
+	unsigned int i, j, k, c, l, chunkSize, numModels = (unsigned int) (*models).size();
+	long double modelShare = 1.0L / (long double) numModels, sqrNorm;
+	vector <double> sum;
+	
+	for (i = 0; i < (*modelMM).size(); i++)
+	{
+		// average the weights inherited by all models
+		for (j = 0; j < (*numShared)[i]; j++)
+		{
+			budgetedVectorAMM *averaged = (*modelMM)[i][j];
+			sum.assign(averaged->chunkWeight, 0.0);
+			sqrNorm = 0.0;
+			for (c = 0; c < averaged->arrayLength; c++)
+			{
+				// the last chunk might be smaller than the rest
+				chunkSize = averaged->chunkWeight;
+				if ((c == averaged->arrayLength - 1) && (averaged->dimension % averaged->chunkWeight != 0))
+					chunkSize = averaged->dimension % averaged->chunkWeight;
+				
+				bool nonZero = false;
+				for (k = 0; k < numModels; k++)
+				{
+					budgetedVectorAMM *currWeight = (*((*models)[k]->modelMM))[i][j];
+					if (currWeight->array[c] == NULL)
+						continue;
+					
+					double share = (double) (currWeight->degradation * modelShare);
+					for (l = 0; l < chunkSize; l++)
+						sum[l] += share * (double) currWeight->array[c][l];
+					nonZero = true;
+				}
+				
+				if (nonZero)
+				{
+					if (averaged->array[c] == NULL)
+						averaged->array[c] = new float[chunkSize];
+					for (l = 0; l < chunkSize; l++)
+					{
+						averaged->array[c][l] = (float) sum[l];
+						sqrNorm += (long double) averaged->array[c][l] * (long double) averaged->array[c][l];
+						sum[l] = 0.0;
+					}
+				}
+				else if (averaged->array[c] != NULL)
+				{
+					delete [] averaged->array[c];
+					averaged->array[c] = NULL;
+				}
+			}
+			averaged->setDegradation(1.0);
+			averaged->setSqrL2norm(sqrNorm);
+			averaged->numNormUpdates = 0;
+		}
+		
+		// add the weights created by a single model
+		for (k = 0; k < numModels; k++)
+		{
+			for (j = (*numShared)[i]; j < (*((*models)[k]->modelMM))[i].size(); j++)
+			{
+				budgetedVectorAMM *addedWeight = new budgetedVectorAMM((*((*models)[k]->modelMM))[i][j]->dimension, (*((*models)[k]->modelMM))[i][j]->chunkWeight);
+				addedWeight->createVectorUsingVector((*((*models)[k]->modelMM))[i][j]);
+				addedWeight->scaleDegradation(modelShare);
+				(*modelMM)[i].push_back(addedWeight);
+			}
+		}
+	}
+	
+	numDegradationSteps = (*models)[0]->numDegradationSteps;
+	packedWeightsValid = false;
+}
+
+/* \fn void budgetedModelAMM::resyncNorms(parameters *param)
+	\brief Recomputes the squared norms of the weights that were incrementally updated at least NORM_RESYNC_INTERVAL times since their norms were last computed.
+	\param [in] param The parameters of the algorithm.
+*/
+void budgetedModelAMM::resyncNorms(parameters *param)
+{
+	long double drift;
+	
+	if ((*param).NORM_RESYNC_INTERVAL == 0)
+		return;
+	
+	for (unsigned int i = 0; i < (*modelMM).size(); i++)
+	{
+		for (unsigned int j = 0; j < (*modelMM)[i].size(); j++)
+		{
+			if ((*modelMM)[i][j]->numNormUpdates < (*param).NORM_RESYNC_INTERVAL)
+				continue;
+			
+			drift = (*modelMM)[i][j]->resyncSqrL2norm();
+			if (drift > maxNormDrift)
+				maxNormDrift = drift;
+			numNormResyncs++;
+		}
+	}
+}
+
 /* \fn bool budgetedModelAMM::saveToTextFile(const char *filename, vector <int>* yLabels, parameters *param)
 	\brief Saves the trained AMM model to .txt file.
 	\param [in] filename Filename of the .txt file where the model is saved.
@@ -262,7 +1337,22 @@ bool budgetedModelAMM::loadFromTextFile(const char *filename, vector <int>* yLab
 	return true;
 }
 
-/* \fn void budgetedVectorAMM::updateUsingDataPoint(budgetedData* inputData, unsigned int oto, unsigned int t, int sign, parameters *param)
+/* \fn long double budgetedVectorAMM::resyncSqrL2norm(void)
+	\brief Recomputes \link sqrL2norm \endlink from the elements of the vector, discarding the round-off errors of the incremental updates.
+	\return Relative difference between the incrementally updated and the recomputed squared norm.
+*/
+long double budgetedVectorAMM::resyncSqrL2norm(void)
+{
+	long double exactNorm = budgetedVector::sqrNorm(), drift = fabs(sqrL2norm - exactNorm);
+	
+	if (exactNorm > 0.0)
+		drift /= exactNorm;
+	sqrL2norm = exactNorm;
+	numNormUpdates = 0;
+	return drift;
+}
+
+/* \fn void budgetedVectorAMM::updateUsingDataPoint(budgetedData* inputData, unsigned int oto, unsigned int t, int sign, parameters *param, long double degradationScale, unsigned int batchSize)
 	\brief Updates existing weight when misclassification happens.
 	\param [in,out] vij Existing weight that needs to be updated.
 	\param [in] inputData Input data from which t-th vector is considered.
@@ -270,47 +1360,59 @@ bool budgetedModelAMM::loadFromTextFile(const char *filename, vector <int>* yLab
 	\param [in] t Index of the input vector in the input data.
 	\param [in] sign +1 if the input vector is of the true class, -1 otherwise, specifies how the weights will be updated.
 	\param [in] param The parameters of the algorithm.
+	\param [in] degradationScale Current degradation scale of the model.
+	\param [in] batchSize Size of the mini-batch the data point belongs to.
 	
 	When we misclassify a data point during training, this function is used to update the existing weight-vector. It brings the true-class weight closer to the misclassified 
 	data point, and to push the winning other-class weight away from the misclassified point according to AMM weight-update equations. The missclassified example used to update
 	an existing weight is located in the input data set loaded to budgetedData.
 */
-void budgetedVectorAMM::updateUsingDataPoint(budgetedData* inputData, unsigned int oto, unsigned int t, int sign, parameters *param)
+void budgetedVectorAMM::updateUsingDataPoint(budgetedData* inputData, unsigned int oto, unsigned int t, int sign, parameters *param, long double degradationScale, unsigned int batchSize)
 {
 	unsigned long pointIndexPointer = inputData->ai[t];
 	unsigned long maxPointIndex = ((t + 1) == (unsigned int) inputData->ai.size()) ? (unsigned int) inputData->aj.size() : inputData->ai[t + 1];
 	
-	long double linKern = this->linearKernel(t, inputData, param);
-	long double divisor = (long double)sign * ((long double)oto + 1.0) * (long double)(*param).LAMBDA_PARAM * degradation;
+	long double divisor = (long double)sign * ((long double)oto + 1.0) * (long double)(*param).LAMBDA_PARAM * degradation * degradationScale * (long double)batchSize;
+	long double oldValue, sqrNormChange = 0.0;
 	for (unsigned long i = pointIndexPointer; i < maxPointIndex; i++)
 	{
-		((*this)[inputData->aj[i] - 1]) = (float)((long double)((*this)[inputData->aj[i] - 1]) + (long double)inputData->an[i] / divisor);
+		float &element = (*this)[inputData->aj[i] - 1];
+		oldValue = (long double) element;
+		element = (float)(oldValue + (long double)inputData->an[i] / divisor);
+		
+		// the norm changes only in the modified elements, so track it here instead of computing kernels with the data point
+		sqrNormChange += (long double)element * (long double)element - oldValue * oldValue;
 	}
     if ((*param).BIAS_TERM != 0)
 	{
-		((*this)[(*param).DIMENSION - 1]) = (float)((long double)((*this)[(*param).DIMENSION - 1]) + (long double)(*param).BIAS_TERM / divisor);
+		float &element = (*this)[(*param).DIMENSION - 1];
+		oldValue = (long double) element;
+		element = (float)(oldValue + (long double)(*param).BIAS_TERM / divisor);
+		sqrNormChange += (long double)element * (long double)element - oldValue * oldValue;
 	}
 	
-	this->sqrL2norm += (long double)inputData->getVectorSqrL2Norm(t, param) / (divisor * divisor) + 2.0L / (divisor * this->degradation) * linKern;
+	this->sqrL2norm += sqrNormChange;
+	numNormUpdates++;
 }
 
-/* \fn void budgetedVectorAMM::updateUsingVector(budgetedVectorAMM* otherVector, unsigned int oto, int sign, parameters *param)
+/* \fn void budgetedVectorAMM::updateUsingVector(budgetedVectorAMM* otherVector, unsigned int oto, int sign, parameters *param, long double degradationScale)
 	\brief Updates a weight-vector when misclassification happens.
 	\param [in] otherVector Misclassified example used to update the existing weight.
 	\param [in] oto Total number of iterations so far.
 	\param [in] sign +1 if the input vector is of the true class, -1 otherwise, specifies how the weights will be updated.
 	\param [in] param The parameters of the algorithm.
+	\param [in] degradationScale Current degradation scale of the model.
 	
 	When we misclassify a data point during training, this function is used to update the existing weight-vector. It brings the true-class weight closer to the misclassified 
 	data point, and to push the winning other-class weight away from the misclassified point according to AMM weight-update equations. The missclassified example used to update
 	an existing weight is located in the budgetedVectorAMM object.
 */
-void budgetedVectorAMM::updateUsingVector(budgetedVectorAMM* otherVector, unsigned int oto, int sign, parameters *param)
+void budgetedVectorAMM::updateUsingVector(budgetedVectorAMM* otherVector, unsigned int oto, int sign, parameters *param, long double degradationScale)
 {
 	unsigned long chunkSize = chunkWeight;
 	unsigned int i, j;
 	float *tempArray = NULL;
-	long double divisor = (long double)sign * ((long double)oto + 1.0) * (long double)(*param).LAMBDA_PARAM * degradation;
+	long double divisor = (long double)sign * ((long double)oto + 1.0) * (long double)(*param).LAMBDA_PARAM * degradation * degradationScale;
 	long double linKern = this->linearKernel(otherVector);
 	for (i = 0; i < arrayLength; i++)
 	{
@@ -342,6 +1444,7 @@ void budgetedVectorAMM::updateUsingVector(budgetedVectorAMM* otherVector, unsign
 	}
 	
 	sqrL2norm += (long double)otherVector->getSqrL2norm() / (divisor * divisor) + 2.0L / (divisor * this->degradation) * linKern;
+	numNormUpdates++;
 }
 
 /* \fn float predictAMM(budgetedData *testData, parameters *param, budgetedModelAMM *model, vector <int> *labels, vector <float> *scores)
@@ -364,6 +1467,8 @@ float predictAMM(budgetedData *testData, parameters *param, budgetedModelAMM *mo
 	char text[1024];
 	budgetedVectorAMM *currentData = NULL;
 	long double *classMaxScores = new long double[(testData->yLabels).size()];
+	vector <double> weightScores;
+	unsigned int column;
 	
 	while (stillChunksLeft)
 	{ 
@@ -378,7 +1483,29 @@ float predictAMM(budgetedData *testData, parameters *param, budgetedModelAMM *mo
     		unsigned int y = 0;
     		maxFx = -INF;
 			
-			if ((*param).VERY_SPARSE_DATA)
+			if ((*param).PACKED_WEIGHTS)
+			{
+				// compute the scores of all weights at once using the packed weight matrix of the model
+				(*model).computePackedScores(r, testData, param, &weightScores);
+				column = 0;
+				for (unsigned int i = 0; i < (testData->yLabels).size(); i++)
+				{
+					classMaxScores[i] = -INF;
+					for (unsigned int j = 0; j < (*(model->getModel()))[i].size(); j++)
+					{
+						fx = (long double) weightScores[column++];
+						if (fx > maxFx)
+						{
+							maxFx = fx;
+							y = i;
+						}
+						
+						if (fx > classMaxScores[i])
+							classMaxScores[i] = fx;
+					}
+				}
+			}
+			else if ((*param).VERY_SPARSE_DATA)
 			{
 				// compute kernels using vectors directly from the budgetedData				
 				for (unsigned int i = 0; i < (testData->yLabels).size(); i++)
@@ -476,16 +1603,23 @@ float predictAMM(budgetedData *testData, parameters *param, budgetedModelAMM *mo
 */
 void trainPegasos(budgetedData *trainData, parameters *param, budgetedModelAMM *model)
 {
-	unsigned int sizeOfyLabels = 0, numIter = 0, t, i1, i2 = 0, N, temp;
-	unsigned long timeCalc = 0, start;
+	unsigned int sizeOfyLabels = 0, numIter = 0, numSteps = 0, numInBatch = 0, batchSize = (*param).MINI_BATCH_SIZE, t, i1, i2 = 0, N, temp;
+	unsigned int epochErrors, epochStartIter;
+	unsigned long timeCalc = 0, start, epochStartTime;
 	long double fx, fx1, fx2, maxFx;
 	bool stillChunksLeft = true;
 	char text[1024];
 	budgetedVectorAMM *currentData = NULL;
+	vector <unsigned int> n;
+	vector <weightUpdate> updates;
+	weightScorer scorer((batchSize > 1) && (*param).PACKED_WEIGHTS);
 	
 	// train the model
 	for (unsigned int epoch = 0; epoch < (*param).NUM_EPOCHS; epoch++)
 	{
+		epochErrors = 0;
+		epochStartIter = numIter;
+		epochStartTime = timeCalc;
 		stillChunksLeft = true;
 		while (stillChunksLeft)
 		{ 
@@ -515,6 +1649,8 @@ void trainPegasos(budgetedData *trainData, parameters *param, budgetedModelAMM *
 				sizeOfyLabels = (unsigned int) trainData->yLabels.size();
 				for (unsigned int i = 0; i < sizeOfyLabels; i++)
 				{
+					n.push_back(1);
+					
 					currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
 					vector <budgetedVectorAMM*> perClassWeights;
 					perClassWeights.push_back(currentData);
@@ -527,6 +1663,8 @@ void trainPegasos(budgetedData *trainData, parameters *param, budgetedModelAMM *
 				// if in the chunks before some class wasn't observed add it here; could happen with small chunks or unbalanced classes
 				for (unsigned int i = 0; i < (trainData->yLabels.size() - sizeOfyLabels); i++)
 				{
+					n.push_back(1);
+					
 					currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
 					vector <budgetedVectorAMM*> perClassWeights;
 					perClassWeights.push_back(currentData);
@@ -547,75 +1685,82 @@ void trainPegasos(budgetedData *trainData, parameters *param, budgetedModelAMM *
 				random_shuffle(tv.begin(), tv.end());
         	
             start = clock();
-            for (unsigned int ot = 0; ot < N; ot++)
-            {
-				numIter++;
-                t = tv[ot];
-				
-    			i1 = trainData->al[t];
-				if ((*param).VERY_SPARSE_DATA)
-				{
-					// compute kernels using vectors directly from the budgetedData
-					fx1 = (*((*model).getModel()))[i1][0]->linearKernel(t, trainData, param);
-				}
-				else
+			if ((*param).PARALLEL_TRAINING)
+			{
+				// Hogwild-style training, where the threads update the shared weights without locking
+				epochErrors += trainPegasosChunkParallel(trainData, &tv, param, model, &numIter);
+			}
+			else
+			{
+				for (unsigned int ob = 0; ob < N; ob += numInBatch)
 				{
-					// first create the budgetedVector using the vector from budgetedData, to be used in linearKernel() method below
-					currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
-					currentData->budgetedVector::createVectorUsingDataPoint(trainData, t, param);
+					// the examples of a mini-batch are all scored against the model as it was at the start of the mini-batch
+					numInBatch = ((N - ob) < batchSize) ? (N - ob) : batchSize;
+					numSteps++;
+					for (unsigned int ot = ob; ot < ob + numInBatch; ot++)
+					{
+						numIter++;
+						t = tv[ot];
 					
-					fx1 = (*((*model).getModel()))[i1][0]->linearKernel(currentData);
-				}
-    			    
-    			//calculate i-, fi-
-    			fx = 0;
-    			maxFx = -INF;
-    			for (unsigned int i = 0; i < sizeOfyLabels; i++)
-    			{
-    				if (i == i1)
-    					continue;
+						if ((!(*param).VERY_SPARSE_DATA) && (!scorer.usePackedWeights))
+						{
+							// first create the budgetedVector using the vector from budgetedData, to be used in linearKernel() method below
+							currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
+							currentData->budgetedVector::createVectorUsingDataPoint(trainData, t, param);
+						}
 					
-					if ((*param).VERY_SPARSE_DATA)
-						fx = (*((*model).getModel()))[i][0]->linearKernel(t, trainData, param);
-					else
-						fx = (*((*model).getModel()))[i][0]->linearKernel(currentData);
-    				
-					if (fx > maxFx)
-    				{
-    					maxFx = fx;
-    					i2 = i;
-    				}
-    			}
-    			fx2 = maxFx;
-    
-    			// downgrade the weights
-				for (unsigned int i = 0; i < sizeOfyLabels; i++)
-				{
-					(*((*model).getModel()))[i][0]->downgrade(numIter);
-				}
-    
-    			// calculate the margin, if misclassified update weights
-    			if (1.0L + fx2 - fx1 > 0.0L)
-    			{
-					if ((*param).VERY_SPARSE_DATA)
-					{
-						(*((*model).getModel()))[i2][0]->updateUsingDataPoint(trainData, numIter, t, -1, param);
-						(*((*model).getModel()))[i1][0]->updateUsingDataPoint(trainData, numIter, t, 1, param);
-					}
-					else
-					{
-						(*((*model).getModel()))[i2][0]->updateUsingVector(currentData, numIter, -1, param);
-						(*((*model).getModel()))[i1][0]->updateUsingVector(currentData, numIter, 1, param);
+						// score the weights of all classes, in parallel if the model is large enough
+						scorer.computeScores(model, &n, t, trainData, currentData, param);
+					
+						i1 = trainData->al[t];
+						fx1 = scorer.getScore(i1, 0);
+					
+						//calculate i-, fi-
+						fx = 0;
+						maxFx = -INF;
+						for (unsigned int i = 0; i < sizeOfyLabels; i++)
+						{
+							if (i == i1)
+								continue;
+						
+							fx = scorer.getScore(i, 0);
+							if (fx > maxFx)
+							{
+								maxFx = fx;
+								i2 = i;
+							}
+						}
+						fx2 = maxFx;
+					
+						// the scores were computed from weight degradations that are relative to the degradation scale of the model
+						fx1 *= (*model).getDegradationScale();
+						fx2 *= (*model).getDegradationScale();
+						if (fx2 >= fx1)
+							epochErrors++;
+					
+						// calculate the margin, if misclassified record the updates of the weights, applied at the end of the mini-batch
+						if (1.0L + fx2 - fx1 > 0.0L)
+						{
+							weightUpdate negativeUpdate = {i2, 0, t, -1}, positiveUpdate = {i1, 0, t, 1};
+							updates.push_back(negativeUpdate);
+							updates.push_back(positiveUpdate);
+						}
+					
+						if (currentData)
+						{
+							// for sparse data or the packed weight matrix there is no need for this part, since we didn't even create currentData
+							delete currentData;
+							currentData = NULL;
+						}
 					}
-    			}
 				
-				if (!(*param).VERY_SPARSE_DATA)
-				{
-					// if sparse data then no need for this part, since we didn't even create currentData
-					delete currentData;
-					currentData = NULL;
+					// downgrade the weights once per mini-batch, which only increases the degradation step counter of the model
+					(*model).downgrade(numSteps);
+				
+					// update only the non-zero features of the data points, taken directly from the budgetedData
+					applyWeightUpdates(model, &updates, trainData, numSteps, numInBatch, param);
 				}
-            }
+			}
             timeCalc += clock() - start;
 			
 			if (((*param).VERBOSE) && (N > 0))
@@ -626,11 +1771,10 @@ void trainPegasos(budgetedData *trainData, parameters *param, budgetedModelAMM *
 		}
 		
 		if ((*param).VERBOSE && ((*param).NUM_EPOCHS > 1))
-		{
-			sprintf(text, "Epoch %d/%d done.\n", epoch + 1, (*param).NUM_EPOCHS);
-			svmPrintString(text);
-		}
+			reportEpoch(epoch, numIter - epochStartIter, epochErrors, timeCalc - epochStartTime, param);
 	}
+	// fold the degradation scale of the model into the weights, after which the weights can be used outside of training
+	(*model).applyDegradationScale();
 	trainData->flushData();
 	
 	if ((*param).VERBOSE)
@@ -651,16 +1795,20 @@ void trainPegasos(budgetedData *trainData, parameters *param, budgetedModelAMM *
 void trainAMMonline(budgetedData *trainData, parameters *param, budgetedModelAMM *model)
 {	
 	vector <unsigned int> n;
-	unsigned long timeCalc = 0, start; 
-	long double fx1, fx2, maxFx;
-	unsigned int sizeOfyLabels = 0, countNew = 0, countDel = 0, numIter = 0, i1, i2, j1, j2, t, N, temp;
+	unsigned long timeCalc = 0, start, epochStartTime; 
+	unsigned int sizeOfyLabels = 0, N, temp, epochStartIter, epochStartErrors;
 	bool stillChunksLeft = true;
 	char text[1024];	
 	budgetedVectorAMM *currentData = NULL;
+	weightScorer scorer(((*param).MINI_BATCH_SIZE > 1) && (*param).PACKED_WEIGHTS);
+	onlineCounters counters = {0, 0, 0, 0, 0};
 	
 	// train the model
 	for (unsigned int epoch = 0; epoch < (*param).NUM_EPOCHS; epoch++)
 	{
+		epochStartErrors = counters.numErrors;
+		epochStartIter = counters.numIter;
+		epochStartTime = timeCalc;
 		stillChunksLeft = true;
 		while (stillChunksLeft)
 		{
@@ -684,7 +1832,7 @@ void trainAMMonline(budgetedData *trainData, parameters *param, budgetedModelAMM
 			}
 			
             N = trainData->N;			
-			if (numIter == 0)
+			if (counters.numIter == 0)
 			{
 				// initialize the model with zero weights
 				sizeOfyLabels = (unsigned int) trainData->yLabels.size();
@@ -704,6 +1852,8 @@ void trainAMMonline(budgetedData *trainData, parameters *param, budgetedModelAMM
 				// if in the chunks before some class wasn't observed, could happen with small chunks or unbalanced classes
 				for (unsigned int i = 0; i < (trainData->yLabels.size() - sizeOfyLabels); i++)
 				{
+					n.push_back(1);
+
 					currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
 					vector <budgetedVectorAMM*> perClassWeights;
 					perClassWeights.push_back(currentData);
@@ -723,223 +1873,31 @@ void trainAMMonline(budgetedData *trainData, parameters *param, budgetedModelAMM
 				random_shuffle(tv.begin(), tv.end());
         	
             start = clock();
-            for (unsigned int ot = 0; ot < N; ot++)
-            {    
-				numIter++;
-    			t = tv[ot];
-				
-				if (!(*param).VERY_SPARSE_DATA)
-				{
-					// only create currentData if the data is non-sparse, otherwise kernels will be computed directly from trainData
-					currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
-					currentData->budgetedVector::createVectorUsingDataPoint(trainData, t, param);
-				}
-				
-                //calculate i+,j+
-    			i1 = trainData->al[t];
-    			j1 = 0;
-    			maxFx = -INF;
-    			
-    			for (unsigned int j = 0; j < n[i1]; j++)
-    			{
-					if ((*param).VERY_SPARSE_DATA)
-						fx1 = (*((*model).getModel()))[i1][j]->linearKernel(t, trainData, param);
-					else
-						fx1 = (*((*model).getModel()))[i1][j]->linearKernel(currentData);
-					
-    				if (fx1 > maxFx)
-    				{
-    					j1 = j;
-    					maxFx = fx1;
-    				}
-    			}
-    			fx1 = maxFx;
-				
-    			// calculate i-, j-
-    			i2 = 0;
-    			j2 = 0;
-    			fx2 = 0;
-    			maxFx = -INF;
-    			for (unsigned int i = 0; i < sizeOfyLabels; i++)
-    			{
-    				if (i == i1)
-    					continue;
-    					
-    				for (unsigned int j = 0; j < n[i]; j++)
-    				{
-						if ((*param).VERY_SPARSE_DATA)
-							fx2 = (*((*model).getModel()))[i][j]->linearKernel(t, trainData, param);
-						else
-							fx2 = (*((*model).getModel()))[i][j]->linearKernel(currentData);
-						
-    					if (fx2 > maxFx)
-    					{
-    						maxFx = fx2;
-    						i2 = i;
-    						j2 = j;
-    					}
-    				}
-    			}    	        
-    			fx2 = maxFx;
-    
-    			// downgrade weights each iteration
-				for (unsigned int i = 0; i < sizeOfyLabels; i++)
-					for (unsigned int j = 0; j < n[i]; j++)
-						(*((*model).getModel()))[i][j]->downgrade(numIter);
-				
-    			if (1.0 + fx2 - fx1 > 0.0)
-    			{
-					// we made a misprediction, push negative class further away, and positive closer!					
-					if ((*param).VERY_SPARSE_DATA)
-					{
-						// since we did not create currentData earlier, here we create it to perform updates
-						currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
-						currentData->budgetedVector::createVectorUsingDataPoint(trainData, t, param);
-					}
-					
-					// push the other class further away
-					(*((*model).getModel()))[i2][j2]->updateUsingVector(currentData, numIter, -1, param);
-					
-					// update the true class weight
-					if (fx1 > 0.0)
-    				{
-						// here clone the best weight if the cloning probability allows it
-						if ((unsigned int)n[i1] < (*param).BUDGET_SIZE)
-						{
-							if ((*param).CLONE_PROBABILITY > get_random_probability())
-							{
-								// clone the winning weight
-								budgetedVectorAMM *clonedVector = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
-								clonedVector->createVectorUsingVector((*((*model).getModel()))[i1][j1]);
-
-								// add the new cloned weight to the model
-								(*((*model).getModel()))[i1].push_back(clonedVector);
-								n[i1]++;
-								clonedVector = NULL;
-
-								// update the clone probability after successful cloning
-								(*param).CLONE_PROBABILITY *= (*param).CLONE_PROBABILITY_DECAY;
-							}
-						}
-
-						(*((*model).getModel()))[i1][j1]->updateUsingVector(currentData, numIter, 1, param);
-						
-						delete currentData;
-						currentData = NULL;
-    				} 
-                    else 
-                    {                         
-						if (n[i1] < (*param).BUDGET_SIZE) // limit number of weights (we found ~20 is a reasonable number per class)
-						{
-        					n[i1]++;                            
-        					currentData->updateDegradation(numIter, param);                            
-        					(*((*model).getModel()))[i1].push_back(currentData);                            
-        					countNew++;							
-							currentData = NULL;
-                        }
-						else
-						{
-							delete currentData;
-							currentData = NULL;
-						}
-    				}					
-    			}
-				else
-				{
-					if (!(*param).VERY_SPARSE_DATA)
-					{
-						// if sparse data then no need for this part, since we didn't even create currentData
-						delete currentData;
-						currentData = NULL;
-					}
-				}
-    	        
-    			// pruning phase
-    			if (numIter % (int)(*param).K_PARAM == 0)
-    			{
-                    long double sumNorms = 0, sumThreshold = (long double)(*param).C_PARAM * (long double)(*param).C_PARAM / ((long double)numIter * (long double)numIter * (*param).LAMBDA_PARAM * (*param).LAMBDA_PARAM);              
-                    vector <long double> weightNorms, sortedWeightNorms;
-                    int numToDelete = 0; 
-                    
-                    // first find the norms of weights   
-        			for (unsigned int i = 0; i < sizeOfyLabels; i++)
-					{
-        				for (vector<budgetedVectorAMM*>::iterator vi = (*((*model).getModel()))[i].begin(); vi != (*((*model).getModel()))[i].end(); vi++)
-						{
-							weightNorms.push_back((double) (*(*vi)).getSqrL2norm());
-						}
-					}
-					
-        			// now sort them
-        			sortedWeightNorms = weightNorms;
-        			sort(sortedWeightNorms.begin(), sortedWeightNorms.end()); 
-        			    
-        			// find how many before threshold exceeded
-                    for (unsigned int i = 0; i < weightNorms.size(); i++)
-                    {
-                        sumNorms += sortedWeightNorms[i];
-                        if (sumNorms > sumThreshold)
-                           break;
-                        else
-                           numToDelete++;                             
-                    }
-                    
-                    // delete those that should be deleted
-                    int counter = 0;
-                    bool deleted = false;
-                    for (unsigned int i = 0; i < sizeOfyLabels; i++)
-    				{
-    					for (vector<budgetedVectorAMM*>::iterator vi = (*((*model).getModel()))[i].begin(); vi != (*((*model).getModel()))[i].end();)
-                        {
-                            long double currNorm = weightNorms[counter++];
-                            
-                            deleted = false;
-                            for (int j = 0; j < numToDelete; j++)
-                            {
-                                if (currNorm == sortedWeightNorms[j])
-                                {
-									if (n[i] == 1)
-									{
-										svmPrintString("Was about to delete all weights of a class, check K_PARAM and C_PARAM parameters!\n");
-										break;
-									}
-									
-                                    delete (*vi);
-                                    vi = (*((*model).getModel()))[i].erase(vi);
-        							n[i]--;
-									
-                                    countDel++;
-        							deleted = true;
-        							break;
-                                }
-                            }
-                            
-                            if (!deleted)
-								vi++;
-    					}
-    				}
-    			}
-    		}
+			if ((*param).PARALLEL_TRAINING)
+				trainAMMonlineChunkParallel(trainData, &tv, param, model, &n, &counters);
+			else
+				trainAMMonlineExamples(trainData, &tv, counters.numSteps + 1, 1, param, model, &n, &scorer, &counters, true);
     		timeCalc += clock() - start; 
 			
 			if (((*param).VERBOSE) && (N > 0))
 			{
-				sprintf(text, "Number of examples processed: %d\n", numIter);
+				sprintf(text, "Number of examples processed: %d\n", counters.numIter);
 				svmPrintString(text);
             }
         }
 		
 		if ((*param).VERBOSE && ((*param).NUM_EPOCHS > 1))
-		{
-			sprintf(text, "Epoch %d/%d done.\n", epoch + 1, (*param).NUM_EPOCHS);
-			svmPrintString(text);
-		}
+			reportEpoch(epoch, counters.numIter - epochStartIter, counters.numErrors - epochStartErrors, timeCalc - epochStartTime, param);
 	}
+	// fold the degradation scale of the model into the weights, after which the weights can be used outside of training
+	(*model).applyDegradationScale();
 	trainData->flushData();
 
     if ((*param).VERBOSE)
     {
-		sprintf(text, "*** Training completed in %5.3f seconds.\nNumber of weights deleted: %d\n", (double)timeCalc / (double)CLOCKS_PER_SEC, countDel);
+		sprintf(text, "*** Training completed in %5.3f seconds.\nNumber of weights deleted: %d\n", (double)timeCalc / (double)CLOCKS_PER_SEC, counters.numDeleted);
+		svmPrintString(text);
+		sprintf(text, "Number of recomputed weight norms: %d, largest relative norm drift: %.3g\n", (*model).getNumNormResyncs(), (double) (*model).getMaxNormDrift());
 		svmPrintString(text);
 		for (unsigned int i = 0; i < sizeOfyLabels; i++)
 		{
@@ -962,7 +1920,9 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
 	vector <unsigned int> n;	// stores number of weights per class
 	unsigned long timeCalc = 0, start;
 	long double fx1, fx2, maxFx, assocFx;
-	unsigned int i, j, t, N, i1, i2, j1, j2, sizeOfyLabels = 0, countNew = 0, countDel = 0, numIter = 0, currAssign = 0, currAssignID, temp;
+	unsigned int i, j, t, N, i1, i2, j1, j2, sizeOfyLabels = 0, countNew = 0, countDel = 0, numIter = 0, currAssign = 0, currAssignID, assignedClass, temp;
+	weightSlotIndex slotIndex;
+	weightScorer scorer;
 	bool stillChunksLeft;
 	char text[1024];
     budgetedVectorAMM *currentData = NULL;
@@ -999,7 +1959,7 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
 			{
 				n.push_back(1);
 
-				currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_SIZE);
+				currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
 				vector <budgetedVectorAMM*> perClassWeights;
 				perClassWeights.push_back(currentData);
 				currentData = NULL;
@@ -1044,17 +2004,16 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
 				currentData->budgetedVector::createVectorUsingDataPoint(trainData, t, param);
 			}
 			
+			// score all weights of the model, in parallel if the model is large enough
+			scorer.computeScores(model, &n, t, trainData, currentData, param);
+			
     		// calculate i+, j+
     		i1 = trainData->al[t];
     		j1 = 0;
     		maxFx = -INF;
     		for (j = 0; j < n[i1]; j++)
     		{
-				if ((*param).VERY_SPARSE_DATA)
-					fx1 = (*((*model).getModel()))[i1][j]->linearKernel(t, trainData, param);
-				else
-					fx1 = (*((*model).getModel()))[i1][j]->linearKernel(currentData);
-				
+				fx1 = scorer.getScore(i1, j);
     			if (fx1 > maxFx)
     			{
     				j1 = j;
@@ -1076,11 +2035,7 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
     				
     			for (j = 0; j < n[i]; j++)
     			{
-					if ((*param).VERY_SPARSE_DATA)
-						fx2 = (*((*model).getModel()))[i][j]->linearKernel(t, trainData, param);
-					else
-						fx2 = (*((*model).getModel()))[i][j]->linearKernel(currentData);
-					
+					fx2 = scorer.getScore(i, j);
     				if (fx2 > maxFx)
     				{
     					maxFx = fx2;
@@ -1090,24 +2045,19 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
     			}
     		}
     		fx2 = maxFx;
+			
+			// the scores were computed from weight degradations that are relative to the degradation scale of the model
+			fx1 *= (*model).getDegradationScale();
+			fx2 *= (*model).getDegradationScale();
     
-    		// downgrade weight each iteration
-			for (i = 0; i < sizeOfyLabels; i++)
-				for (j = 0; j < n[i]; j++)
-					(*((*model).getModel()))[i][j]->downgrade(numIter);
+    		// downgrade weight each iteration, which only increases the degradation step counter of the model
+			(*model).downgrade(numIter);
 			
     		if (1.0 + fx2 - fx1 > 0.0)
     		{
 				// we made a misprediction, push negative class further away, and positive closer!
-				if ((*param).VERY_SPARSE_DATA)
-				{
-					// since we did not create currentData earlier, here we create it to perform updates
-					currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
-					currentData->budgetedVector::createVectorUsingDataPoint(trainData, t, param);
-				}
-				
-				// push the other class further away
-    			(*((*model).getModel()))[i2][j2]->updateUsingVector(currentData, numIter, -1, param);
+				//	the updates use the non-zero features of the data point directly from the budgetedData
+    			(*((*model).getModel()))[i2][j2]->updateUsingDataPoint(trainData, numIter, t, -1, param, (*model).getDegradationScale());
 				
 				// update the true class weight
     			if (fx1 > 0.0)
@@ -1131,7 +2081,7 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
 						}
 					}
 
-    				(*((*model).getModel()))[i1][j1]->updateUsingVector(currentData, numIter, 1, param);
+    				(*((*model).getModel()))[i1][j1]->updateUsingDataPoint(trainData, numIter, t, 1, param, (*model).getDegradationScale());
 					
 					delete currentData;
 					currentData = NULL;
@@ -1140,8 +2090,15 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
                 {
     				if ((unsigned int) n[i1] < (*param).BUDGET_SIZE)
                     {
+						if ((*param).VERY_SPARSE_DATA)
+						{
+							// since we did not create currentData earlier, here we create it to be added as a new weight
+							currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
+							currentData->budgetedVector::createVectorUsingDataPoint(trainData, t, param);
+						}
+						
                         n[i1]++;
-        				currentData->updateDegradation(numIter, param);
+        				currentData->updateDegradation(numIter, param, (*model).getDegradationScale());
         				(*((*model).getModel()))[i1].push_back(currentData);
         				currentData = NULL;
         				countNew++;
@@ -1180,6 +2137,11 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
     
 	// end of init phase, start AMM algorithm below
 	
+	// index the weights by their IDs, used to find the weights assigned to training examples
+	for (i = 0; i < sizeOfyLabels; i++)
+		for (j = 0; j < n[i]; j++)
+			slotIndex.setSlot((*((*model).getModel()))[i][j]->getID(), i, j);
+	
 	for (unsigned int epoch = 1; epoch <= (*param).NUM_EPOCHS; epoch++)
 	{
 		stillChunksLeft = true;
@@ -1234,30 +2196,28 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
     			currAssignID = trainData->assignments[t];
     			
     			maxFx = 0;
-    			assocFx = -INF;
+				
+				// score all weights of the model, in parallel if the model is large enough
+				scorer.computeScores(model, &n, t, trainData, currentData, param);
     			for (j = 0; j < n[i1]; j++)
     			{
-					if ((*param).VERY_SPARSE_DATA)
-						fx1 = (*((*model).getModel()))[i1][j]->linearKernel(t, trainData, param);
-					else
-						fx1 = (*((*model).getModel()))[i1][j]->linearKernel(currentData);
-					
+					fx1 = scorer.getScore(i1, j);
     				if ((maxFx == 0) || (fx1 > maxFx))
     				{
     					j1 = j;
     					maxFx = fx1;
     				}
-    				
-    				// this is the prediction of the associated same-label weight
-    				if ((*((*model).getModel()))[i1][j]->getID() == currAssignID)
-    				{
-                       currAssign = j;
-                       assocFx = fx1;
-                    }
     			}
-    			
     			fx1 = maxFx;
-    			if (assocFx == -INF)
+				
+				// this is the prediction of the associated same-label weight, found through the index; if the associated weight
+				//	was pruned in the meantime, then the index resolves it to the weight that replaced it, and the assignment is rewritten
+				if (slotIndex.find(&currAssignID, &assignedClass, &currAssign) && (assignedClass == i1))
+				{
+					trainData->assignments[t] = currAssignID;
+					assocFx = scorer.getScore(i1, currAssign);
+				}
+				else
  			    {
                     assocFx = maxFx;
                     currAssign = j1;                             
@@ -1275,11 +2235,7 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
     					
     				for (j = 0; j < n[i]; j++)
     				{
-						if ((*param).VERY_SPARSE_DATA)
-							fx2 = (*((*model).getModel()))[i][j]->linearKernel(t, trainData, param);
-						else
-							fx2 = (*((*model).getModel()))[i][j]->linearKernel(currentData);
-						
+						fx2 = scorer.getScore(i, j);
     					if ((maxFx == 0) || (fx2 > maxFx))
     					{
     						maxFx = fx2;
@@ -1289,28 +2245,20 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
     				}
     			}    			
     			fx2 = maxFx;
+				
+				// the scores were computed from weight degradations that are relative to the degradation scale of the model
+				fx1 *= (*model).getDegradationScale();
+				fx2 *= (*model).getDegradationScale();
+				assocFx *= (*model).getDegradationScale();
     			
-    			// downgrade weights each iteration
-				for (unsigned int i = 0; i < sizeOfyLabels; i++)
-				{
-					for (unsigned int j = 0; j < n[i]; j++)
-					{
-						(*((*model).getModel()))[i][j]->downgrade(numIter);
-					}
-				}
+    			// downgrade weights each iteration, which only increases the degradation step counter of the model
+				(*model).downgrade(numIter);
 				
     			// calculate v
     			if (1.0 + fx2 - assocFx > 0.0)
     			{
 					// we made a misprediction, update the weights by pushing the wrong-class weight further from the misclassified
-					//	example, and the true-class closer to the misclassified example
-					if ((*param).VERY_SPARSE_DATA)
-					{
-						// since we did not create currentData earlier, here we create it to perform updates
-						currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
-						currentData->budgetedVector::createVectorUsingDataPoint(trainData, t, param);
-					}
-					
+					//	example, and the true-class closer to the misclassified example; the updates use the non-zero features of the data point directly from the budgetedData
 					// duplicate the assigned true-class weight if the cloning probability allows it
 					if ((assocFx > 0.0) && ((unsigned int)n[i1] < (*param).BUDGET_SIZE))
 					{
@@ -1322,6 +2270,7 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
 
 							// add the new cloned weight to the model
 							(*((*model).getModel()))[i1].push_back(clonedVector);
+							slotIndex.setSlot(clonedVector->getID(), i1, n[i1]);
 							n[i1]++;
 							clonedVector = NULL;
 
@@ -1330,13 +2279,21 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
 						}
 					}
 
-					(*((*model).getModel()))[i1][currAssign]->updateUsingVector(currentData, numIter, 1, param);
-					(*((*model).getModel()))[i2][j2]->updateUsingVector(currentData, numIter, -1, param);
+					(*((*model).getModel()))[i1][currAssign]->updateUsingDataPoint(trainData, numIter, t, 1, param, (*model).getDegradationScale());
+					(*((*model).getModel()))[i2][j2]->updateUsingDataPoint(trainData, numIter, t, -1, param, (*model).getDegradationScale());
     				if ((fx1 <= 0.0) && (n[i1] < (*param).BUDGET_SIZE))
                     {
+						if ((*param).VERY_SPARSE_DATA)
+						{
+							// since we did not create currentData earlier, here we create it to be added as a new weight
+							currentData = new budgetedVectorAMM((*param).DIMENSION, (*param).CHUNK_WEIGHT);
+							currentData->budgetedVector::createVectorUsingDataPoint(trainData, t, param);
+						}
+						
 						n[i1]++;
-						currentData->updateDegradation(numIter, param);
+						currentData->updateDegradation(numIter, param, (*model).getDegradationScale());
 						(*((*model).getModel()))[i1].push_back(currentData);
+						slotIndex.setSlot(currentData->getID(), i1, n[i1] - 1);
 						currentData = NULL;
 						countNew++;
     				}
@@ -1362,69 +2319,8 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
     			
     			if (numIter % (*param).K_PARAM == 0)
     			{
-                    // we run the pruning procedure here
-                    long double sumNorms = 0; 
-					long double sumThreshold = (long double)(*param).C_PARAM * (long double)(*param).C_PARAM / ((long double)numIter * (long double)numIter * (*param).LAMBDA_PARAM * (*param).LAMBDA_PARAM);        
-                    vector <long double> weightNorms, sortedWeightNorms;
-                    int numToDelete = 0;  
-                    
-                    // first find the norms of weights
-        			for (unsigned int i = 0; i < sizeOfyLabels; i++)
-					{
-        				for (vector<budgetedVectorAMM*>::iterator vi = (*((*model).getModel()))[i].begin(); vi != (*((*model).getModel()))[i].end(); vi++)
-						{
-							weightNorms.push_back((double) (*(*vi)).getSqrL2norm());
-						}
-					}
-					
-        			// now sort them
-        			sortedWeightNorms = weightNorms;
-        			sort(sortedWeightNorms.begin(), sortedWeightNorms.end());
-        			    
-        			// find how many before threshold is exceeded
-                    for (unsigned int i = 0; i < weightNorms.size(); i++)
-                    {
-                        sumNorms += sortedWeightNorms[i];
-                        if (sumNorms > sumThreshold)
-                           break;
-                        else
-                           numToDelete++;                             
-                    }
-                    
-                    // delete those that should be deleted, with aggregate norm less than the set threshold
-                    int counter = 0;
-                    bool deleted = false;
-                    for (unsigned int i = 0; i < sizeOfyLabels; i++)
-        			{
-        				for (vector<budgetedVectorAMM*>::iterator vi = (*((*model).getModel()))[i].begin(); vi != (*((*model).getModel()))[i].end();)
-                        {
-                            long double currNorm = weightNorms[counter++];
-                            
-                            deleted = false;
-                            for (int j = 0; j < numToDelete; j++)
-                            {
-                                if (currNorm == sortedWeightNorms[j])
-                                {
-									if (n[i] == 1)
-									{
-										svmPrintString("Was about to delete all weights of a class, check the K_PARAM and C_PARAM parameters!\n");
-										break;
-									}
-									
-                                    delete (*vi);
-                                    vi = (*((*model).getModel()))[i].erase(vi);
-        							n[i]--;
-									
-        							countDel++;
-        							deleted = true;
-        							break;
-                                }
-                            }
-                            
-                            if (!deleted)
-                               vi++;
-        				}
-        			}
+                    // we run the pruning procedure here, removing the weights with the smallest norms
+					countDel += pruneWeights(model, &n, numIter, param, &slotIndex);
                 }
     		}
     		timeCalc += clock() - start;
@@ -1495,7 +2391,10 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
 				
                 trainData->saveAssignment(assigns);
 	            delete [] assigns;                
-			}		
+			}
+			
+			// all examples are now assigned to live weights, so the redirects of the pruned weights are no longer needed
+			slotIndex.clearRedirects();
 		}
 		
 		if ((*param).VERBOSE && ((*param).NUM_EPOCHS > 1))
@@ -1504,11 +2403,15 @@ void trainAMMbatch(budgetedData *trainData, parameters *param, budgetedModelAMM
 			svmPrintString(text);
 		}
 	}
+    // fold the degradation scale of the model into the weights, after which the weights can be used outside of training
+    (*model).applyDegradationScale();
     trainData->flushData();
     
     if ((*param).VERBOSE)
     {
         sprintf(text, "*** Training completed in %5.3f seconds.\nNumber of weights deleted: %d\n", (double) timeCalc / (double) CLOCKS_PER_SEC, countDel);
+		svmPrintString(text);
+		sprintf(text, "Number of recomputed weight norms: %d, largest relative norm drift: %.3g\n", (*model).getNumNormResyncs(), (double) (*model).getMaxNormDrift());
 		svmPrintString(text);
 		for (unsigned int i = 0; i < sizeOfyLabels; i++)
 		{
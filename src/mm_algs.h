@@ -37,9 +37,20 @@ class budgetedVectorAMM : public budgetedVector
 		However, instead of degrading each element separately, we can keep degradation level as a single number which is the same for all features, thus avoiding round-off problems and also speeding up the degradation step, which now amounts to a single multiplication operation. 
 		
 		Consequently, the actual feature value of a vector is equal to the value stored in \link array \endlink, multiplied by \link degradation \endlink.
+		
+		Moreover, as all weights of the model are degraded by the same factor at each iteration, during training even this single number is not updated for each weight. Instead, 
+		the degradation is kept relative to the degradation scale of the model, see budgetedModelAMM::numDegradationSteps, and the scale is folded into each weight only once the training is completed.
 	*/	
+	/*! \var unsigned int numNormUpdates
+		\brief Number of incremental updates of \link sqrL2norm \endlink since the norm was last computed exactly.
+		
+		The training updates change the squared norm of a weight by the difference of the squares of the modified elements, which is accumulated in \link sqrL2norm \endlink 
+		instead of computing the norm anew. The round-off errors of the accumulated differences add up, and after \link parameters::NORM_RESYNC_INTERVAL \endlink incremental 
+		updates the norm is recomputed before it is next used for pruning. \sa resyncSqrL2norm, budgetedModelAMM::resyncNorms
+	*/
 	protected:
         long double degradation;
+		unsigned int numNormUpdates;
 		
 	public:
     	/*! \fn budgetedVectorAMM(unsigned int  dim = 0, unsigned int  chnkWght = 0) : budgetedVector(dim, chnkWght)
@@ -50,8 +61,24 @@ class budgetedVectorAMM : public budgetedVector
 		budgetedVectorAMM(unsigned int dim = 0, unsigned int  chnkWght = 0) : budgetedVector(dim, chnkWght)
 		{
 			degradation = 1.0;
+			numNormUpdates = 0;
+		}
+		
+		/*! \fn unsigned int getNumNormUpdates(void)
+			\brief Returns \link numNormUpdates \endlink, the number of incremental updates of the squared norm since it was last computed exactly.
+			\return Number of incremental updates of the squared norm.
+		*/
+		unsigned int getNumNormUpdates(void)
+		{
+			return numNormUpdates;
 		}
 		
+		/*! \fn long double resyncSqrL2norm(void)
+			\brief Recomputes \link sqrL2norm \endlink from the elements of the vector, discarding the round-off errors of the incremental updates.
+			\return Relative difference between the incrementally updated and the recomputed squared norm.
+		*/
+		long double resyncSqrL2norm(void);
+		
 		/*! \fn double getSqrL2norm(void)
 			\brief Returns \link sqrL2norm \endlink, a squared L2-norm of the vector, which accounts for the vector degradation.
 			\return Squared L2-norm of the vector.
@@ -61,17 +88,6 @@ class budgetedVectorAMM : public budgetedVector
 			return (degradation * degradation * sqrL2norm);
 		}
 		
-		/*! \fn void downgrade(long oto)
-			\brief Downgrade the existing weight-vector.
-			\param [in] oto Total number of AMM training iterations so far.
-			
-			Using this function, each training iteration all non-zero weights are pushed closer to 0, to ensure the convergence of the algorithm to the optimal solution.
-		*/
-		void downgrade(long oto)
-		{
-			degradation *= (1.0 - 1.0 / ((long double)oto + 1.0));
-		};
-		
 		/*! \fn long double sqrNorm(void)
 			\brief Calculates a squared norm of the vector, but takes into consideration current degradation of a vector.
 			\return Squared norm of the vector.
@@ -98,42 +114,58 @@ class budgetedVectorAMM : public budgetedVector
 			degradation = deg;
 		}
 		
-		/*! \fn void updateDegradation(unsigned int iteration, parameters *param)
+		/*! \fn void updateDegradation(unsigned int iteration, parameters *param, long double degradationScale = 1.0, unsigned int batchSize = 1)
 			\brief Computes \link degradation \endlink of a vector.
 			\param [in] iteration Training iteration at which the degradation is set, used to compute the degradation value.
 			\param [in] param The parameters of the algorithm.
+			\param [in] degradationScale Current degradation scale of the model, the degradation is stored relative to it. \sa budgetedModelAMM::getDegradationScale
+			\param [in] batchSize Size of the mini-batch the vector was created in, the sub-gradients are averaged over the mini-batch. \sa parameters::MINI_BATCH_SIZE
+		*/
+		void updateDegradation(unsigned int iteration, parameters *param, long double degradationScale = 1.0, unsigned int batchSize = 1)
+		{
+			degradation = 1.0 / (((long double)iteration + 1.0) * (long double)(*param).LAMBDA_PARAM * degradationScale * (long double)batchSize);
+		}
+		
+		/*! \fn void scaleDegradation(long double degradationScale)
+			\brief Multiplies \link degradation \endlink of a vector by the degradation scale of the model, used once the training is completed. \sa budgetedModelAMM::applyDegradationScale
+			\param [in] degradationScale Degradation scale of the model.
 		*/
-		void updateDegradation(unsigned int iteration, parameters *param)
+		void scaleDegradation(long double degradationScale)
 		{
-			degradation = 1.0 / (((long double)iteration + 1.0) * (long double)(*param).LAMBDA_PARAM);
+			degradation *= degradationScale;
 		}
 
-		/*! \fn void updateUsingDataPoint(budgetedData* inputData, unsigned int oto, unsigned int t, int sign, parameters *param)
+		/*! \fn void updateUsingDataPoint(budgetedData* inputData, unsigned int oto, unsigned int t, int sign, parameters *param, long double degradationScale = 1.0, unsigned int batchSize = 1)
 			\brief Updates a weight-vector when misclassification happens.
 			\param [in] inputData Input data from which t-th vector is considered.
 			\param [in] oto Total number of iterations so far.
 			\param [in] t Index of the input vector in the input data.
 			\param [in] sign +1 if the input vector is of the true class, -1 otherwise, specifies how the weights will be updated.
 			\param [in] param The parameters of the algorithm.
+			\param [in] degradationScale Current degradation scale of the model, relative to which \link degradation \endlink is kept. \sa budgetedModelAMM::getDegradationScale
+			\param [in] batchSize Size of the mini-batch the data point belongs to, the update is divided by it so that the sub-gradients are averaged over the mini-batch. \sa parameters::MINI_BATCH_SIZE
 			
 			When we misclassify a data point during training, this function is used to update the existing weight-vector. It brings the true-class weight closer to the misclassified 
 			data point, and to push the winning other-class weight away from the misclassified point according to AMM weight-update equations. The missclassified example used to update
-			an existing weight is located in the input data set loaded to budgetedData.
+			an existing weight is located in the input data set loaded to budgetedData. Only the non-zero features of the data point are visited, and the squared norm of the weight is 
+			updated in the same pass from the old and new values of the modified elements, so that no temporary vector needs to be created for the data point. This is the update used by 
+			all AMM trainers and Pegasos.
 		*/
-		void updateUsingDataPoint(budgetedData* inputData, unsigned int oto, unsigned int t, int sign, parameters *param);
+		void updateUsingDataPoint(budgetedData* inputData, unsigned int oto, unsigned int t, int sign, parameters *param, long double degradationScale = 1.0, unsigned int batchSize = 1);
 		
-		/*! \fn void updateUsingVector(budgetedVectorAMM* otherVector, unsigned int oto, int sign, parameters *param)
+		/*! \fn void updateUsingVector(budgetedVectorAMM* otherVector, unsigned int oto, int sign, parameters *param, long double degradationScale = 1.0)
 			\brief Updates a weight-vector when misclassification happens.
 			\param [in] otherVector Misclassified example used to update the existing weight.
 			\param [in] oto Total number of iterations so far.
 			\param [in] sign +1 if the input vector is of the true class, -1 otherwise, specifies how the weights will be updated.
 			\param [in] param The parameters of the algorithm.
+			\param [in] degradationScale Current degradation scale of the model, relative to which \link degradation \endlink is kept. \sa budgetedModelAMM::getDegradationScale
 			
 			When we misclassify a data point during training, this function is used to update the existing weight-vector. It brings the true-class weight closer to the misclassified 
 			data point, and to push the winning other-class weight away from the misclassified point according to AMM weight-update equations. The missclassified example used to update
 			an existing weight is located in the budgetedVectorAMM object.
 		*/
-		void updateUsingVector(budgetedVectorAMM* otherVector, unsigned int oto, int sign, parameters *param);
+		void updateUsingVector(budgetedVectorAMM* otherVector, unsigned int oto, int sign, parameters *param, long double degradationScale = 1.0);
 		
 		/*! \fn void createVectorUsingDataPoint(budgetedData* inputData, unsigned int oto, unsigned int t, parameters *param)
 			\brief Create new weight from one of the zero-weights.
@@ -148,6 +180,7 @@ class budgetedVectorAMM : public budgetedVector
 		{
 			budgetedVector::createVectorUsingDataPoint(inputData, t, param);    
 			degradation = 1.0 / (((long double)oto + 1.0) * (long double)(*param).LAMBDA_PARAM);
+			numNormUpdates = 0;
 		}
 
 		/*! \fn virtual void createVectorUsingVector(budgetedVectorAMM* existingVector)
@@ -160,6 +193,7 @@ class budgetedVectorAMM : public budgetedVector
 		{
 			budgetedVector::createVectorUsingVector(existingVector);
 			setDegradation(existingVector->degradation);
+			numNormUpdates = existingVector->numNormUpdates;
 		}
 
 		/*! \fn virtual long double linearKernel(unsigned int t, budgetedData* inputData, parameters *param)
@@ -202,8 +236,47 @@ class budgetedModelAMM : public budgetedModel
 	/*! \var vector <vectorOfBudgetVectors> *modelMM
 	\brief Holds AMM batch, AMM online, or PEGASOS models.
 	*/	
+	/*! \var unsigned int numDegradationSteps
+		\brief Number of training iterations at which all weights were degraded, and whose degradation is not yet folded into \link budgetedVectorAMM::degradation \endlink of the weights.
+		
+		At t-th training iteration each weight is degraded by a factor (1 - 1 / (t + 1)), and after T iterations the product of these factors amounts to 1 / (T + 1). Thus, instead of
+		degrading each weight at each iteration, which costs as much as the number of weights in the model, only this counter is increased, and the actual degradation of a weight
+		is equal to its \link budgetedVectorAMM::degradation \endlink multiplied by the degradation scale 1 / (\link numDegradationSteps \endlink + 1). \sa getDegradationScale, applyDegradationScale
+	*/
+	/*! \var vector <float> packedWeights
+		\brief Packed copy of all weights of the model, used for fast computation of the scores when \link parameters::PACKED_WEIGHTS \endlink is set.
+		
+		All weights are stored as columns of a single contiguous, row-major matrix of size (DIMENSION x NUMBER_OF_WEIGHTS), with the weights ordered by class and by their index
+		within the class. A score of a data point is then computed for all weights at once, by adding for each non-zero feature of the data point the corresponding contiguous 
+		row of the matrix multiplied by the feature value, and by finally multiplying the score of each column by \link packedDegradations \endlink. \sa packWeights, computePackedScores
+	*/
+	/*! \var vector <double> packedDegradations
+		\brief Degradation of each column of \link packedWeights \endlink. 
+		
+		It is applied to the score of a column instead of being folded into the matrix elements, since rounding of the folded elements would break exact ties between the 
+		scores, and the predictions would no longer be identical to the ones computed by budgetedVectorAMM::linearKernel().
+	*/
+	/*! \var bool packedWeightsValid
+		\brief Indicates that \link packedWeights \endlink reflects the current weights; it is reset whenever the weights change, and the packed matrix is rebuilt lazily when next needed.
+	*/
+	/*! \var unsigned int numPackedWeights
+		\brief Number of columns of \link packedWeights \endlink, equal to the total number of weights of the model when the matrix was built.
+	*/
+	/*! \var unsigned int numNormResyncs
+		\brief Number of weights whose squared norms were recomputed by \link resyncNorms \endlink during training.
+	*/
+	/*! \var long double maxNormDrift
+		\brief Largest relative difference between the incrementally updated and the recomputed squared norm of a weight, found by \link resyncNorms \endlink during training.
+	*/
 	protected:
 		vector <vectorOfBudgetVectors> *modelMM;
+		unsigned int numDegradationSteps;
+		vector <float> packedWeights;
+		vector <double> packedDegradations;
+		unsigned int numPackedWeights;
+		bool packedWeightsValid;
+		unsigned int numNormResyncs;
+		long double maxNormDrift;
 		
 	public:		
 		/*! \fn budgetedModelAMM(void)
@@ -212,8 +285,111 @@ class budgetedModelAMM : public budgetedModel
 		budgetedModelAMM(void)
 		{
 			modelMM = new vector <vectorOfBudgetVectors>;
+			numDegradationSteps = 0;
+			packedWeightsValid = false;
+			numPackedWeights = 0;
+			numNormResyncs = 0;
+			maxNormDrift = 0.0;
+		};
+		
+		/*! \fn void invalidatePackedWeights(void)
+			\brief Marks \link packedWeights \endlink as outdated, should be called whenever the weights of the model are modified.
+		*/
+		void invalidatePackedWeights(void)
+		{
+			packedWeightsValid = false;
 		};
 		
+		/*! \fn void packWeights(parameters *param)
+			\brief Builds \link packedWeights \endlink from the current weights of the model.
+			\param [in] param The parameters of the algorithm.
+		*/
+		void packWeights(parameters *param);
+		
+		/*! \fn void computePackedScores(unsigned int t, budgetedData *inputData, parameters *param, vector <double> *weightScores)
+			\brief Computes the scores of all weights of the model for a data point, using \link packedWeights \endlink which is rebuilt first if the weights changed.
+			\param [in] t Index of the input vector in the input data.
+			\param [in] inputData Input data from which t-th vector is considered.
+			\param [in] param The parameters of the algorithm.
+			\param [out] weightScores Scores of all weights, ordered by class and by the index of the weight within the class.
+			
+			The scores are equal to the ones computed by budgetedVectorAMM::linearKernel() for each weight separately, up to a round-off error.
+		*/
+		void computePackedScores(unsigned int t, budgetedData *inputData, parameters *param, vector <double> *weightScores);
+		
+		/*! \fn void downgrade(unsigned int oto)
+			\brief Downgrades all weights of the model, in constant time.
+			\param [in] oto Total number of training iterations so far, the weights are assumed to be degraded at each of the iterations.
+			
+			Using this function, each training iteration all non-zero weights are pushed closer to 0, to ensure the convergence of the algorithm to the optimal solution. \sa numDegradationSteps
+		*/
+		void downgrade(unsigned int oto)
+		{
+			numDegradationSteps = oto;
+			packedWeightsValid = false;
+		};
+		
+		/*! \fn long double getDegradationScale(void)
+			\brief Returns the degradation scale of the model, by which \link budgetedVectorAMM::degradation \endlink of each weight needs to be multiplied during training.
+			\return Degradation scale of the model. \sa numDegradationSteps
+		*/
+		long double getDegradationScale(void)
+		{
+			return (1.0L / ((long double) numDegradationSteps + 1.0L));
+		};
+		
+		/*! \fn void applyDegradationScale(void)
+			\brief Folds the degradation scale of the model into \link budgetedVectorAMM::degradation \endlink of each weight, and resets the scale; called once the training is completed.
+		*/
+		void applyDegradationScale(void)
+		{
+			long double degradationScale = getDegradationScale();
+			for (unsigned int i = 0; i < (*modelMM).size(); i++)
+				for (unsigned int j = 0; j < (*modelMM)[i].size(); j++)
+					(*modelMM)[i][j]->scaleDegradation(degradationScale);
+			numDegradationSteps = 0;
+			packedWeightsValid = false;
+		};
+		
+		/*! \fn void resyncNorms(parameters *param)
+			\brief Recomputes the squared norms of the weights that were incrementally updated at least \link parameters::NORM_RESYNC_INTERVAL \endlink times since their norms were last computed.
+			\param [in] param The parameters of the algorithm.
+			
+			Called before the norms are used for pruning. Checking the weights costs O(W) for W weights, while recomputing a norm costs O(DIMENSION) and is done only once 
+			per \link parameters::NORM_RESYNC_INTERVAL \endlink updates of the weight, which bounds the accumulated round-off error of the norms at a small amortized cost. 
+			The number of the recomputed norms and the largest relative drift they had are kept as diagnostics. \sa getNumNormResyncs, getMaxNormDrift
+		*/
+		void resyncNorms(parameters *param);
+		
+		/*! \fn unsigned int getNumNormResyncs(void)
+			\brief Returns \link numNormResyncs \endlink, the number of weights whose squared norms were recomputed during training.
+			\return Number of recomputed norms.
+		*/
+		unsigned int getNumNormResyncs(void)
+		{
+			return numNormResyncs;
+		};
+		
+		/*! \fn long double getMaxNormDrift(void)
+			\brief Returns \link maxNormDrift \endlink, the largest relative drift of an incrementally updated squared norm found during training.
+			\return Largest relative drift of a squared norm.
+		*/
+		long double getMaxNormDrift(void)
+		{
+			return maxNormDrift;
+		};
+		
+		/*! \fn void averageModels(vector <budgetedModelAMM*> *models, vector <unsigned int> *numShared)
+			\brief Replaces the weights of the model by the average of several models, which were all trained starting from a copy of this model.
+			\param [in] models Models that are averaged, all with the same degradation scale.
+			\param [in] numShared Number of weights per class that the models inherited from this model, found at the start of the weights of each class.
+			
+			The inherited weights are matched by their class and by their index within the class, and each is replaced by the average of its copies in all models. A weight 
+			that was added to one of the models (i.e., a new or a cloned weight) has no counterpart in the other models, and is added to this model with its degradation 
+			divided by the number of models, as if it was averaged with zero-weights. The model also takes over the degradation scale of the averaged models.
+		*/
+		void averageModels(vector <budgetedModelAMM*> *models, vector <unsigned int> *numShared);
+		
 		/*! \fn ~budgetedModelAMM(void)
 			\brief Destructor, cleans up memory taken by AMM.
 		*/	
@@ -239,6 +415,7 @@ class budgetedModelAMM : public budgetedModel
 			for (unsigned int i = 0; i < (*modelMM).size(); i++)
 				for (unsigned int j = 0; j < (*modelMM)[i].size(); j++)
 					(*modelMM)[i][j]->extendDimensionality(newDim, param);
+			packedWeightsValid = false;
 		};
 		
 		/*! \fn bool saveToTextFile(const char *filename, vector <int>* yLabels, parameters *param)